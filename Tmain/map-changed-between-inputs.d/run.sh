@@ -0,0 +1,14 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+# The map changed with an option given after input files must be used
+# for the input files given after the option.
+${CTAGS} --quiet --options=NONE --print-language \
+	 a.foo GNUmakefile.local x.sh.in \
+	 --map-C=+.foo a.foo \
+	 --map-Make=+'(GNUmakefile.local)' GNUmakefile.local \
+	 --map-Sh=-.in x.sh.in \
+	 --map-Sh=+'(*.sh.in)' x.sh.in \
+	 --langmap=C:.c a.foo
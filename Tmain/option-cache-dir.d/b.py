@@ -0,0 +1,5 @@
+def gamma():
+    pass
+
+class Delta:
+    pass
@@ -0,0 +1,57 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+D=$BUILDDIR/ctags-tmain-cache-dir-$$
+
+O="--quiet --options=NONE --pseudo-tags=TAG_FILE_SORTED --pseudo-tags=+TAG_KIND_DESCRIPTION --sort=no"
+
+rm -rf $D
+mkdir -p $D/cache
+cp a.c b.py $D
+cd $D
+
+cached()
+{
+	grep '^using the cached tags' | sort
+}
+
+${CTAGS} $O --cache-dir=cache -o tags a.c b.py
+echo '# cold'
+cat tags
+
+${CTAGS} $O --cache-dir=cache -V -o tags a.c b.py 2>&1 | cached
+echo '# warm'
+cat tags
+${CTAGS} $O -o full a.c b.py
+cmp tags full && echo '# the same as parsing'
+
+${CTAGS} $O --cache-dir=cache -V -o tags b.py a.c 2>&1 | cached
+${CTAGS} $O -o full b.py a.c
+cmp tags full && echo '# the same as parsing in the other order'
+
+printf 'int epsilon;\n' >> a.c
+${CTAGS} $O --cache-dir=cache -V -o tags a.c b.py 2>&1 | cached
+echo '# a.c is modified'
+cat tags
+
+${CTAGS} $O --cache-dir=cache --fields=+K -V -o tags a.c b.py 2>&1 | cached
+echo '# --fields is changed'
+
+# Record a data length longer than the entry file. The offset of the
+# length is the one in cacheHeader of main/cache.c; if it moves, the
+# other field written here doesn't produce the messages expected.
+for e in $(find cache -type f); do
+	printf '\377\377\377\377\377\377\377\177' | dd of=$e bs=1 seek=80 conv=notrunc 2>/dev/null
+done
+${CTAGS} $O --cache-dir=cache --fields=+K -V -o tags a.c b.py 2>&1 \
+	| grep -e '^using the cached tags' -e '^ignoring the cache entry' | sort
+${CTAGS} $O --fields=+K -o full a.c b.py
+cmp tags full && echo '# broken entries are ignored'
+
+${CTAGS} $O --cache-dir=a.c a.c 2>/dev/null
+echo "# not a directory: $?"
+
+cd ..
+rm -rf $D
@@ -0,0 +1,32 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+. ../utils.sh
+
+O="--quiet --options=NONE --languages=C --fields=-T"
+
+rm -rf tree
+mkdir -p tree/src/gen tree/build/obj tree/lib
+for f in src/a.c src/b.c src/a.min.c src/gen/x.c src/gen/y.c build/c.c build/obj/d.c lib/e.c lib/a.c; do
+	echo "int v;" > tree/$f
+done
+
+# Each kind of pattern: a literal, a suffix, and a glob.
+for x in 'a.c' '*.min.c' '*.c' 'tree/src/g*/?.c' '[ab].c' 'tree/lib/e.c' '*/gen/*'; do
+	echo "# --exclude=$x"
+	${CTAGS} $O -R --exclude="$x" -o - tree | cut -f2 | sort
+done
+
+echo '# --exclude=tree/build/* --exclude=*.c --exclude-exception=tree/build/obj/*'
+${CTAGS} $O -R --exclude='tree/build/*' --exclude='*.c' --exclude-exception='tree/build/obj/*' \
+		 -o - tree | cut -f2 | sort
+
+# The files in a directory excluded by a pattern ending with "*" are
+# not read.
+echo '# --exclude=tree/build/* --verbose'
+${CTAGS} $O -R --exclude='tree/build/*' --verbose -o - tree 2>&1 | grep '^excluding'
+
+rm -rf tree
+exit 0
@@ -0,0 +1,54 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+. ../utils.sh
+
+if ! type git > /dev/null 2>&1; then
+	skip "no git"
+fi
+
+CTAGS=$(cd $(dirname $CTAGS); pwd)/$(basename $CTAGS)
+O="--quiet --options=NONE --languages=C --fields=-T -o tags --update --verbose"
+
+run()
+{
+	echo "# $1"
+	${CTAGS} $O --git-changes=manifest 2>&1 | grep -e 'tracked files;' -e '^removed'
+	grep -v '^!' tags | cut -f1,2
+}
+
+rm -rf tree
+mkdir -p tree/sub
+cd tree
+git init -q .
+echo 'int a;' > a.c
+echo 'int b;' > b.c
+echo 'int c;' > sub/c.c
+# Older than the index; the files are clean.
+touch -t 202001010000 a.c b.c sub/c.c
+git add a.c b.c sub/c.c
+
+run 'no manifest'
+run 'no change'
+
+echo 'int b2;' >> b.c
+git rm -q -f sub/c.c
+run 'b.c modified, sub/c.c removed'
+
+# Only the modification time differs from the one in the index.
+touch -t 202101010000 a.c
+git add a.c
+run 'a.c touched'
+
+# The tags of the unchanged files would be lost without --update.
+echo '# no --update'
+echo 'int b3;' >> b.c
+${CTAGS} --quiet --options=NONE -o tags --git-changes=manifest 2>&1
+echo "exit status: $?"
+run 'b.c modified after the failure'
+
+cd ..
+rm -rf tree
+exit 0
@@ -0,0 +1,5 @@
+def b1():
+    pass
+
+class b2:
+    pass
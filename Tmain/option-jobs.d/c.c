@@ -0,0 +1,2 @@
+#define C1 1
+static int c2;
@@ -0,0 +1,4 @@
+d1()
+{
+	:
+}
@@ -0,0 +1,4 @@
+class E1
+  def e2
+  end
+end
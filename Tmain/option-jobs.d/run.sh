@@ -0,0 +1,22 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+. ../utils.sh
+
+is_feature_available ${CTAGS} jobs
+
+O="--quiet --options=NONE --extras=+p --pseudo-tags=TAG_KIND_DESCRIPTION --fields=+K --sort=no"
+
+echo '# --jobs=3'
+${CTAGS} $O --jobs=3 -o - a.c b.py c.c d.sh e.rb
+
+echo '# the same as --jobs=1'
+${CTAGS} $O --jobs=1 -o - a.c b.py c.c d.sh e.rb > serial.tags
+${CTAGS} $O --jobs=3 -o - a.c b.py c.c d.sh e.rb > jobs.tags
+cmp serial.tags jobs.tags && echo same
+rm -f serial.tags jobs.tags
+
+echo '# options between input files'
+${CTAGS} $O --jobs=2 -o - a.c b.py --kinds-C=-f c.c a.c
@@ -0,0 +1,2 @@
+int c1;
+/* padding to make this file larger than the other ones ..................... */
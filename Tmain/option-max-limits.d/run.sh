@@ -0,0 +1,36 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+. ../utils.sh
+
+O="--quiet --options=NONE --sort=no --pseudo-tags=-TAG_PROGRAM_VERSION"
+
+echo '# max-tags-per-file'
+${CTAGS} $O --max-tags-per-file=2 -o - a.c b.c c.c
+
+echo '# max-file-size'
+${CTAGS} $O --max-file-size=64 -o - a.c b.c c.c
+
+echo '# no limit'
+${CTAGS} $O --max-tags-per-file=0 --max-file-size=0 --max-parse-time=0 -o - a.c b.c c.c
+
+# The tags written for a skipped file are removed from the tag file
+# together with the pseudo tags made for it.
+${CTAGS} $O --max-tags-per-file=2 -o serial.tags a.c b.c c.c 2> /dev/null
+${CTAGS} $O -o expected.tags b.c c.c
+cmp serial.tags expected.tags || echo 'tags of a skipped file are left'
+
+if ${CTAGS} --list-features | grep -q '^jobs'; then
+	${CTAGS} $O --jobs=2 --max-tags-per-file=2 -o jobs.tags a.c b.c c.c 2> /dev/null
+	cmp jobs.tags expected.tags || echo 'tags of a skipped file are left with --jobs'
+fi
+
+echo '# invalid parameters'
+${CTAGS} $O --max-file-size=1x -o - b.c
+${CTAGS} $O --max-parse-time=-1 -o - b.c
+${CTAGS} $O --max-tags-per-file=n -o - b.c
+
+rm -f serial.tags expected.tags jobs.tags
+exit 0
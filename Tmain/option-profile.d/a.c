@@ -0,0 +1,2 @@
+int a1 (void) { return 0; }
+struct a2 { int m; };
@@ -0,0 +1,34 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+. ../utils.sh
+
+O="--quiet --options=NONE --sort=no"
+
+# Times vary from run to run.
+mask_times()
+{
+	sed -e 's/"\(wall\|cpu\|other\|guess\|parse\|regex\|promise\|write\)":[0-9.]*/"\1":T/g' "$@"
+}
+
+echo '# records'
+${CTAGS} $O --profile=profile.json -o - a.c b.py c.unknown 2> summary.txt
+mask_times profile.json
+
+echo '# summary'
+sed -n -e '1s/, [0-9.]* seconds (cpu [0-9.]* seconds)//p' summary.txt
+awk '/^slowest files:/,/^$/ { if ($1 ~ /^[0-9.]+$/) print $NF }' summary.txt | sort
+awk '/^parsers:/ { p = 1; next } p { print $1, $2 }' summary.txt
+
+if ${CTAGS} --list-features | grep -q '^jobs'; then
+	${CTAGS} $O --profile=serial.json -o /dev/null a.c b.py c.unknown 2> /dev/null
+	${CTAGS} $O --jobs=2 --profile=jobs.json -o /dev/null a.c b.py c.unknown 2> /dev/null
+	mask_times serial.json > serial.masked
+	mask_times jobs.json > jobs.masked
+	cmp serial.masked jobs.masked || echo 'records differ with --jobs'
+	rm -f serial.json jobs.json serial.masked jobs.masked
+fi
+
+rm -f profile.json summary.txt
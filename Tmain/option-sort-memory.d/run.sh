@@ -0,0 +1,48 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+D=$BUILDDIR/ctags-tmain-sort-memory-$$
+
+. ../utils.sh
+
+is_feature_available ${CTAGS} internal-sort
+
+O="--quiet --options=NONE --pseudo-tags= --fields=+n"
+
+rm -rf $D
+mkdir -p $D
+cd $D
+
+# About 3000 tags with duplicates, and names different only in case.
+i=0
+while [ $i -lt 1000 ]; do
+	echo "int v$i;"
+	echo "int V$i;"
+	echo "int v$i;"
+	i=$((i + 1))
+done > input.c
+cp input.c input.h
+
+${CTAGS} $O --sort=no -o unsorted input.c input.h
+for s in yes foldcase; do
+	f=
+	[ $s = foldcase ] && f=-f
+	LC_ALL=C sort -u $f unsorted > expected
+	for m in 64k 64m; do
+		${CTAGS} $O --sort=$s --sort-memory=$m -o tags input.c input.h
+		cmp expected tags && echo "--sort=$s --sort-memory=$m: the same as sort -u${f:+ $f}"
+	done
+done
+
+${CTAGS} $O --sort-memory=1x -o tags input.c 2>/dev/null
+echo "invalid size: $?"
+
+for m in 99999999999g 99999999999999999999 -1k; do
+	${CTAGS} $O --sort-memory=$m -o tags input.c 2>/dev/null
+	echo "$m: $?"
+done
+
+cd ..
+rm -rf $D
@@ -0,0 +1,6 @@
+int alpha;
+int Alpha;
+int ALPHA_BETA;
+int alphabet (void) { return 0; }
+struct beta { int alpha; };
+static int gamma_;
@@ -0,0 +1,68 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+READTAGS=$3
+D=$BUILDDIR/ctags-tmain-tag-index-$$
+
+. ../utils.sh
+
+if ! [ -x "${READTAGS}" ]; then
+	skip "no readtags"
+fi
+
+O="--quiet --options=NONE --pseudo-tags= --fields=-T"
+
+lookup()
+{
+	for opts in "" "-i" "-p" "-i -p" "-s0" "-s0 -i -p"; do
+		echo "## readtags $opts $1"
+		${READTAGS} -t tags $opts - "$1"
+	done
+}
+
+rm -rf $D
+mkdir -p $D
+cp input.c $D
+cd $D
+
+${CTAGS} $O --tag-index input.c
+[ -f tags.idx ] && echo '# tags.idx is written'
+lookup alpha > indexed.txt
+lookup gamma_ >> indexed.txt
+lookup x >> indexed.txt
+cat indexed.txt
+
+mv tags.idx saved.idx
+lookup alpha > plain.txt
+lookup gamma_ >> plain.txt
+lookup x >> plain.txt
+cmp indexed.txt plain.txt && echo '# the same as without the index'
+lookup alpha > plain.txt
+
+# A stale index must be ignored.
+cp saved.idx tags.idx
+echo 'zeta	input.c	/^int zeta;$/;"	v' >> tags
+lookup zeta
+
+# A broken index must be ignored.
+printf 'ctagsidx' > tags.idx
+lookup alpha | cmp - plain.txt && echo '# a broken index is ignored'
+
+# An index of a tag file replaced with another one of the same size
+# and in the same second must be ignored.
+${CTAGS} $O --tag-index input.c
+sed -e 's/^alpha\t/omega\t/' tags > tags.new
+mv tags.new tags
+lookup omega
+
+# Rewriting the tag file without --tag-index removes the index.
+${CTAGS} $O input.c
+[ -f tags.idx ] || echo '# tags.idx is removed'
+
+${CTAGS} $O --tag-index -o - input.c 2>&1 > /dev/null
+echo "# stdout: $?"
+
+cd ..
+rm -rf $D
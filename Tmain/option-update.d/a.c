@@ -0,0 +1,2 @@
+int alpha;
+int beta (void) { return 0; }
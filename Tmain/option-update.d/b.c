@@ -0,0 +1,2 @@
+int gamma;
+int Delta;
@@ -0,0 +1,2 @@
+def zeta():
+  pass
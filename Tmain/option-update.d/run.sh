@@ -0,0 +1,39 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+D=$BUILDDIR/ctags-tmain-update-$$
+
+O="--quiet --options=NONE --pseudo-tags=TAG_FILE_SORTED"
+
+rm -rf $D
+mkdir -p $D
+cp a.c b.c c.py $D
+cd $D
+
+${CTAGS} $O a.c b.c c.py
+echo '# initial'
+cat tags
+
+printf 'int alpha2;\nint BETA (void) { return 0; }\n' > a.c
+${CTAGS} $O --update a.c
+echo '# a.c is updated'
+cat tags
+${CTAGS} $O -o full a.c b.c c.py
+cmp tags full && echo '# the same as rebuilding'
+
+rm b.c
+${CTAGS} $O --update b.c 2>/dev/null
+echo '# b.c is removed'
+cat tags
+
+${CTAGS} $O --update --sort=no c.py
+echo '# with --sort=no'
+cat tags
+
+${CTAGS} $O --update -o - c.py 2>/dev/null
+echo "# stdout: $?"
+
+cd ..
+rm -rf $D
@@ -0,0 +1,51 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+. ../utils.sh
+
+O="--quiet --options=NONE --languages=C --fields=-T"
+
+rm -rf tree
+mkdir -p tree/.git/info tree/src/gen tree/src/keep tree/build tree/doc/build
+for f in a.c b.c x.o.c src/a.c src/gen/g.c src/keep/k.c src/keep/l.c \
+		 build/c.c doc/build/d.c doc/e.c doc/f.c; do
+	echo "int v;" > tree/$f
+done
+
+# A pattern without a slash matches at any level, a pattern with one
+# is anchored, "name/" matches only a directory, and "!" re-includes.
+cat > tree/.gitignore <<IGNORE
+# comment
+*.o.c
+/build/
+src/**/g.c
+doc/?.c
+!doc/e.c
+IGNORE
+printf 'k.c\n' > tree/src/.gitignore
+printf '!k.c\n' > tree/src/keep/.ignore
+printf 'b.c\n' > tree/.git/info/exclude
+
+echo '# --use-ignore-files=no'
+${CTAGS} $O -R -o - tree | cut -f2 | sort
+
+echo '# --use-ignore-files'
+${CTAGS} $O -R --use-ignore-files -o - tree | cut -f2 | sort
+
+# The ignore files in the parent directories of a directory given on
+# the command line are applied, too.
+echo '# --use-ignore-files tree/doc'
+${CTAGS} $O -R --use-ignore-files -o - tree/doc | cut -f2 | sort
+
+# A file given on the command line is not affected.
+echo '# --use-ignore-files tree/b.c'
+${CTAGS} $O -R --use-ignore-files -o - tree/b.c | cut -f2 | sort
+
+# An ignored directory is not read.
+echo '# --use-ignore-files --verbose'
+${CTAGS} $O -R --use-ignore-files --verbose -o - tree 2>&1 | grep '(ignore files)' | sort
+
+rm -rf tree
+exit 0
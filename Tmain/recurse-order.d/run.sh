@@ -0,0 +1,51 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+. ../utils.sh
+
+O="--quiet --options=NONE --sort=no --languages=C --fields=-T"
+
+# The directories are read ahead in threads; the tags must be in the
+# order the recursion visits the files, which is the order find(1) lists
+# them.
+rm -rf tree
+for i in 1 2 3 4 5 6 7 8; do
+	for j in 1 2 3 4 5 6 7 8; do
+		mkdir -p tree/d$i/e$j/f
+		echo "int v$i$j;" > tree/d$i/e$j/a.c
+		echo "int w$i$j;" > tree/d$i/e$j/f/b.c
+	done
+	echo "int u$i;" > tree/d$i/c.c
+done
+ln -s ../d1 tree/d2/link
+ln -s . tree/d3/loop
+ln -s nowhere tree/d4/dangling
+
+echo '# --links=no'
+${CTAGS} $O --links=no -R -o recursed.tags tree
+find tree -name '*.c' > files.txt
+${CTAGS} $O -L files.txt -o listed.tags
+cmp recursed.tags listed.tags && echo same
+
+echo '# --links=yes'
+${CTAGS} $O --links=yes -R -o recursed.tags tree 2>&1 | sed -e 's/ : .*//'
+find -L tree -name '*.c' 2> /dev/null | grep -v '^tree/d3/loop/' > files.txt
+${CTAGS} $O -L files.txt -o listed.tags
+cmp recursed.tags listed.tags && echo same
+
+echo '# --maxdepth=2 --links=no'
+${CTAGS} $O --links=no --maxdepth=2 -R -o recursed.tags tree
+find tree -maxdepth 2 -name '*.c' > files.txt
+${CTAGS} $O -L files.txt -o listed.tags
+cmp recursed.tags listed.tags && echo same
+
+echo '# --exclude=f --links=no'
+${CTAGS} $O --links=no --exclude=f -R -o recursed.tags tree
+find tree -name f -prune -o -name '*.c' -print > files.txt
+${CTAGS} $O -L files.txt -o listed.tags
+cmp recursed.tags listed.tags && echo same
+
+rm -rf tree files.txt recursed.tags listed.tags
+exit 0
@@ -316,13 +316,17 @@ static void deleteTagFileX (tagFileX *fileX)
 
 }
 
-static tagFileX *openTagFileX  (tagFileX *fileX)
+static tagFileX *openTagFileX  (tagFileX *fileX, bool mapped)
 {
-	fileX->tagFile = tagsOpen (fileX->fileName, &fileX->info);
+	fileX->tagFile = mapped
+		? tagsOpenMapped (fileX->fileName, &fileX->info)
+		: tagsOpen (fileX->fileName, &fileX->info);
 	return fileX;
 }
 
-static tagFileX *openTags (struct inputSpec *inputSpec)
+/* Mapping the tag file is for reading all the lines; a lookup reads
+ * only a few of them. */
+static tagFileX *openTags (struct inputSpec *inputSpec, bool mapped)
 {
 	tagFileX *fileX;
 
@@ -365,7 +369,7 @@ static tagFileX *openTags (struct inputSpec *inputSpec)
 	else
 		fileX = makeTagFileX(inputSpec->tagFileName);
 
-	return openTagFileX (fileX);
+	return openTagFileX (fileX, mapped);
 }
 
 static int hasPsuedoTag (tagFile *const file,
@@ -384,7 +388,7 @@ static void findTag (struct inputSpec *inputSpec,
 {
 	tagEntry entry;
 	int err = 0;
-	tagFileX *const fileX = openTags (inputSpec);
+	tagFileX *const fileX = openTags (inputSpec, false);
 	if (fileX->tagFile == NULL || !fileX->info.status.opened)
 	{
 		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
@@ -440,7 +444,7 @@ static void listTags (struct inputSpec* inputSpec, bool pseudoTags, tagPrintOpti
 {
 	tagEntry entry;
 	int err = 0;
-	tagFileX *const fileX = openTags (inputSpec);
+	tagFileX *const fileX = openTags (inputSpec, true);
 	if (fileX->tagFile == NULL || !fileX->info.status.opened)
 	{
 		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
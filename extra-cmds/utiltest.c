@@ -13,7 +13,9 @@
 #include "numarray.h"
 #include "routines.h"
 #include "vstring.h"
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 static void test_fname_absolute(void)
 {
@@ -235,6 +237,159 @@ static void test_htable_grow(void)
 	hashTableDelete(htable);
 }
 
+static bool collect_chain (const void *key, void *value, void *user_data)
+{
+	vString *vstr = user_data;
+	vStringCatS (vstr, value);
+	return true;
+}
+
+static void test_htable_chain(void)
+{
+	hashTable *htable = hashTableNew (3, hashCstrhash, hashCstreq, eFree, NULL);
+	vString *vstr = vStringNew ();
+	int i;
+	char keyBuf[20];
+
+	/* Fill the table with other keys to make long runs. */
+	for (i = 0; i < 100; ++i)
+	{
+		snprintf(keyBuf, sizeof(keyBuf), "str_%d", i);
+		hashTablePutItem (htable, eStrdup(keyBuf), "-");
+	}
+
+	hashTablePutItem (htable, eStrdup("a"), "1");
+	hashTablePutItem (htable, eStrdup("b"), "x");
+	hashTablePutItem (htable, eStrdup("a"), "2");
+	hashTablePutItem (htable, eStrdup("a"), "3");
+
+	TEST_CHECK (hashTableCountItem (htable) == 104);
+	TEST_CHECK (strcmp (hashTableGetItem (htable, "a"), "3") == 0);
+	TEST_CHECK (hashTableForeachItemOnChain (htable, "a", collect_chain, vstr));
+	TEST_CHECK (strcmp (vStringValue (vstr), "321") == 0);
+
+	/* The order of the items must be kept while growing. */
+	for (i = 100; i < 1000; ++i)
+	{
+		snprintf(keyBuf, sizeof(keyBuf), "str_%d", i);
+		hashTablePutItem (htable, eStrdup(keyBuf), "-");
+	}
+	vStringClear (vstr);
+	hashTableForeachItemOnChain (htable, "a", collect_chain, vstr);
+	TEST_CHECK (strcmp (vStringValue (vstr), "321") == 0);
+
+	TEST_CHECK (hashTableDeleteItem (htable, "a") == true);
+	TEST_CHECK (strcmp (hashTableGetItem (htable, "a"), "2") == 0);
+	vStringClear (vstr);
+	hashTableForeachItemOnChain (htable, "a", collect_chain, vstr);
+	TEST_CHECK (strcmp (vStringValue (vstr), "21") == 0);
+
+	TEST_CHECK (hashTableDeleteItem (htable, "a") == true);
+	TEST_CHECK (hashTableDeleteItem (htable, "a") == true);
+	TEST_CHECK (hashTableDeleteItem (htable, "a") == false);
+	TEST_CHECK (hashTableGetItem (htable, "a") == NULL);
+	TEST_CHECK (strcmp (hashTableGetItem (htable, "b"), "x") == 0);
+
+	vStringDelete (vstr);
+	hashTableDelete(htable);
+}
+
+static void test_htable_delete(void)
+{
+	hashTable *htable = hashTableNew (3, hashInthash, hashInteq, NULL, NULL);
+	int keys[4096];
+	int i;
+
+	for (i = 0; i < 4096; ++i)
+	{
+		keys[i] = i * 64;
+		hashTablePutItem (htable, keys + i, HT_INT_TO_PTR(i + 1));
+	}
+	for (i = 0; i < 4096; i += 2)
+		TEST_CHECK (hashTableDeleteItem (htable, keys + i));
+
+	TEST_CHECK (hashTableCountItem (htable) == 2048);
+	for (i = 0; i < 4096; ++i)
+	{
+		void *v = hashTableGetItem (htable, keys + i);
+		if (!TEST_CHECK (v == ((i % 2)? HT_INT_TO_PTR(i + 1): NULL)))
+			TEST_MSG ("key: %d", keys[i]);
+	}
+
+	hashTableClear (htable);
+	TEST_CHECK (hashTableCountItem (htable) == 0);
+	TEST_CHECK (hashTableGetItem (htable, keys + 1) == NULL);
+	hashTableDelete(htable);
+}
+
+/* A micro benchmark putting, getting and deleting string keys.
+ * Print the time taken for tables of two sizes. */
+static double htable_bench_run (char **keys, int nkeys, int rounds,
+								unsigned long *found)
+{
+	clock_t start = clock ();
+	int i, r;
+
+	for (r = 0; r < rounds; ++r)
+	{
+		hashTable *htable = hashTableNew (7, hashCstrhash, hashCstreq, NULL, NULL);
+
+		for (i = 0; i < nkeys; ++i)
+			hashTablePutItem (htable, keys[i], keys[i]);
+		for (i = 0; i < nkeys; ++i)
+		{
+			/* Visit the keys in an order different from putting them.
+			 * Half of the lookups miss. */
+			int j = (int)(((unsigned long)i * 7919) % nkeys);
+			if (hashTableHasItem (htable, keys[j] + ((j % 2)? 1: 0)))
+				(*found)++;
+		}
+		for (i = 0; i < nkeys; i += 4)
+			hashTableDeleteItem (htable, keys[i]);
+		hashTableDelete (htable);
+	}
+	return (double)(clock () - start) / CLOCKS_PER_SEC;
+}
+
+/* This is a benchmark rather than a test; it runs only if UTILTEST_BENCH
+ * is set in the environment, as "make bench" does. */
+static void test_htable_bench(void)
+{
+	enum { nkeys = 100000 };
+	static const int sizes [] = { 50, nkeys };
+	char **keys;
+	char keyBuf[32];
+	int i;
+
+	if (getenv ("UTILTEST_BENCH") == NULL)
+		return;
+
+	keys = xMalloc (nkeys, char *);
+
+	/* Scramble the numbers in the keys. Sequential keys have sequential
+	 * hash values, which hides the cost of cache misses. */
+	for (i = 0; i < nkeys; ++i)
+	{
+		snprintf(keyBuf, sizeof(keyBuf), "identifier_%x",
+				 (unsigned int)i * 2654435761U);
+		keys[i] = eStrdup (keyBuf);
+	}
+
+	for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); ++i)
+	{
+		int rounds = 2000000 / sizes[i];
+		unsigned long found = 0;
+		double sec = htable_bench_run (keys, sizes[i], rounds, &found);
+
+		TEST_CHECK (found == (unsigned long)sizes[i] / 2 * rounds);
+		printf ("  %d items x %d tables: %.3f sec\n", sizes[i], rounds, sec);
+	}
+
+	for (i = 0; i < nkeys; ++i)
+		eFree (keys[i]);
+	eFree (keys);
+}
+
 static void test_numarray(void)
 {
 	intArray *a = intArrayNew ();
@@ -330,6 +485,9 @@ TEST_LIST = {
    { "fname/relative",   test_fname_relative   },
    { "htable/update",    test_htable_update    },
    { "htable/grow",      test_htable_grow      },
+   { "htable/chain",     test_htable_chain     },
+   { "htable/delete",    test_htable_delete    },
+   { "htable/bench",     test_htable_bench     },
    { "numarray",         test_numarray         },
    { "routines/strrstr", test_routines_strrstr },
    { "vstring/ncats",    test_vstring_ncats    },
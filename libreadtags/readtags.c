@@ -14,7 +14,12 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <errno.h>
+#include <stdint.h>
 #include <sys/types.h>  /* to declare off_t */
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 #include "readtags.h"
 
@@ -23,6 +28,58 @@
 */
 #define TAB '\t'
 
+/*
+ * The index of a tag file
+ *
+ * ctags --tag-index writes "<tag file>.idx" next to a tag file. When
+ * the index is found at tagsOpen () and it is valid, tagsFind () and
+ * tagsFindNext () look up tags in the index, and read only the lines
+ * of the matched tags from the tag file.
+ *
+ * All numbers are little endian.
+ *
+ *   header (80 bytes):
+ *     char     magic[8]           "ctagsidx"
+ *     uint32   version            2
+ *     uint32   flags              0
+ *     uint64   tag file size
+ *     uint64   tag file mtime     in seconds
+ *     uint64   entry count        N
+ *     uint64   slot count         S, a power of 2
+ *     uint64   name pool size     P
+ *     uint64   tag file mtime     nanoseconds in the second (0 on Windows)
+ *     uint64   tag file inode     (0 on Windows)
+ *     uint64   tag file device
+ *   entries (N * 16 bytes), one for each tag line with a non-empty name:
+ *     uint64   offset of the line in the tag file
+ *     uint32   offset of the name in the name pool
+ *     uint32   length of the name
+ *   slots (S * 4 bytes):
+ *     uint32   0 for an empty slot, or 1 + the index of an entry
+ *   name pool (P bytes)
+ *
+ * A name in the pool is unescaped the same way readTagCharacter ()
+ * does, and is cut at NUL. The entries are sorted by the names folded
+ * to ASCII upper case, by the names themselves, and by the offsets.
+ * The slots are an open-addressing hash table (linear probing) of the
+ * groups of the entries having the same folded name; a slot points to
+ * the first entry of a group. The hash function is 32-bit FNV-1a over
+ * the bytes of the folded name.
+ *
+ * The index is valid if the size, mtime, inode, and device of the tag
+ * file are the recorded ones. A tag file rewritten in place changes
+ * its mtime, and one replaced by rename () changes its inode. In
+ * addition, a line read via the index must start
+ * at the recorded offset and match the name being searched for;
+ * otherwise the index is dropped.
+ */
+#define INDEX_SUFFIX ".idx"
+#define INDEX_MAGIC "ctagsidx"
+#define INDEX_VERSION 2
+#define INDEX_HEADER_SIZE 80
+#define INDEX_ENTRY_SIZE 16
+#define INDEX_SLOT_SIZE 4
+
 
 /*
 *   DATA DECLARATIONS
@@ -39,6 +96,13 @@ typedef long long rt_off_t;
 typedef off_t rt_off_t;
 #endif
 
+/* How the tag file is read */
+enum tagMapping {
+	TAG_MAPPING_NONE,			/* through FILE* (tagsOpen) */
+	TAG_MAPPING_MMAP,			/* mapped with mmap (tagsOpenMapped) */
+	TAG_MAPPING_HEAP,			/* read into malloc'ed memory (tagsOpenMapped) */
+};
+
 /* Information about current tag file */
 struct sTagFile {
 		/* has the file been opened and this structure initialized? */
@@ -95,6 +159,31 @@ struct sTagFile {
 		/* 0 (initial state set by calloc), errno value,
 		 * or tagErrno typed value */
 	int err;
+		/* the index of the tag file */
+	struct {
+				/* contents of the index file; NULL if not available */
+			unsigned char *buffer;
+			uint64_t count;
+			uint64_t slotCount;
+			const unsigned char *entries;
+			const unsigned char *slots;
+			const char *names;
+				/* offsets of the lines matched in the last search,
+				 * in the order of the tag file */
+			rt_off_t *hits;
+			size_t hitCount;
+			size_t hitNext;
+				/* the last search used the index */
+			short searching;
+	} index;
+		/* the tag file in memory */
+	struct {
+			enum tagMapping type;
+				/* contents of the tag file (may be NULL if empty) */
+			const char *buffer;
+				/* file position of the next line to read */
+			rt_off_t cursor;
+	} map;
 };
 
 /*
@@ -134,6 +223,57 @@ static int readtags_fseek(FILE *fp, rt_off_t pos, int whence)
 	return ret;
 }
 
+static rt_off_t tellTagFile (tagFile *const file)
+{
+	if (file->map.type == TAG_MAPPING_NONE)
+		return readtags_ftell (file->fp);
+	return file->map.cursor;
+}
+
+/* Set the file position of the tag file; POS is relative to the start
+ * of the file. */
+static int seekTagFile (tagFile *const file, rt_off_t pos)
+{
+	if (file->map.type == TAG_MAPPING_NONE)
+		return readtags_fseek (file->fp, pos, SEEK_SET);
+
+	if (pos < 0 || pos > file->size)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	file->map.cursor = pos;
+	return 0;
+}
+
+/* Step the cursor of a tag file in memory over a line. Return the
+ * start of the line, and store its length excluding the trailing
+ * newline characters to *LENGTH. Return NULL at the end of file. */
+static const char *nextMappedLine (tagFile *const file, size_t *const length)
+{
+	const char *start, *end, *newline;
+
+	file->pos = file->map.cursor;
+	if (file->map.cursor >= file->size)
+		return NULL;
+
+	start = file->map.buffer + file->map.cursor;
+	end = file->map.buffer + file->size;
+	newline = memchr (start, '\n', end - start);
+	if (newline != NULL)
+	{
+		file->map.cursor += newline - start + 1;
+		end = newline;
+	}
+	else
+		file->map.cursor = file->size;
+
+	while (end > start && (end [-1] == '\n' || end [-1] == '\r'))
+		--end;
+	*length = end - start;
+	return start;
+}
+
 /* Converts a hexadecimal digit to its value */
 static int xdigitValue (unsigned char digit)
 {
@@ -149,16 +289,17 @@ static int xdigitValue (unsigned char digit)
 
 /*
  * Reads the first character from the string, possibly un-escaping it, and
- * advances *s to the start of the next character.
+ * advances *s to the start of the next character. The string ends at
+ * END, or at a NUL character if END is NULL.
  */
-static int readTagCharacter (const char **const s)
+static int readTagCharacterInRange (const char **const s, const char *const end)
 {
 	const unsigned char *p = (const unsigned char *) *s;
 	int c = *p;
 
 	p++;
 
-	if (c == '\\')
+	if (c == '\\' && (end == NULL || (const char *) p < end))
 	{
 		switch (*p)
 		{
@@ -172,7 +313,8 @@ static int readTagCharacter (const char **const s)
 			case 'v': c = '\v'; p++; break;
 			case 'f': c = '\f'; p++; break;
 			case 'x':
-				if (isxdigit (p[1]) && isxdigit (p[2]))
+				if ((end == NULL || end - (const char *) p >= 3)
+					&& isxdigit (p[1]) && isxdigit (p[2]))
 				{
 					int val = (xdigitValue (p[1]) << 4) | xdigitValue (p[2]);
 					if (val < 0x80)
@@ -190,6 +332,11 @@ static int readTagCharacter (const char **const s)
 	return c;
 }
 
+static int readTagCharacter (const char **const s)
+{
+	return readTagCharacterInRange (s, NULL);
+}
+
 /*
  * Compare two strings, ignoring case.
  * Return 0 for match, < 0 for smaller, > 0 for bigger
@@ -245,7 +392,7 @@ static int tagncmp (const char *s1, const char *s2, size_t n)
 	int c1, c2;
 	do
 	{
-		c1 = *s1++;
+		c1 = (unsigned char)*s1++;
 		c2 = readTagCharacter (&s2);
 
 		result = c1 - c2;
@@ -315,6 +462,28 @@ static int readTagLineRaw (tagFile *const file, int *err)
 	int result = 1;
 	int reReadLine;
 
+	if (file->map.type != TAG_MAPPING_NONE)
+	{
+		size_t length;
+		const char *line = nextMappedLine (file, &length);
+		if (line == NULL)
+		{
+			*err = 0;
+			return 0;
+		}
+		while (length >= file->line.size)
+		{
+			if (growString (&file->line) != TagSuccess)
+			{
+				*err = ENOMEM;
+				return 0;
+			}
+		}
+		memcpy (file->line.buffer, line, length);
+		file->line.buffer [length] = '\0';
+		goto copy;
+	}
+
 	/*  If reading the line places any character other than a null or a
 	 *  newline at the last character position in the buffer (one less than
 	 *  the buffer size), then we must resize the buffer and reattempt to read
@@ -371,6 +540,7 @@ static int readTagLineRaw (tagFile *const file, int *err)
 			}
 		}
 	} while (reReadLine  &&  result);
+ copy:
 	if (result)
 	{
 		if (copyName (file) != TagSuccess)
@@ -672,6 +842,86 @@ static tagResult parseTagLine (tagFile *file, tagEntry *const entry, int *err)
 	return TagSuccess;
 }
 
+/* Find the end of the pattern starting at P with its delimiter in a
+ * view. Return the next character of the closing delimiter, or NULL if
+ * the pattern is not closed. */
+static const char *skipPatternInView (const char *p, const char *const start,
+									  const char *const end)
+{
+	const char delimiter = *p;
+
+	do
+	{
+		++p;
+		p = memchr (p, delimiter, end - p);
+	} while (p != NULL
+			 &&  isOdd (countContinuousBackslashesBackward (p - 1, start)));
+
+	return p? p + 1: NULL;
+}
+
+/* Does the same as parseTagLine () for a line in memory, but stores
+ * the views of the parts instead of copying and unescaping them. */
+static void parseTagView (tagFile *const file, const char *const line,
+						  const size_t length, tagEntryView *const view)
+{
+	const char *const end = line + length;
+	const char *p = line;
+	const char *tab = memchr (p, TAB, end - p);
+
+	memset (view, 0, sizeof (*view));
+
+	view->name.ptr = p;
+	view->name.length = (tab? tab: end) - p;
+	view->name.escaped = 1;
+	if (tab == NULL)
+		return;
+
+	p = tab + 1;
+	tab = memchr (p, TAB, end - p);
+	view->file.ptr = p;
+	view->file.length = (tab? tab: end) - p;
+	view->file.escaped = file->inputUCtagsMode;
+	if (tab == NULL)
+		return;
+
+	p = tab + 1;
+	view->address.ptr = p;
+	if (p < end && (*p == '/'  ||  *p == '?'))
+		p = skipPatternInView (p, view->address.ptr, end);
+	else if (p < end && isdigit (*(unsigned char*) p))
+	{
+		while (p < end && isdigit (*(unsigned char*) p))
+			++p;
+		if (end - p >= 2 && p[0] == ';' && (p[1] == '/' || p[1] == '?'))
+			p = skipPatternInView (p + 1, view->address.ptr, end);
+	}
+	else
+	{
+		/* TODO: invalid pattern */
+		view->address.ptr = NULL;
+	}
+
+	if (p == NULL)
+	{
+		/* TODO: invalid pattern */
+		view->address.length = end - view->address.ptr;
+		return;
+	}
+	if (view->address.ptr)
+		view->address.length = p - view->address.ptr;
+
+	if (end - p >= 2 && p[0] == ';' && p[1] == '"')
+	{
+		p += 2;
+		while (p < end && *p == TAB)
+			++p;
+		view->fields.ptr = p;
+		view->fields.length = end - p;
+		view->fields.escaped = 1;
+	}
+}
+
 static char *duplicate (const char *str)
 {
 	char *result = NULL;
@@ -691,7 +941,7 @@ static int isPseudoTagLine (const char *buffer)
 
 static tagResult readPseudoTags (tagFile *const file, tagFileInfo *const info)
 {
-	fpos_t startOfLine;
+	rt_off_t startOfLine;
 	int err = 0;
 	tagResult result = TagSuccess;
 	const size_t prefixLength = strlen (PseudoTagPrefix);
@@ -707,7 +957,8 @@ static tagResult readPseudoTags (tagFile *const file, tagFileInfo *const info)
 
 	while (1)
 	{
-		if (fgetpos (file->fp, &startOfLine) < 0)
+		startOfLine = tellTagFile (file);
+		if (startOfLine < 0)
 		{
 			err = errno;
 			break;
@@ -805,7 +1056,7 @@ static tagResult readPseudoTags (tagFile *const file, tagFileInfo *const info)
 	if (tag_output_mode_u_ctags && tag_output_filesep_slash)
 		file->inputUCtagsMode = 1;
 
-	if (fsetpos (file->fp, &startOfLine) < 0)
+	if (seekTagFile (file, startOfLine) < 0)
 		err = errno;
 
 	info->status.error_number = err;
@@ -821,9 +1072,9 @@ static int doesFilePointPseudoTag (tagFile *const file, void *unused)
 
 static tagResult gotoFirstLogicalTag (tagFile *const file)
 {
-	fpos_t startOfLine;
+	rt_off_t startOfLine;
 
-	if (readtags_fseek(file->fp, 0, SEEK_SET) == -1)
+	if (seekTagFile (file, 0) == -1)
 	{
 		file->err = errno;
 		return TagFailure;
@@ -831,7 +1082,8 @@ static tagResult gotoFirstLogicalTag (tagFile *const file)
 
 	while (1)
 	{
-		if (fgetpos (file->fp, &startOfLine) < 0)
+		startOfLine = tellTagFile (file);
+		if (startOfLine < 0)
 		{
 			file->err = errno;
 			return TagFailure;
@@ -845,7 +1097,7 @@ static tagResult gotoFirstLogicalTag (tagFile *const file)
 		if (!isPseudoTagLine (file->line.buffer))
 			break;
 	}
-	if (fsetpos (file->fp, &startOfLine) < 0)
+	if (seekTagFile (file, startOfLine) < 0)
 	{
 		file->err = errno;
 		return TagFailure;
@@ -853,7 +1105,175 @@ static tagResult gotoFirstLogicalTag (tagFile *const file)
 	return TagSuccess;
 }
 
-static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
+static uint64_t getIndexValue (const unsigned char *p, int bytes)
+{
+	uint64_t v = 0;
+	int i;
+	for (i = bytes - 1; i >= 0; i--)
+		v = (v << 8) | p [i];
+	return v;
+}
+
+/* Keep these in sync with main/tagindex.c of ctags. */
+static uint64_t fileStatMtimeNsec (const struct stat *status)
+{
+#if defined (_WIN32)
+	return 0;
+#elif defined (__APPLE__)
+	return (uint64_t) status->st_mtimespec.tv_nsec;
+#else
+	return (uint64_t) status->st_mtim.tv_nsec;
+#endif
+}
+
+static uint64_t fileStatInode (const struct stat *status)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return (uint64_t) status->st_ino;
+#endif
+}
+
+static void dropIndex (tagFile *const file)
+{
+	free (file->index.buffer);
+	free (file->index.hits);
+	memset (&file->index, 0, sizeof (file->index));
+}
+
+static void loadIndex (tagFile *const file, const char *const filePath)
+{
+	size_t length = strlen (filePath);
+	char *indexPath = (char *) malloc (length + sizeof (INDEX_SUFFIX));
+	struct stat status;
+	FILE *fp;
+	rt_off_t size;
+	unsigned char *buffer;
+	uint64_t count, slotCount, namesSize;
+
+	if (indexPath == NULL)
+		return;
+	memcpy (indexPath, filePath, length);
+	memcpy (indexPath + length, INDEX_SUFFIX, sizeof (INDEX_SUFFIX));
+	fp = fopen (indexPath, "rb");
+	free (indexPath);
+	if (fp == NULL)
+		return;
+
+	if (stat (filePath, &status) != 0
+		|| readtags_fseek (fp, 0, SEEK_END) < 0
+		|| (size = readtags_ftell (fp)) < INDEX_HEADER_SIZE
+		|| (uint64_t) size > (uint64_t) SIZE_MAX
+		|| readtags_fseek (fp, 0, SEEK_SET) < 0)
+	{
+		fclose (fp);
+		return;
+	}
+
+	buffer = (unsigned char *) malloc ((size_t) size);
+	if (buffer == NULL
+		|| fread (buffer, 1, (size_t) size, fp) != (size_t) size)
+	{
+		free (buffer);
+		fclose (fp);
+		return;
+	}
+	fclose (fp);
+
+	count = getIndexValue (buffer + 32, 8);
+	slotCount = getIndexValue (buffer + 40, 8);
+	namesSize = getIndexValue (buffer + 48, 8);
+	if (memcmp (buffer, INDEX_MAGIC, 8) != 0
+		|| getIndexValue (buffer + 8, 4) != INDEX_VERSION
+		|| getIndexValue (buffer + 16, 8) != (uint64_t) file->size
+		|| (uint64_t) status.st_size != (uint64_t) file->size
+		|| getIndexValue (buffer + 24, 8) != (uint64_t) (int64_t) status.st_mtime
+		|| getIndexValue (buffer + 56, 8) != fileStatMtimeNsec (&status)
+		|| getIndexValue (buffer + 64, 8) != fileStatInode (&status)
+		|| getIndexValue (buffer + 72, 8) != (uint64_t) status.st_dev
+		|| slotCount == 0 || (slotCount & (slotCount - 1)) != 0
+		|| count > (uint64_t) size / INDEX_ENTRY_SIZE
+		|| slotCount > (uint64_t) size / INDEX_SLOT_SIZE
+		|| INDEX_HEADER_SIZE + count * INDEX_ENTRY_SIZE
+		   + slotCount * INDEX_SLOT_SIZE + namesSize != (uint64_t) size)
+	{
+		free (buffer);
+		return;
+	}
+
+	file->index.buffer = buffer;
+	file->index.count = count;
+	file->index.slotCount = slotCount;
+	file->index.entries = buffer + INDEX_HEADER_SIZE;
+	file->index.slots = file->index.entries + count * INDEX_ENTRY_SIZE;
+	file->index.names = (const char *) (file->index.slots + slotCount * INDEX_SLOT_SIZE);
+}
+
+/* Bring the whole tag file into memory, and close the FILE*. */
+static tagResult mapTagFile (tagFile *const file, int *err)
+{
+	char *buffer;
+
+	if ((uint64_t) file->size > (uint64_t) SIZE_MAX)
+	{
+		*err = TagErrnoFileMaybeTooBig;
+		return TagFailure;
+	}
+
+	if (file->size > 0)
+	{
+#ifndef _WIN32
+		void *p = mmap (NULL, (size_t) file->size, PROT_READ, MAP_PRIVATE,
+						fileno (file->fp), 0);
+		if (p != MAP_FAILED)
+		{
+			file->map.type = TAG_MAPPING_MMAP;
+			file->map.buffer = p;
+			goto mapped;
+		}
+#endif
+		/* Fall back to reading if mmap is not available for the file. */
+		buffer = (char *) malloc ((size_t) file->size);
+		if (buffer == NULL)
+		{
+			*err = ENOMEM;
+			return TagFailure;
+		}
+		if (fread (buffer, 1, (size_t) file->size, file->fp) != (size_t) file->size)
+		{
+			*err = ferror (file->fp)? errno: EIO;
+			free (buffer);
+			return TagFailure;
+		}
+		file->map.buffer = buffer;
+	}
+	file->map.type = TAG_MAPPING_HEAP;
+
+#ifndef _WIN32
+ mapped:
+#endif
+	file->map.cursor = 0;
+	fclose (file->fp);
+	file->fp = NULL;
+	return TagSuccess;
+}
+
+static void unmapTagFile (tagFile *const file)
+{
+#ifndef _WIN32
+	if (file->map.type == TAG_MAPPING_MMAP)
+		munmap ((void *) file->map.buffer, (size_t) file->size);
+	else
+#endif
+	if (file->map.type == TAG_MAPPING_HEAP)
+		free ((void *) file->map.buffer);
+	file->map.type = TAG_MAPPING_NONE;
+	file->map.buffer = NULL;
+}
+
+static tagFile *initialize (const char *const filePath, tagFileInfo *const info,
+							int mapped)
 {
 	tagFile *result = (tagFile*) calloc ((size_t) 1, sizeof (tagFile));
 
@@ -916,9 +1336,14 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 		goto file_error;
 	}
 
+	if (mapped && mapTagFile (result, &info->status.error_number) != TagSuccess)
+		goto file_error;
+
 	if (readPseudoTags (result, info) == TagFailure)
 		goto file_error;
 
+	loadIndex (result, filePath);
+
 	info->status.opened = 1;
 	result->initialized = 1;
 
@@ -931,6 +1356,7 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 	free (result->fields.list);
 	if (result->fp)
 		fclose (result->fp);
+	unmapTagFile (result);
 	free (result);
 	info->status.opened = 0;
 	return NULL;
@@ -938,7 +1364,9 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 
 static void terminate (tagFile *const file)
 {
-	fclose (file->fp);
+	if (file->fp)
+		fclose (file->fp);
+	unmapTagFile (file);
 
 	free (file->line.buffer);
 	free (file->name.buffer);
@@ -955,6 +1383,8 @@ static void terminate (tagFile *const file)
 	if (file->search.name != NULL)
 		free (file->search.name);
 
+	dropIndex (file);
+
 	memset (file, 0, sizeof (tagFile));
 
 	free (file);
@@ -1000,7 +1430,7 @@ static const char *readFieldValue (
 
 static int readTagLineSeek (tagFile *const file, const rt_off_t pos)
 {
-	if (readtags_fseek (file->fp, pos, SEEK_SET) < 0)
+	if (seekTagFile (file, pos) < 0)
 	{
 		file->err = errno;
 		return 0;
@@ -1161,6 +1591,199 @@ static tagResult findSequential (tagFile *const file)
 	return findSequentialFull (file, nameAcceptable, NULL);
 }
 
+static int foldIndexChar (unsigned char c)
+{
+	return (c >= 'a' && c <= 'z')? c - 'a' + 'A': c;
+}
+
+/* Compare the name of the Ith entry with the first N bytes of the
+ * searched name, folding case. If PREFIX is set, the entry name is
+ * cut to N bytes before comparison. */
+static int compareIndexEntryName (tagFile *const file, uint64_t i,
+								  size_t n, int prefix, int ignorecase)
+{
+	const unsigned char *e = file->index.entries + i * INDEX_ENTRY_SIZE;
+	const char *name = file->index.names + getIndexValue (e + 8, 4);
+	size_t length = (size_t) getIndexValue (e + 12, 4);
+	size_t m;
+	size_t j;
+
+	if (prefix && length > n)
+		length = n;
+	m = (length < n)? length: n;
+	for (j = 0; j < m; j++)
+	{
+		int c1 = (unsigned char) name [j];
+		int c2 = (unsigned char) file->search.name [j];
+		int d = ignorecase
+			? foldIndexChar (c1) - foldIndexChar (c2)
+			: c1 - c2;
+		if (d != 0)
+			return d;
+	}
+	return (length < n)? -1: (length > n)? 1: 0;
+}
+
+static uint32_t hashIndexName (const char *name, size_t length)
+{
+	uint32_t h = 0x811c9dc5U;
+	size_t i;
+	for (i = 0; i < length; i++)
+	{
+		h ^= (uint32_t) foldIndexChar ((unsigned char) name [i]);
+		h *= 0x01000193U;
+	}
+	return h;
+}
+
+/* Return the first entry of the group having the same folded name
+ * as the searched name, or count if there is no such group. */
+static uint64_t lookupIndexSlots (tagFile *const file)
+{
+	uint64_t mask = file->index.slotCount - 1;
+	uint64_t s = hashIndexName (file->search.name, file->search.nameLength) & mask;
+	uint64_t probes;
+
+	for (probes = 0; probes < file->index.slotCount; probes++)
+	{
+		uint64_t v = getIndexValue (file->index.slots + s * INDEX_SLOT_SIZE, 4);
+		if (v == 0 || v > file->index.count)
+			break;
+		if (compareIndexEntryName (file, v - 1, file->search.nameLength, 0, 1) == 0)
+			return v - 1;
+		s = (s + 1) & mask;
+	}
+	return file->index.count;
+}
+
+/* Return the first entry whose folded name starts with the folded
+ * searched name. */
+static uint64_t lowerBoundInIndex (tagFile *const file)
+{
+	uint64_t lower = 0;
+	uint64_t upper = file->index.count;
+
+	while (lower < upper)
+	{
+		uint64_t middle = lower + (upper - lower) / 2;
+		if (compareIndexEntryName (file, middle, file->search.nameLength, 1, 1) < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower;
+}
+
+static int compareOffsets (const void *a, const void *b)
+{
+	rt_off_t x = *(const rt_off_t *) a;
+	rt_off_t y = *(const rt_off_t *) b;
+	return (x < y)? -1: (x > y)? 1: 0;
+}
+
+/* Collect the offsets of the lines matching the search into
+ * file->index.hits. */
+static tagResult collectIndexHits (tagFile *const file)
+{
+	const int partial = file->search.partial;
+	const int ignorecase = file->search.ignorecase;
+	const size_t n = file->search.nameLength;
+	size_t allocated = 0;
+	uint64_t i;
+
+	file->index.hitCount = 0;
+	file->index.hitNext = 0;
+
+	i = partial? lowerBoundInIndex (file): lookupIndexSlots (file);
+	for (; i < file->index.count; i++)
+	{
+		const unsigned char *e = file->index.entries + i * INDEX_ENTRY_SIZE;
+
+		if (compareIndexEntryName (file, i, n, partial, 1) != 0)
+			break;
+		if (!ignorecase && compareIndexEntryName (file, i, n, partial, 0) != 0)
+			continue;
+
+		if (file->index.hitCount == allocated)
+		{
+			size_t newAllocated = allocated? allocated * 2: 16;
+			rt_off_t *newHits = (rt_off_t *) realloc (file->index.hits,
+													  newAllocated * sizeof (rt_off_t));
+			if (newHits == NULL)
+			{
+				file->err = ENOMEM;
+				return TagFailure;
+			}
+			file->index.hits = newHits;
+			allocated = newAllocated;
+		}
+		file->index.hits [file->index.hitCount++] = (rt_off_t) getIndexValue (e, 8);
+	}
+
+	if (file->index.hitCount > 1)
+		qsort (file->index.hits, file->index.hitCount, sizeof (rt_off_t),
+			   compareOffsets);
+	return TagSuccess;
+}
+
+/* Read the line of the next hit. Return 0 at the end of the hits, or
+ * if the index doesn't agree with the tag file; the index is dropped
+ * in the latter case. */
+static int readNextIndexHit (tagFile *const file)
+{
+	rt_off_t pos;
+
+	if (file->index.hitNext >= file->index.hitCount)
+		return 0;
+	pos = file->index.hits [file->index.hitNext++];
+
+	if (file->map.type != TAG_MAPPING_NONE)
+	{
+		/* The index is stale if POS is not at the start of a line. */
+		if (pos < 0 || pos > file->size
+			|| (pos > 0 && file->map.buffer [pos - 1] != '\n'))
+			goto stale;
+		file->map.cursor = pos;
+	}
+	else if (pos > 0)
+	{
+		if (readtags_fseek (file->fp, pos - 1, SEEK_SET) < 0)
+		{
+			file->err = errno;
+			return 0;
+		}
+		if (getc (file->fp) != '\n')
+			goto stale;
+	}
+	else if (readtags_fseek (file->fp, pos, SEEK_SET) < 0)
+	{
+		file->err = errno;
+		return 0;
+	}
+
+	if (! readTagLineRaw (file, &file->err))
+	{
+		if (file->err)
+			return 0;
+		goto stale;
+	}
+	if (nameComparison (file) != 0)
+		goto stale;
+	return 1;
+
+ stale:
+	dropIndex (file);
+	return 0;
+}
+
+static tagResult findIndexed (tagFile *const file)
+{
+	file->index.searching = 1;
+	if (collectIndexHits (file) != TagSuccess)
+		return TagFailure;
+	return readNextIndexHit (file)? TagSuccess: TagFailure;
+}
+
 static tagResult find (tagFile *const file, tagEntry *const entry,
 					   const char *const name, const int options)
 {
@@ -1176,23 +1799,47 @@ static tagResult find (tagFile *const file, tagEntry *const entry,
 	file->search.nameLength = strlen (name);
 	file->search.partial = (options & TAG_PARTIALMATCH) != 0;
 	file->search.ignorecase = (options & TAG_IGNORECASE) != 0;
-	if (readtags_fseek (file->fp, 0, SEEK_END) < 0)
+	/* The size of a tag file in memory doesn't change. */
+	if (file->map.type == TAG_MAPPING_NONE)
 	{
-		file->err = errno;
-		return TagFailure;
+		if (readtags_fseek (file->fp, 0, SEEK_END) < 0)
+		{
+			file->err = errno;
+			return TagFailure;
+		}
+		file->size = readtags_ftell (file->fp);
+		if (file->size == -1)
+		{
+			file->err = errno;
+			return TagFailure;
+		}
 	}
-	file->size = readtags_ftell (file->fp);
-	if (file->size == -1)
+	if (seekTagFile (file, 0) == -1)
 	{
 		file->err = errno;
 		return TagFailure;
 	}
-	if (readtags_fseek(file->fp, 0, SEEK_SET) == -1)
+	file->index.searching = 0;
+	if (file->index.buffer != NULL && file->search.nameLength > 0)
 	{
-		file->err = errno;
-		return TagFailure;
+		result = findIndexed (file);
+		if (result == TagFailure && file->err)
+			return TagFailure;
+		/* Search the tag file if the index is dropped. */
+		if (file->index.buffer == NULL)
+		{
+			file->index.searching = 0;
+			if (seekTagFile (file, 0) == -1)
+			{
+				file->err = errno;
+				return TagFailure;
+			}
+		}
 	}
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
+
+	if (file->index.searching)
+		;
+	else if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
 		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
 	{
 		result = findBinary (file);
@@ -1241,6 +1888,15 @@ static tagResult findNextFull (tagFile *const file, tagEntry *const entry,
 
 static tagResult findNext (tagFile *const file, tagEntry *const entry)
 {
+	if (file->index.searching)
+	{
+		if (! readNextIndexHit (file))
+			return TagFailure;
+		return (entry != NULL)
+			? parseTagLine (file, entry, &file->err)
+			: TagSuccess;
+	}
+
 	return findNextFull (file, entry,
 						 (file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
 						 (file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase),
@@ -1260,7 +1916,7 @@ static tagResult findPseudoTag (tagFile *const file, int rewindBeforeFinding, ta
 
 	if (rewindBeforeFinding)
 	{
-		if (readtags_fseek(file->fp, 0, SEEK_SET) == -1)
+		if (seekTagFile (file, 0) == -1)
 		{
 			file->err = errno;
 			return TagFailure;
@@ -1272,6 +1928,30 @@ static tagResult findPseudoTag (tagFile *const file, int rewindBeforeFinding, ta
 						 NULL);
 }
 
+static int isEmptyNameLine (const char *const line, const size_t length)
+{
+	/* See copyName (). */
+	return (length == 0 || *line == TAB || *line == '\0'
+			|| (*line == '\r' && memchr (line, TAB, length) == NULL));
+}
+
+static tagResult readNextView (tagFile *const file, tagEntryView *const view)
+{
+	const char *line;
+	size_t length;
+
+	do
+	{
+		line = nextMappedLine (file, &length);
+		if (line == NULL)
+			return TagFailure;
+	} while (isEmptyNameLine (line, length));
+
+	if (view != NULL)
+		parseTagView (file, line, length, view);
+	return TagSuccess;
+}
+
 
 /*
 *  EXTERNAL INTERFACE
@@ -1280,7 +1960,13 @@ static tagResult findPseudoTag (tagFile *const file, int rewindBeforeFinding, ta
 extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info)
 {
 	tagFileInfo infoDummy;
-	return initialize (filePath, info? info: &infoDummy);
+	return initialize (filePath, info? info: &infoDummy, 0);
+}
+
+extern tagFile *tagsOpenMapped (const char *const filePath, tagFileInfo *const info)
+{
+	tagFileInfo infoDummy;
+	return initialize (filePath, info? info: &infoDummy, 1);
 }
 
 extern tagResult tagsSetSortType (tagFile *const file, const tagSortType type)
@@ -1337,6 +2023,106 @@ extern tagResult tagsNext (tagFile *const file, tagEntry *const entry)
 	return readNext (file, entry);
 }
 
+extern tagResult tagsFirstView (tagFile *const file, tagEntryView *const view)
+{
+	if (file == NULL)
+		return TagFailure;
+
+	if (!file->initialized || file->err
+		|| file->map.type == TAG_MAPPING_NONE)
+	{
+		file->err = TagErrnoInvalidArgument;
+		return TagFailure;
+	}
+
+	if (gotoFirstLogicalTag (file) != TagSuccess)
+		return TagFailure;
+	return readNextView (file, view);
+}
+
+extern tagResult tagsNextView (tagFile *const file, tagEntryView *const view)
+{
+	if (file == NULL)
+		return TagFailure;
+
+	if (!file->initialized || file->err
+		|| file->map.type == TAG_MAPPING_NONE)
+	{
+		file->err = TagErrnoInvalidArgument;
+		return TagFailure;
+	}
+
+	return readNextView (file, view);
+}
+
+extern tagResult tagsViewField (const tagEntryView *const view, const char *const key,
+								tagView *const value)
+{
+	const char *p, *end;
+	size_t keyLength;
+	int kind;
+
+	if (view == NULL || key == NULL || value == NULL || view->fields.ptr == NULL)
+		return TagFailure;
+
+	keyLength = strlen (key);
+	kind = (strcmp (key, "kind") == 0);
+	p = view->fields.ptr;
+	end = p + view->fields.length;
+	while (p < end)
+	{
+		const char *tab = memchr (p, TAB, end - p);
+		const char *fieldEnd = tab? tab: end;
+		const char *colon = memchr (p, ':', fieldEnd - p);
+
+		if (colon == NULL)
+		{
+			if (kind && fieldEnd > p)
+			{
+				value->ptr = p;
+				value->length = fieldEnd - p;
+				value->escaped = 0;
+				return TagSuccess;
+			}
+		}
+		else if ((size_t) (colon - p) == keyLength
+				 && memcmp (p, key, keyLength) == 0)
+		{
+			value->ptr = colon + 1;
+			value->length = fieldEnd - value->ptr;
+			value->escaped = 1;
+			return TagSuccess;
+		}
+		p = fieldEnd + 1;
+	}
+	return TagFailure;
+}
+
+extern size_t tagsUnescapeView (const tagView *const view, char *const buffer, size_t size)
+{
+	const char *p, *end;
+	size_t length = 0;
+
+	if (view != NULL && view->ptr != NULL)
+	{
+		p = view->ptr;
+		end = p + view->length;
+		while (p < end)
+		{
+			int c = view->escaped
+				? readTagCharacterInRange (&p, end)
+				: *(unsigned char *) p++;
+			if (length + 1 < size)
+				buffer [length] = (char) c;
+			++length;
+		}
+	}
+
+	if (size > 0)
+		buffer [length < size? length: size - 1] = '\0';
+	return length;
+}
+
 extern const char *tagsField (const tagEntry *const entry, const char *const key)
 {
 	const char *result = NULL;
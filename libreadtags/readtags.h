@@ -19,6 +19,8 @@
 #ifndef READTAGS_H
 #define READTAGS_H
 
+#include <stddef.h>  /* to declare size_t */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -156,6 +158,43 @@ typedef struct {
 
 } tagEntry;
 
+/* This structure is a view of a part of a tag line in a tag file opened
+ * with tagsOpenMapped(). The view points into the memory where the tag
+ * file is mapped; it is not terminated with a NUL character.
+ */
+typedef struct {
+
+		/* the first character of the part (NULL if not present) */
+	const char *ptr;
+
+		/* length of the part in bytes */
+	size_t length;
+
+		/* may the part include escape sequences? If so, use
+		   tagsUnescapeView() to get the value of the part. */
+	short escaped;
+
+} tagView;
+
+/* This structure contains views of the parts of a specific tag. */
+typedef struct {
+
+		/* name of tag */
+	tagView name;
+
+		/* path of source file containing definition of tag */
+	tagView file;
+
+		/* pattern and/or line number for locating tag in source file,
+		   as written in the tag file */
+	tagView address;
+
+		/* extension fields separated by tab characters
+		   (ptr is NULL if no extension field is present) */
+	tagView fields;
+
+} tagEntryView;
+
 
 /*
 *  FUNCTION PROTOTYPES
@@ -178,6 +217,17 @@ typedef struct {
 */
 extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info);
 
+/*
+*  Does the same as tagsOpen(), but maps the whole tag file into memory
+*  (or reads it into memory where mmap() is not available). Reading the
+*  tag file doesn't go through stdio then; the functions taking tagEntry
+*  work as they do on a tag file opened with tagsOpen(), and the
+*  functions taking tagEntryView are available in addition. Changes to
+*  the tag file made after opening are not observed. Truncating the tag
+*  file while it is mapped may kill the client with SIGBUS.
+*/
+extern tagFile *tagsOpenMapped (const char *const filePath, tagFileInfo *const info);
+
 /*
 *  This function allows the client to override the normal automatic detection
 *  of how a tag file is sorted. Permissible values for `type' are
@@ -221,6 +271,40 @@ extern tagResult tagsNext (tagFile *const file, tagEntry *const entry);
 */
 extern const char *tagsField (const tagEntry *const entry, const char *const key);
 
+/*
+*  Do the same as tagsFirst() and tagsNext() for a tag file opened with
+*  tagsOpenMapped(), but populate the structure pointed to by `view' with
+*  views into the mapped tag file instead of copying and unescaping the
+*  tag line. Stepping to the next tag is a matter of searching for the
+*  next newline character. The views are valid until tagsClose() is
+*  called. TagFailure is returned at the end of file, on error, or if the
+*  tag file is not opened with tagsOpenMapped(); use tagsGetErrno() to
+*  distinguish them.
+*/
+extern tagResult tagsFirstView (tagFile *const file, tagEntryView *const view);
+extern tagResult tagsNextView (tagFile *const file, tagEntryView *const view);
+
+/*
+*  Find the extension field for a specified key in the extension fields
+*  of a tag populated by tagsFirstView() or tagsNextView(), and populate
+*  the structure pointed to by `value' with the view of its value. The
+*  kind written without "kind:" prefix is found with the key "kind".
+*  The function will return TagSuccess if the field is found, or
+*  TagFailure if not.
+*/
+extern tagResult tagsViewField (const tagEntryView *const view, const char *const key,
+								tagView *const value);
+
+/*
+*  Unescape the part of a tag line viewed by `view' into `buffer' of
+*  `size' bytes. Like snprintf(), the result is truncated to `size' - 1
+*  bytes and terminated with a NUL character if `size' is not zero, and
+*  the function returns the length of the whole unescaped value. Call it
+*  again with a larger buffer if the returned value is not less than
+*  `size'.
+*/
+extern size_t tagsUnescapeView (const tagView *const view, char *const buffer, size_t size);
+
 /*
 *  Find the first tag matching `name'. The structure pointed to by `entry'
 *  will be populated with information about the tag file entry. If a tag file
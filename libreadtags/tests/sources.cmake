@@ -7,6 +7,7 @@ test-api-tagsFindPseudoTag.c
 test-api-tagsFirst.c
 test-api-tagsFirstPseudoTag.c
 test-api-tagsOpen.c
+test-api-tagsOpenMapped.c
 test-api-tagsSetSortType.c
 test-fix-large-tags.c
 test-fix-null-deref.c
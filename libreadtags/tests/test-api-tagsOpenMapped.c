@@ -0,0 +1,247 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released into the public domain.
+*
+*   Testing tagsOpenMapped() and the API functions taking tagEntryView
+*/
+
+#include "readtags.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static int
+compare_strings (const char *what, const char *expected, const char *actual)
+{
+	if ((expected == NULL) != (actual == NULL)
+		|| (expected && strcmp (expected, actual) != 0))
+	{
+		fprintf (stderr, "unexpected %s (expected: %s, actual: %s)\n",
+				 what, expected? expected: "(null)", actual? actual: "(null)");
+		return 1;
+	}
+	return 0;
+}
+
+static int
+compare_view (const char *what, const char *expected, const tagView *view)
+{
+	char small [4];
+	char *buf;
+	size_t len;
+	int r;
+
+	if (expected == NULL)
+	{
+		if (view->ptr == NULL)
+			return 0;
+		fprintf (stderr, "unexpected %s view (expected: (null))\n", what);
+		return 1;
+	}
+	if (view->ptr == NULL)
+	{
+		fprintf (stderr, "unexpected %s view (expected: %s, actual: (null))\n",
+				 what, expected);
+		return 1;
+	}
+
+	/* Ask the length with a small buffer first. */
+	len = tagsUnescapeView (view, small, sizeof (small));
+	if (strlen (small) != (len < sizeof (small)? len: sizeof (small) - 1))
+	{
+		fprintf (stderr, "wrongly truncated %s view: %s\n", what, small);
+		return 1;
+	}
+
+	buf = malloc (len + 1);
+	if (buf == NULL)
+	{
+		perror ("malloc");
+		exit (99);
+	}
+	if (tagsUnescapeView (view, buf, len + 1) != len)
+	{
+		fprintf (stderr, "unstable length of %s view\n", what);
+		free (buf);
+		return 1;
+	}
+	r = compare_strings (what, expected, buf);
+	free (buf);
+	return r;
+}
+
+/* Read TAGS with tagsOpen() and tagsOpenMapped(), and compare what
+ * tagsNext() and tagsNextView() return. */
+static int
+check_reading (const char *tags)
+{
+	tagFile *t0, *t1, *t2;
+	tagFileInfo info0, info1, info2;
+	tagEntry e0, e1;
+	tagEntryView v;
+	tagView kind;
+	tagResult r0, r1, r2;
+	unsigned int n = 0;
+
+	fprintf (stderr, "reading %s...", tags);
+	t0 = tagsOpen (tags, &info0);
+	t1 = tagsOpenMapped (tags, &info1);
+	t2 = tagsOpenMapped (tags, &info2);
+	if (t0 == NULL || t1 == NULL || t2 == NULL)
+	{
+		fprintf (stderr, "failed to open\n");
+		return 1;
+	}
+	if (info0.file.format != info1.file.format
+		|| info0.file.sort != info1.file.sort
+		|| compare_strings ("program name", info0.program.name, info1.program.name)
+		|| compare_strings ("program version", info0.program.version, info1.program.version))
+	{
+		fprintf (stderr, "different tag file info\n");
+		return 1;
+	}
+
+	r0 = tagsFirst (t0, &e0);
+	r1 = tagsFirst (t1, &e1);
+	r2 = tagsFirstView (t2, &v);
+	while (r0 == TagSuccess && r1 == TagSuccess && r2 == TagSuccess)
+	{
+		n++;
+		if (compare_strings ("name", e0.name, e1.name)
+			|| compare_strings ("file", e0.file, e1.file)
+			|| compare_strings ("pattern", e0.address.pattern, e1.address.pattern)
+			|| compare_strings ("kind", e0.kind, e1.kind)
+			|| e0.address.lineNumber != e1.address.lineNumber
+			|| e0.fileScope != e1.fileScope
+			|| e0.fields.count != e1.fields.count)
+			return 1;
+		for (unsigned short i = 0; i < e0.fields.count; i++)
+		{
+			tagView value;
+
+			if (compare_strings ("key", e0.fields.list [i].key, e1.fields.list [i].key)
+				|| compare_strings ("value", e0.fields.list [i].value, e1.fields.list [i].value))
+				return 1;
+			if (tagsViewField (&v, e0.fields.list [i].key, &value) != TagSuccess)
+			{
+				fprintf (stderr, "no %s field in the view\n", e0.fields.list [i].key);
+				return 1;
+			}
+			if (compare_view (e0.fields.list [i].key, e0.fields.list [i].value, &value))
+				return 1;
+		}
+
+		if (compare_view ("name", e0.name, &v.name)
+			|| compare_view ("file", e0.file, &v.file)
+			|| compare_view ("pattern", e0.address.pattern, &v.address))
+			return 1;
+		if (tagsViewField (&v, "kind", &kind) != TagSuccess)
+			kind.ptr = NULL;
+		if (compare_view ("kind", e0.kind, &kind))
+			return 1;
+
+		r0 = tagsNext (t0, &e0);
+		r1 = tagsNext (t1, &e1);
+		r2 = tagsNextView (t2, &v);
+	}
+	if (r0 != TagFailure || r1 != TagFailure || r2 != TagFailure
+		|| tagsGetErrno (t0) != tagsGetErrno (t1)
+		|| tagsGetErrno (t0) != tagsGetErrno (t2))
+	{
+		fprintf (stderr, "different end of the tag file (after %u tags)\n", n);
+		return 1;
+	}
+
+	tagsClose (t0);
+	tagsClose (t1);
+	tagsClose (t2);
+	fprintf (stderr, "ok (%u tags)\n", n);
+	return 0;
+}
+
+int
+main (void)
+{
+	char *srcdir = getenv ("srcdir");
+	if (srcdir)
+	{
+		if (chdir (srcdir) == -1)
+		{
+			perror ("chdir");
+			return 99;
+		}
+	}
+
+	const char *tags [] = {
+		"./unescaping.tags",
+		"./unescaping-input-fields.tags",
+		"./unescaping-input-fields-exuberant.tags",
+		"./duplicated-names--sorted-yes.tags",
+		"./null-deref.tags",
+		"./empty.tags",
+		"./empty-no-newline.tags",
+	};
+	for (size_t i = 0; i < sizeof (tags) / sizeof (tags [0]); i++)
+		if (check_reading (tags [i]))
+			return 1;
+
+	tagFile *t;
+	tagFileInfo info;
+	tagEntry e;
+	tagEntryView v;
+
+	fprintf (stderr, "opening a nonexistent file...");
+	t = tagsOpenMapped ("./nosuchfile.tags", &info);
+	if (t != NULL || info.status.opened != 0 || info.status.error_number == 0)
+	{
+		fprintf (stderr, "unexpected result (t: %p, opened: %d)\n",
+				 t, info.status.opened);
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "finding tags in a mapped file...");
+	t = tagsOpenMapped ("./duplicated-names--sorted-yes.tags", &info);
+	if (t == NULL)
+	{
+		fprintf (stderr, "failed to open\n");
+		return 1;
+	}
+	int found = 0;
+	tagResult r = tagsFind (t, &e, "n", TAG_FULLMATCH);
+	while (r == TagSuccess)
+	{
+		if (strcmp (e.name, "n") != 0)
+		{
+			fprintf (stderr, "unexpected name: %s\n", e.name);
+			return 1;
+		}
+		found++;
+		r = tagsFindNext (t, &e);
+	}
+	if (found != 6 || tagsGetErrno (t) != 0)
+	{
+		fprintf (stderr, "unexpected result (found: %d)\n", found);
+		return 1;
+	}
+	tagsClose (t);
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "reading views of a file opened with tagsOpen...");
+	t = tagsOpen ("./duplicated-names--sorted-yes.tags", &info);
+	if (t == NULL
+		|| tagsFirstView (t, &v) != TagFailure
+		|| tagsGetErrno (t) != TagErrnoInvalidArgument)
+	{
+		fprintf (stderr, "unexpected result\n");
+		return 1;
+	}
+	tagsClose (t);
+	fprintf (stderr, "ok\n");
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Defines an arena allocator: memory is bump-allocated from large
+*   chunks and released all at once when the arena is deleted.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "arena_p.h"
+#include "routines.h"
+
+/*
+*   MACROS
+*/
+#define ARENA_ALIGNMENT 16
+#define ARENA_MIN_CHUNK_SIZE (16 * 1024)
+#define ARENA_MAX_CHUNK_SIZE (1024 * 1024)
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sArenaChunk {
+	struct sArenaChunk *next;
+	size_t size;
+} arenaChunk;
+
+struct sArena {
+	arenaChunk *chunks;			/* the newest chunk comes first */
+	char *next;					/* the free space in the newest chunk */
+	char *end;
+	size_t chunkSize;			/* the size of the next chunk */
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+extern arena *arenaNew (void)
+{
+	arena *a = xMalloc (1, arena);
+
+	a->chunks = NULL;
+	a->next = NULL;
+	a->end = NULL;
+	a->chunkSize = ARENA_MIN_CHUNK_SIZE;
+	return a;
+}
+
+extern void arenaDelete (arena *a)
+{
+	arenaChunk *c = a->chunks;
+
+	while (c)
+	{
+		arenaChunk *next = c->next;
+		eFree (c);
+		c = next;
+	}
+	eFree (a);
+}
+
+static size_t alignArenaSize (size_t size)
+{
+	return (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+}
+
+extern void arenaClear (arena *a)
+{
+	if (a->chunks == NULL)
+		return;
+
+	/* Keep the newest chunk, the largest one, for reuse. */
+	arenaChunk *c = a->chunks->next;
+	while (c)
+	{
+		arenaChunk *next = c->next;
+		eFree (c);
+		c = next;
+	}
+	a->chunks->next = NULL;
+	a->next = (char *) a->chunks + alignArenaSize (sizeof (arenaChunk));
+}
+
+extern void *arenaAlloc (arena *a, size_t size)
+{
+	void *p;
+
+	size = alignArenaSize (size);
+	if (a->chunks == NULL || (size_t) (a->end - a->next) < size)
+	{
+		/* The chunks get larger as the arena is used more. */
+		const size_t header = alignArenaSize (sizeof (arenaChunk));
+		size_t chunkSize = a->chunkSize;
+		if (chunkSize < header + size)
+			chunkSize = header + size;
+		else if (a->chunkSize < ARENA_MAX_CHUNK_SIZE)
+			a->chunkSize *= 2;
+
+		arenaChunk *c = eMalloc (chunkSize);
+		c->next = a->chunks;
+		c->size = chunkSize;
+		a->chunks = c;
+		a->next = (char *) c + header;
+		a->end = (char *) c + chunkSize;
+	}
+
+	p = a->next;
+	a->next += size;
+	return p;
+}
@@ -0,0 +1,38 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Defines an arena allocator: memory is bump-allocated from large
+*   chunks and released all at once when the arena is deleted.
+*/
+#ifndef CTAGS_MAIN_ARENA_PRIVATE_H
+#define CTAGS_MAIN_ARENA_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   DATA DECLARATIONS
+*/
+struct sArena;
+typedef struct sArena arena;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern arena *arenaNew (void);
+extern void arenaDelete (arena *a);
+
+/* The memory returned is aligned for any object. It cannot be freed
+ * individually; it lives until arenaDelete () is called. */
+extern void *arenaAlloc (arena *a, size_t size);
+
+/* Release the memory allocated from A at once. A keeps a chunk of
+ * memory for the allocations made after this. */
+extern void arenaClear (arena *a);
+
+#endif	/* CTAGS_MAIN_ARENA_PRIVATE_H */
@@ -0,0 +1,589 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for caching the tags of each input
+*   file in a directory (--cache-dir=DIR).
+*
+*   While parsing an input file, the tags written to the tag file are
+*   captured in a memory stream. After parsing, the captured bytes are
+*   copied to the tag file, and stored to an entry file in the cache
+*   directory. When the same file is given again, the bytes in the entry
+*   are written to the tag file without running the parser.
+*
+*   The name of an entry file is made from the path of the input file and
+*   a fingerprint. The fingerprint covers the version of ctags, all the
+*   options processed so far, the directory of the tag file, and the name
+*   and version of the parser. An entry is valid if the modification time
+*   and the size of the input file are the same as the recorded ones.
+*   If only the modification time differs, or if the file was modified
+*   in the second when the entry was stored, the hash value of the
+*   contents of the file is compared.
+*
+*   Parser specific pseudo tags are written only once in a tag file.
+*   They are not stored in an entry. Instead, the entry records where
+*   they are requested, and the pseudo tags are made while replaying.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include "cache_p.h"
+#include "ctags.h"
+#include "debug.h"
+#include "entry_p.h"
+#include "mio.h"
+#include "options_p.h"
+#include "parse_p.h"
+#include "profile_p.h"
+#include "read_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "stats_p.h"
+#include "vstring.h"
+#include "writer_p.h"
+
+/*
+*   MACROS
+*/
+#define CACHE_MAGIC "ctgcach1"
+#define FNV_OFFSET_BASIS ((uint64_t) 0xcbf29ce484222325ULL)
+#define FNV_PRIME        ((uint64_t) 0x100000001b3ULL)
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sCacheHeader {
+	char magic [8];
+	uint64_t fingerprint;
+	int64_t mtime;
+	uint64_t size;
+	uint64_t contentHash;
+	int64_t storedAt;
+	uint64_t tags;
+	uint64_t lines;
+	uint32_t resize;
+	uint32_t ptagCount;
+	uint32_t absoluteNameLength;
+	uint32_t fileNameLength;
+	uint64_t dataLength;
+	/* Followed by the absolute file name, the file name, ptag records
+	 * (cachePtagRecord and the name of the parser), and the data. */
+} cacheHeader;
+
+typedef struct sCachePtagRecord {
+	uint64_t offset;
+	uint32_t nameLength;
+} cachePtagRecord;
+
+typedef struct sCachePtag {
+	size_t offset;
+	langType language;
+} cachePtag;
+
+typedef struct sCacheKey {
+	uint64_t fingerprint;
+	char *absoluteName;
+	char *entryName;
+} cacheKey;
+
+/*
+*   DATA DEFINITIONS
+*/
+static uint64_t OptionsFingerprint = FNV_OFFSET_BASIS;
+
+static struct {
+	MIO *tagFile;			/* the tag file while capturing */
+	MIO *mio;				/* where the tags are captured */
+	unsigned long tags;
+	long lines;
+	cachePtag *ptags;
+	unsigned int ptagCount;
+	unsigned int ptagAllocated;
+} Recording;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static uint64_t hashBytes (uint64_t hash, const void *data, size_t length)
+{
+	const unsigned char *p = data;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= p [i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+static uint64_t hashString (uint64_t hash, const char *str)
+{
+	/* Include the terminator to separate strings. */
+	return hashBytes (hash, str? str: "", str? strlen (str) + 1: 1);
+}
+
+extern void addOptionToCacheFingerprint (bool longOption,
+										 const char *const option,
+										 const char *const parameter)
+{
+	/* These options don't change the tags of an input file. The
+	 * directory of the tag file is a part of the key. */
+	if (longOption
+		&& (strcmp (option, "cache-dir") == 0
+			|| strcmp (option, "git-changes") == 0
+			|| strcmp (option, "jobs") == 0
+			|| strcmp (option, "max-parse-time") == 0
+			|| strcmp (option, "profile") == 0
+			|| strcmp (option, "tag-index") == 0
+			|| strcmp (option, "update") == 0
+			|| strcmp (option, "verbose") == 0
+			|| strcmp (option, "quiet") == 0))
+		return;
+	if (!longOption && strchr ("afoV", option [0]) != NULL)
+		return;
+
+	OptionsFingerprint = hashString (OptionsFingerprint, longOption? "--": "-");
+	OptionsFingerprint = hashString (OptionsFingerprint, option);
+	OptionsFingerprint = hashString (OptionsFingerprint, parameter);
+}
+
+extern uint64_t getOptionsFingerprint (void)
+{
+	return OptionsFingerprint;
+}
+
+static bool isCacheEnabled (void)
+{
+	return (Option.cacheDir != NULL
+			&& !Option.printLanguage
+			&& tagFileMio () != NULL);
+}
+
+static void initCacheKey (cacheKey *key, const char *const fileName,
+						  const langType language)
+{
+	uint64_t fingerprint = OptionsFingerprint;
+	unsigned int version [2] = {
+		getLanguageVersionCurrent (language),
+		getLanguageVersionAge (language),
+	};
+
+	fingerprint = hashString (fingerprint, PROGRAM_VERSION);
+	fingerprint = hashString (fingerprint, getTagFileDirectory ());
+	fingerprint = hashString (fingerprint, getLanguageName (language));
+	fingerprint = hashBytes (fingerprint, version, sizeof (version));
+	key->fingerprint = fingerprint;
+
+	key->absoluteName = absoluteFilename (fileName);
+
+	uint64_t h = hashBytes (fingerprint, &fingerprint, sizeof (fingerprint));
+	h = hashString (h, key->absoluteName);
+	h = hashString (h, fileName);
+
+	char base [sizeof (h) * 2 + sizeof (".tags")];
+	snprintf (base, sizeof (base), "%016llx.tags", (unsigned long long) h);
+	key->entryName = combinePathAndFile (Option.cacheDir, base);
+}
+
+static void clearCacheKey (cacheKey *key)
+{
+	eFree (key->absoluteName);
+	eFree (key->entryName);
+}
+
+static bool hashFileContents (const char *const fileName, uint64_t *hash)
+{
+	FILE *fp = fopen (fileName, "rb");
+	unsigned char buf [BUFSIZ];
+	size_t n;
+
+	if (fp == NULL)
+		return false;
+
+	*hash = FNV_OFFSET_BASIS;
+	while ((n = fread (buf, 1, sizeof (buf), fp)) > 0)
+		*hash = hashBytes (*hash, buf, n);
+
+	bool r = !ferror (fp);
+	fclose (fp);
+	return r;
+}
+
+/* Hash the contents of the input file, reading them from the stream
+ * opened for parsing if it is in memory. */
+static bool hashInputContents (inputFileHandle *handle, uint64_t *hash)
+{
+	unsigned char *data = NULL;
+	size_t size;
+
+	if (!handle->reused && openInputFileHandle (handle, false))
+		data = mio_memory_get_data (handle->mio, &size);
+	if (data == NULL)
+		return hashFileContents (handle->fileName, hash);
+
+	*hash = hashBytes (FNV_OFFSET_BASIS, data, size);
+	return true;
+}
+
+static bool readString (FILE *fp, uint32_t length, vString *str)
+{
+	vStringClear (str);
+	for (uint32_t i = 0; i < length; i++)
+	{
+		int c = fgetc (fp);
+		if (c == EOF)
+			return false;
+		vStringPut (str, c);
+	}
+	return true;
+}
+
+/* Whether LENGTH bytes are left in FP after the current position. A
+ * broken or truncated entry may record any length. */
+static bool hasBytesLeft (FILE *fp, uint64_t length)
+{
+	struct stat st;
+	long offset = ftell (fp);
+
+	if (offset < 0 || fstat (fileno (fp), &st) != 0
+		|| st.st_size < (off_t) offset)
+		return false;
+	return length <= (uint64_t) (st.st_size - (off_t) offset);
+}
+
+static void addCachePtag (size_t offset, langType language)
+{
+	if (Recording.ptagCount == Recording.ptagAllocated)
+	{
+		Recording.ptagAllocated = Recording.ptagAllocated? Recording.ptagAllocated * 2: 8;
+		Recording.ptags = xRealloc (Recording.ptags, Recording.ptagAllocated, cachePtag);
+	}
+	Recording.ptags [Recording.ptagCount].offset = offset;
+	Recording.ptags [Recording.ptagCount].language = language;
+	Recording.ptagCount++;
+}
+
+/* Write DATA to the tag file, making the pseudo tags at the recorded
+ * offsets. */
+static void writeCapturedTags (const unsigned char *data, size_t length)
+{
+	MIO *mio = tagFileMio ();
+	size_t written = 0;
+
+	for (unsigned int i = 0; i < Recording.ptagCount; i++)
+	{
+		size_t offset = Recording.ptags [i].offset;
+		if (offset > length)
+			offset = length;
+		if (offset > written)
+		{
+			mio_write (mio, data + written, 1, offset - written);
+			written = offset;
+		}
+		makeParserPseudoTags (Recording.ptags [i].language);
+	}
+	if (length > written)
+		mio_write (mio, data + written, 1, length - written);
+	abort_if_ferror (mio);
+}
+
+static bool loadCacheEntry (FILE *fp, const cacheKey *key, const char *const fileName,
+							cacheHeader *header, unsigned char **data)
+{
+	vString *str;
+	bool r = false;
+
+	if (fread (header, sizeof (*header), 1, fp) != 1
+		|| memcmp (header->magic, CACHE_MAGIC, sizeof (header->magic)) != 0
+		|| header->fingerprint != key->fingerprint)
+		return false;
+
+	str = vStringNew ();
+	if (!readString (fp, header->absoluteNameLength, str)
+		|| strcmp (vStringValue (str), key->absoluteName) != 0
+		|| !readString (fp, header->fileNameLength, str)
+		|| strcmp (vStringValue (str), fileName) != 0)
+		goto out;
+
+	Recording.ptagCount = 0;
+	for (uint32_t i = 0; i < header->ptagCount; i++)
+	{
+		cachePtagRecord record;
+		langType language;
+
+		if (fread (&record, sizeof (record), 1, fp) != 1
+			|| !readString (fp, record.nameLength, str))
+			goto out;
+		language = getNamedLanguage (vStringValue (str), 0);
+		if (language == LANG_IGNORE)
+			goto out;
+		addCachePtag ((size_t) record.offset, language);
+	}
+
+	if (!hasBytesLeft (fp, header->dataLength))
+	{
+		verbose ("ignoring the cache entry of %s: the data is shorter than recorded\n",
+				 fileName);
+		goto out;
+	}
+
+	*data = xMalloc ((size_t) header->dataLength + 1, unsigned char);
+	if (fread (*data, 1, (size_t) header->dataLength, fp) != (size_t) header->dataLength)
+	{
+		eFree (*data);
+		*data = NULL;
+		goto out;
+	}
+	r = true;
+
+ out:
+	vStringDelete (str);
+	return r;
+}
+
+static bool isCacheEntryFresh (const cacheHeader *header, inputFileHandle *handle,
+							   bool *touched)
+{
+	const fileStatus *status = getInputFileHandleStatus (handle);
+	uint64_t hash;
+
+	*touched = false;
+	if (!status->exists || !status->isNormalFile
+		|| header->size != (uint64_t) status->size)
+		return false;
+
+	if (header->mtime == (int64_t) status->mtime
+		&& header->mtime < header->storedAt)
+		return true;
+
+	if (!hashInputContents (handle, &hash) || hash != header->contentHash)
+		return false;
+
+	*touched = (header->mtime != (int64_t) status->mtime);
+	return true;
+}
+
+static void touchCacheEntry (const char *const entryName, cacheHeader *header,
+							 inputFileHandle *handle)
+{
+	FILE *fp = fopen (entryName, "r+b");
+
+	if (fp == NULL)
+		return;
+
+	header->mtime = (int64_t) getInputFileHandleStatus (handle)->mtime;
+	header->storedAt = (int64_t) time (NULL);
+	if (fwrite (header, sizeof (*header), 1, fp) != 1)
+		error (WARNING | PERROR, "cannot update cache entry \"%s\"", entryName);
+	fclose (fp);
+}
+
+extern bool replayCachedTags (const char *const fileName, const langType language,
+							  inputFileHandle *handle, bool *tagFileResized)
+{
+	cacheKey key;
+	cacheHeader header;
+	unsigned char *data = NULL;
+	bool touched = false;
+	bool r = false;
+	FILE *fp;
+
+	if (!isCacheEnabled ())
+		return false;
+
+	initCacheKey (&key, fileName, language);
+	fp = fopen (key.entryName, "rb");
+	if (fp != NULL)
+	{
+		r = loadCacheEntry (fp, &key, fileName, &header, &data)
+			&& isCacheEntryFresh (&header, handle, &touched);
+		fclose (fp);
+	}
+
+	if (r)
+	{
+		verbose ("using the cached tags of %s\n", fileName);
+		if (touched)
+			touchCacheEntry (key.entryName, &header, handle);
+
+		writeCapturedTags (data, (size_t) header.dataLength);
+		setNumTagsAdded (numTagsAdded () + (unsigned long) header.tags);
+		if (Option.printTotals || Profiling)
+			addTotals (0, (long) header.lines, (long) header.size);
+		*tagFileResized = header.resize;
+	}
+
+	if (data)
+		eFree (data);
+	Recording.ptagCount = 0;
+	clearCacheKey (&key);
+	return r;
+}
+
+extern bool beginCacheRecording (void)
+{
+	long files, bytes;
+
+	if (!isCacheEnabled ())
+		return false;
+
+	Assert (Recording.mio == NULL);
+	Recording.tagFile = tagFileMio ();
+	Recording.mio = mio_new_memory (NULL, 0, eRealloc, eFreeNoNullCheck);
+	Recording.tags = numTagsAdded ();
+	getTotals (&files, &Recording.lines, &bytes);
+	Recording.ptagCount = 0;
+	setTagFileMio (Recording.mio);
+
+	return true;
+}
+
+extern bool isCacheRecording (void)
+{
+	return Recording.mio != NULL;
+}
+
+extern void requestParserPseudoTagsForCache (const langType language)
+{
+	long offset = mio_tell (Recording.mio);
+
+	addCachePtag ((size_t) (offset < 0? 0: offset), language);
+}
+
+static void storeCacheEntry (const char *const fileName, const langType language,
+							 inputFileHandle *handle,
+							 cacheHeader *header, const unsigned char *data)
+{
+	const fileStatus *status = getInputFileHandleStatus (handle);
+	cacheKey key;
+	char *tmpName;
+	FILE *fp;
+	unsigned long pid;
+
+	if (!status->exists || !status->isNormalFile)
+		return;
+
+	initCacheKey (&key, fileName, language);
+
+	memcpy (header->magic, CACHE_MAGIC, sizeof (header->magic));
+	header->fingerprint = key.fingerprint;
+	header->mtime = (int64_t) status->mtime;
+	header->size = (uint64_t) status->size;
+	header->storedAt = (int64_t) time (NULL);
+	header->ptagCount = Recording.ptagCount;
+	header->absoluteNameLength = (uint32_t) strlen (key.absoluteName);
+	header->fileNameLength = (uint32_t) strlen (fileName);
+	if (!hashInputContents (handle, &header->contentHash))
+		goto out;
+
+#ifdef HAVE_UNISTD_H
+	pid = (unsigned long) getpid ();
+#else
+	pid = 0;
+#endif
+	tmpName = eMalloc (strlen (key.entryName) + 32);
+	sprintf (tmpName, "%s.%lu.tmp", key.entryName, pid);
+
+	fp = fopen (tmpName, "wb");
+	if (fp == NULL)
+	{
+		error (WARNING | PERROR, "cannot create cache entry \"%s\"", tmpName);
+		eFree (tmpName);
+		goto out;
+	}
+
+	fwrite (header, sizeof (*header), 1, fp);
+	fwrite (key.absoluteName, 1, header->absoluteNameLength, fp);
+	fwrite (fileName, 1, header->fileNameLength, fp);
+	for (unsigned int i = 0; i < Recording.ptagCount; i++)
+	{
+		const char *name = getLanguageName (Recording.ptags [i].language);
+		cachePtagRecord record = {
+			.offset = Recording.ptags [i].offset,
+			.nameLength = (uint32_t) strlen (name),
+		};
+		fwrite (&record, sizeof (record), 1, fp);
+		fwrite (name, 1, record.nameLength, fp);
+	}
+	fwrite (data, 1, (size_t) header->dataLength, fp);
+
+	bool failed = ferror (fp);
+	if (fclose (fp) != 0)
+		failed = true;
+
+	if (failed)
+	{
+		error (WARNING | PERROR, "cannot write cache entry \"%s\"", tmpName);
+		remove (tmpName);
+	}
+	else if (rename (tmpName, key.entryName) != 0)
+	{
+		/* rename () doesn't overwrite an existing file on Windows. */
+		remove (key.entryName);
+		if (rename (tmpName, key.entryName) != 0)
+		{
+			error (WARNING | PERROR, "cannot rename \"%s\" to \"%s\"",
+				   tmpName, key.entryName);
+			remove (tmpName);
+		}
+	}
+	eFree (tmpName);
+
+ out:
+	clearCacheKey (&key);
+}
+
+extern void endCacheRecording (const char *const fileName, const langType language,
+							   inputFileHandle *handle, bool tagFileResized)
+{
+	MIO *mio = Recording.mio;
+	cacheHeader header;
+	const unsigned char *data;
+	size_t length;
+	long files, lines, bytes;
+
+	Assert (mio != NULL);
+
+	Recording.mio = NULL;
+	setTagFileMio (Recording.tagFile);
+	Recording.tagFile = NULL;
+
+	data = mio_memory_get_data (mio, &length);
+	/* The tags after the position are discarded ones; see
+	 * setTagFilePosition (). */
+	if (mio_tell (mio) >= 0 && (size_t) mio_tell (mio) < length)
+		length = (size_t) mio_tell (mio);
+	getTotals (&files, &lines, &bytes);
+
+	memset (&header, 0, sizeof (header));
+	header.tags = numTagsAdded () - Recording.tags;
+	header.lines = (uint64_t) (lines - Recording.lines);
+	header.resize = tagFileResized;
+	header.dataLength = length;
+
+	writeCapturedTags (data, length);
+	/* A skipped file is not stored; whether it exceeds --max-parse-time
+	 * depends on the load of the machine. */
+	if (getExceededParseLimit () == PARSE_LIMIT_NONE)
+		storeCacheEntry (fileName, language, handle, &header, data);
+
+	Recording.ptagCount = 0;
+	mio_unref (mio);
+}
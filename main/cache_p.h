@@ -0,0 +1,53 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Private interface to cache.c, the per-file parse cache (--cache-dir=DIR).
+*/
+#ifndef CTAGS_MAIN_CACHE_PRIVATE_H
+#define CTAGS_MAIN_CACHE_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+
+#include "read_p.h"
+#include "types.h"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Used in options.c. Every option processed so far is a part of the
+ * keys of the cache entries. */
+extern void addOptionToCacheFingerprint (bool longOption,
+										 const char *const option,
+										 const char *const parameter);
+
+/* Used in gitindex.c. The fingerprint of the options processed so far */
+extern uint64_t getOptionsFingerprint (void);
+
+/* If the cache has a valid entry for FILENAME parsed with LANGUAGE,
+ * write the tags in the entry to the tag file, and return true. The
+ * status and the contents of the file are taken from HANDLE. */
+extern bool replayCachedTags (const char *const fileName, const langType language,
+							  inputFileHandle *handle, bool *tagFileResized);
+
+/* Capture the tags written while parsing FILENAME. endCacheRecording ()
+ * writes the captured tags to the tag file and stores them to the cache.
+ * beginCacheRecording () returns false if the cache is not used. */
+extern bool beginCacheRecording (void);
+extern void endCacheRecording (const char *const fileName, const langType language,
+							   inputFileHandle *handle, bool tagFileResized);
+
+/* Used in parse.c. Parser specific pseudo tags are not captured; where
+ * they are requested is recorded instead. */
+extern bool isCacheRecording (void);
+extern void requestParserPseudoTagsForCache (const langType language);
+
+#endif	/* CTAGS_MAIN_CACHE_PRIVATE_H */
@@ -0,0 +1,601 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for reading the directories visited
+*   by --recurse ahead of the recursion.
+*
+*   The recursion itself stays in main.c, on the main thread, and visits
+*   the entries in the same order as before. A listing holds the entries
+*   of a directory with the type of each file, taken from d_type of
+*   readdir () where it is known; a file is stat'ed with fstatat ()
+*   relative to the descriptor of its directory only if d_type doesn't
+*   tell enough.
+*
+*   When a directory is read, its subdirectories that the recursion will
+*   descend into are queued, and a pool of threads reads them. The queue
+*   is a stack, and the subdirectories are pushed in the reverse order,
+*   so the threads read the directories in the order the recursion visits
+*   them. A queued directory is opened with openat () relative to the
+*   descriptor of its parent. The number of the directories read ahead
+*   is bounded; a directory not read ahead is read by the main thread
+*   when the recursion reaches it, and the main thread also takes a
+*   queued directory from the queue instead of waiting for a thread.
+*
+*   Symbolic links to directories are not read ahead. The main thread
+*   checks them with isRecursiveLink () first.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "dirwalk_p.h"
+
+#ifdef HAVE_DIRWALK
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined (USE_POSIX_THREADS) && !defined (_WIN32)
+# include <pthread.h>
+# define DIRWALK_THREADS 1
+#endif
+
+#include "debug.h"
+#include "ignore_p.h"
+#include "numarray.h"
+#include "options_p.h"
+#include "routines.h"
+
+/*
+*   MACROS
+*/
+#define DIRWALK_MAX_THREADS	8
+
+/* A directory read ahead keeps the descriptor of its parent open until
+ * it is opened itself. */
+#define DIRWALK_MAX_AHEAD	256
+
+#ifndef O_CLOEXEC
+# define O_CLOEXEC 0
+#endif
+#ifndef O_DIRECTORY
+# define O_DIRECTORY 0
+#endif
+#ifndef O_NOFOLLOW
+# define O_NOFOLLOW 0
+#endif
+
+#ifdef DIRWALK_THREADS
+# define lockWalker(w)		pthread_mutex_lock (&(w)->lock)
+# define unlockWalker(w)	pthread_mutex_unlock (&(w)->lock)
+#else
+# define lockWalker(w)		do { } while (0)
+# define unlockWalker(w)	do { } while (0)
+#endif
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef enum eDirState {
+	DIR_UNREAD,					/* read when the recursion reaches it */
+	DIR_QUEUED,					/* waiting for a thread */
+	DIR_READING,
+	DIR_READ,
+} dirState;
+
+typedef struct sDirWalker {
+	unsigned int ahead;			/* listings read ahead, not deleted yet */
+	dirListing *queue [DIRWALK_MAX_AHEAD];
+	unsigned int queueCount;
+	unsigned int threadCount;
+#ifdef DIRWALK_THREADS
+	pthread_mutex_t lock;
+	pthread_cond_t queued;		/* a listing is queued, or stopping */
+	pthread_cond_t read;		/* a listing is read */
+	pthread_t threads [DIRWALK_MAX_THREADS];
+	bool stopping;
+#endif
+} dirWalker;
+
+typedef struct sDirEntry {
+	fileStatus status;
+	int error;					/* errno if the file doesn't exist */
+	bool ignored;				/* by the ignore files */
+} dirEntry;
+
+struct sDirListing {
+	dirWalker *walker;
+	dirListing *parent;			/* NULL for the top directory */
+	char *name;
+	unsigned int depth;
+	dirState state;
+	bool readAhead;
+	bool usesParentFd;			/* to be opened relative to parent->fd */
+	int error;					/* errno if reading failed */
+	ignoreRules *ignoreRules;	/* NULL unless --use-ignore-files */
+
+	/* The descriptor of the directory, kept open while the
+	 * subdirectories queued are not opened yet. */
+	int fd;
+	unsigned int fdUsers;
+
+	dirEntry *entries;
+	dirListing **ahead;			/* listings read ahead, indexed like entries */
+	unsigned int count;
+	unsigned int allocated;
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+#ifdef DIRWALK_THREADS
+static unsigned int countWalkThreads (void)
+{
+	long cpus = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+	cpus = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+	/* Reading directories mostly waits for the file system, so a
+	 * second thread helps even with a single CPU. */
+	if (cpus < 2)
+		cpus = 2;
+	if (cpus > DIRWALK_MAX_THREADS)
+		cpus = DIRWALK_MAX_THREADS;
+	return (unsigned int) cpus;
+}
+#endif
+
+static dirListing *newListing (dirWalker *walker, dirListing *parent,
+							   const char *const name, unsigned int depth)
+{
+	dirListing *listing = xCalloc (1, dirListing);
+
+	listing->walker = walker;
+	listing->parent = parent;
+	listing->name = eStrdup (name);
+	listing->depth = depth;
+	listing->state = DIR_UNREAD;
+	listing->fd = -1;
+	return listing;
+}
+
+static void freeListing (dirListing *listing)
+{
+	for (unsigned int i = 0; i < listing->count; i++)
+		eFree (listing->entries [i].status.name);
+	if (listing->entries)
+		eFree (listing->entries);
+	if (listing->ahead)
+		eFree (listing->ahead);
+	if (listing->ignoreRules)
+		ignoreRulesDelete (listing->ignoreRules);
+	eFree (listing->name);
+	eFree (listing);
+}
+
+/* Called with the walker locked. */
+static void releaseFd (dirListing *listing)
+{
+	Assert (listing->fdUsers > 0);
+	if (--listing->fdUsers == 0)
+	{
+		close (listing->fd);
+		listing->fd = -1;
+	}
+}
+
+/* Called with the walker locked. */
+static void waitForListing (dirWalker *walker, dirListing *listing)
+{
+#ifdef DIRWALK_THREADS
+	while (listing->state == DIR_READING)
+		pthread_cond_wait (&walker->read, &walker->lock);
+#endif
+	Assert (listing->state != DIR_READING);
+}
+
+/* Called with the walker locked. */
+static void removeFromQueue (dirWalker *walker, dirListing *listing)
+{
+	unsigned int i;
+
+	for (i = walker->queueCount; i > 0; i--)
+		if (walker->queue [i - 1] == listing)
+			break;
+	Assert (i > 0);
+	memmove (walker->queue + i - 1, walker->queue + i,
+			 sizeof (walker->queue [0]) * (walker->queueCount - i));
+	walker->queueCount--;
+	listing->state = DIR_UNREAD;
+}
+
+static int openListing (dirListing *listing)
+{
+	int fd;
+
+	if (listing->usesParentFd)
+	{
+		/* parent->fd stays open until this releases it. */
+		fd = openat (listing->parent->fd, baseFilename (listing->name),
+					 O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		const int e = errno;
+		lockWalker (listing->walker);
+		releaseFd (listing->parent);
+		listing->usesParentFd = false;
+		unlockWalker (listing->walker);
+		errno = e;
+	}
+	else
+		fd = openat (AT_FDCWD, listing->name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	return fd;
+}
+
+/* Fill STATUS like eStat () does, as far as the recursion needs it.
+ * Returns errno if the file doesn't exist. */
+static int statEntry (int dirFd, const struct dirent *d, fileStatus *status)
+{
+	struct stat st;
+
+	status->exists = true;
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+	switch (d->d_type)
+	{
+		case DT_REG:
+			status->isNormalFile = true;
+			return 0;
+		case DT_DIR:
+			status->isDirectory = true;
+			return 0;
+		case DT_LNK:
+			status->isSymbolicLink = true;
+			break;
+		case DT_UNKNOWN:
+			break;
+		default:				/* a special file */
+			return 0;
+	}
+#endif
+
+	if (! status->isSymbolicLink)
+	{
+		if (fstatat (dirFd, d->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+		{
+			status->exists = false;
+			return errno;
+		}
+		status->isSymbolicLink = (bool) S_ISLNK (st.st_mode);
+	}
+
+	/* The recursion ignores a symbolic link without looking at it
+	 * unless --links=yes is given. */
+	if (status->isSymbolicLink)
+	{
+		if (! Option.followLinks)
+			return 0;
+		if (fstatat (dirFd, d->d_name, &st, 0) != 0)
+		{
+			status->exists = false;
+			return errno;
+		}
+	}
+	fillFileStatus (status, &st);
+	return 0;
+}
+
+static bool shouldReadAhead (const dirListing *listing, const dirEntry *entry)
+{
+	const fileStatus *status = &entry->status;
+
+	/* Like recurseIntoDirectory () in main.c */
+	return ! entry->ignored && status->exists && status->isDirectory && ! status->isSymbolicLink
+		&& listing->depth < Option.maxRecursionDepth
+		&& ! isExcludedFile (status->name, true)
+		&& ! isExcludedDirectory (status->name);
+}
+
+/* Queue the first subdirectories of LISTING listed in CANDIDATES as
+ * many as the bound allows. Called with the walker locked. */
+static void queueAhead (dirListing *listing, uintArray *candidates)
+{
+	dirWalker *walker = listing->walker;
+	unsigned int n = uintArrayCount (candidates);
+
+	if (n > DIRWALK_MAX_AHEAD - walker->ahead)
+		n = DIRWALK_MAX_AHEAD - walker->ahead;
+	if (n == 0)
+		return;
+
+	listing->ahead = xCalloc (listing->count, dirListing *);
+	/* The last one pushed is read first. */
+	for (unsigned int i = n; i > 0; i--)
+	{
+		const unsigned int index = uintArrayItem (candidates, i - 1);
+		dirListing *child = newListing (walker, listing,
+										listing->entries [index].status.name,
+										listing->depth + 1);
+		child->state = DIR_QUEUED;
+		child->readAhead = true;
+		child->usesParentFd = true;
+		listing->fdUsers++;
+		listing->ahead [index] = child;
+		walker->queue [walker->queueCount++] = child;
+		walker->ahead++;
+	}
+#ifdef DIRWALK_THREADS
+	pthread_cond_broadcast (&walker->queued);
+#endif
+}
+
+static void readListing (dirListing *listing)
+{
+	dirWalker *walker = listing->walker;
+	const bool dot = (strcmp (listing->name, ".") == 0);
+	uintArray *candidates = NULL;
+	DIR *dir = NULL;
+	struct dirent *d;
+	int fd;
+
+	fd = openListing (listing);
+	if (fd >= 0)
+	{
+		dir = fdopendir (fd);
+		if (dir == NULL)
+		{
+			listing->error = errno;
+			close (fd);
+		}
+	}
+	else
+		listing->error = errno;
+
+	/* The parent is read before its subdirectories are. */
+	if (dir && Option.useIgnoreFiles)
+		listing->ignoreRules = ignoreRulesNew (listing->parent
+											   ? listing->parent->ignoreRules
+											   : NULL,
+											   listing->name);
+
+	while (dir && (d = readdir (dir)) != NULL)
+	{
+		if (strcmp (d->d_name, ".") == 0 || strcmp (d->d_name, "..") == 0)
+			continue;
+
+		if (listing->count == listing->allocated)
+		{
+			listing->allocated = listing->allocated? listing->allocated * 2: 16;
+			listing->entries = xRealloc (listing->entries, listing->allocated,
+										 dirEntry);
+		}
+		dirEntry *entry = listing->entries + listing->count;
+		fileStatus *status = &entry->status;
+		memset (entry, 0, sizeof (*entry));
+		status->name = dot? eStrdup (d->d_name)
+			: combinePathAndFile (listing->name, d->d_name);
+		entry->error = statEntry (dirfd (dir), d, status);
+		entry->ignored = listing->ignoreRules
+			&& isIgnoredByRules (listing->ignoreRules, status->name,
+								 status->isDirectory);
+
+		if (walker->threadCount > 0 && shouldReadAhead (listing, entry))
+		{
+			if (candidates == NULL)
+				candidates = uintArrayNew ();
+			uintArrayAdd (candidates, listing->count);
+		}
+		listing->count++;
+	}
+
+	/* The queued subdirectories are opened relative to a duplicate
+	 * of the descriptor. */
+	if (dir && candidates)
+		listing->fd = dup (dirfd (dir));
+	if (dir)
+		closedir (dir);
+
+	lockWalker (walker);
+	if (listing->fd >= 0)
+	{
+		queueAhead (listing, candidates);
+		if (listing->fdUsers == 0)
+		{
+			close (listing->fd);
+			listing->fd = -1;
+		}
+	}
+	listing->state = DIR_READ;
+#ifdef DIRWALK_THREADS
+	pthread_cond_broadcast (&walker->read);
+#endif
+	unlockWalker (walker);
+
+	if (candidates)
+		uintArrayDelete (candidates);
+}
+
+#ifdef DIRWALK_THREADS
+static void *runWalkerThread (void *data)
+{
+	dirWalker *walker = data;
+
+	lockWalker (walker);
+	while (true)
+	{
+		while (walker->queueCount == 0 && ! walker->stopping)
+			pthread_cond_wait (&walker->queued, &walker->lock);
+		if (walker->stopping)
+			break;
+
+		dirListing *listing = walker->queue [--walker->queueCount];
+		listing->state = DIR_READING;
+		unlockWalker (walker);
+		readListing (listing);
+		lockWalker (walker);
+	}
+	unlockWalker (walker);
+	return NULL;
+}
+#endif
+
+static dirWalker *newWalker (void)
+{
+	dirWalker *walker = xCalloc (1, dirWalker);
+
+#ifdef DIRWALK_THREADS
+	const unsigned int n = countWalkThreads ();
+
+	pthread_mutex_init (&walker->lock, NULL);
+	pthread_cond_init (&walker->queued, NULL);
+	pthread_cond_init (&walker->read, NULL);
+	for (unsigned int i = 0; i < n; i++)
+	{
+		if (pthread_create (walker->threads + walker->threadCount, NULL,
+							runWalkerThread, walker) == 0)
+			walker->threadCount++;
+	}
+#endif
+	return walker;
+}
+
+static void deleteWalker (dirWalker *walker)
+{
+	Assert (walker->queueCount == 0);
+	Assert (walker->ahead == 0);
+
+#ifdef DIRWALK_THREADS
+	lockWalker (walker);
+	walker->stopping = true;
+	pthread_cond_broadcast (&walker->queued);
+	unlockWalker (walker);
+	for (unsigned int i = 0; i < walker->threadCount; i++)
+		pthread_join (walker->threads [i], NULL);
+	pthread_cond_destroy (&walker->read);
+	pthread_cond_destroy (&walker->queued);
+	pthread_mutex_destroy (&walker->lock);
+#endif
+	eFree (walker);
+}
+
+/* Stop reading LISTING and the listings read ahead under it, and free
+ * the latter. Called with the walker locked. */
+static void cancelListing (dirListing *listing)
+{
+	dirWalker *walker = listing->walker;
+
+	if (listing->state == DIR_QUEUED)
+		removeFromQueue (walker, listing);
+	waitForListing (walker, listing);
+
+	if (listing->usesParentFd)
+	{
+		releaseFd (listing->parent);
+		listing->usesParentFd = false;
+	}
+
+	for (unsigned int i = 0; listing->ahead && i < listing->count; i++)
+	{
+		if (listing->ahead [i])
+		{
+			cancelListing (listing->ahead [i]);
+			freeListing (listing->ahead [i]);
+			listing->ahead [i] = NULL;
+		}
+	}
+	Assert (listing->fd == -1);
+
+	if (listing->readAhead)
+		walker->ahead--;
+}
+
+extern dirListing *dirListingNew (const char *const dirName, unsigned int depth)
+{
+	return newListing (newWalker (), NULL, dirName, depth);
+}
+
+extern dirListing *dirListingNewChild (dirListing *parent, unsigned int index)
+{
+	dirWalker *walker = parent->walker;
+	dirListing *child = NULL;
+
+	Assert (parent->state == DIR_READ);
+	Assert (index < parent->count);
+
+	lockWalker (walker);
+	if (parent->ahead)
+	{
+		child = parent->ahead [index];
+		parent->ahead [index] = NULL;
+	}
+	unlockWalker (walker);
+
+	if (child == NULL)
+		child = newListing (walker, parent, parent->entries [index].status.name,
+							parent->depth + 1);
+	return child;
+}
+
+extern bool dirListingRead (dirListing *listing)
+{
+	dirWalker *walker = listing->walker;
+	bool reading = false;
+
+	lockWalker (walker);
+	if (listing->state == DIR_QUEUED)
+		removeFromQueue (walker, listing);
+	if (listing->state == DIR_UNREAD)
+	{
+		listing->state = DIR_READING;
+		reading = true;
+	}
+	else
+		waitForListing (walker, listing);
+	unlockWalker (walker);
+
+	if (reading)
+		readListing (listing);
+
+	errno = listing->error;
+	return (listing->error == 0);
+}
+
+extern unsigned int dirListingCount (const dirListing *listing)
+{
+	Assert (listing->state == DIR_READ);
+	return listing->count;
+}
+
+extern const fileStatus *dirListingItem (const dirListing *listing, unsigned int index)
+{
+	Assert (index < listing->count);
+	errno = listing->entries [index].error;
+	return &listing->entries [index].status;
+}
+
+extern bool dirListingItemIsIgnored (const dirListing *listing, unsigned int index)
+{
+	Assert (index < listing->count);
+	return listing->entries [index].ignored;
+}
+
+extern void dirListingDelete (dirListing *listing)
+{
+	dirWalker *walker = listing->walker;
+	const bool top = (listing->parent == NULL);
+
+	lockWalker (walker);
+	cancelListing (listing);
+	unlockWalker (walker);
+	freeListing (listing);
+
+	if (top)
+		deleteWalker (walker);
+}
+
+#endif	/* HAVE_DIRWALK */
@@ -0,0 +1,66 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Private interface to dirwalk.c, reading directories ahead of the
+*   recursion of --recurse.
+*/
+#ifndef CTAGS_MAIN_DIRWALK_PRIVATE_H
+#define CTAGS_MAIN_DIRWALK_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+#include "routines_p.h"
+
+/*
+*   MACROS
+*/
+#if defined (HAVE_DIRENT_H) && defined (HAVE_OPENAT) && defined (HAVE_FSTATAT) \
+	&& defined (HAVE_FDOPENDIR)
+#define HAVE_DIRWALK 1
+#endif
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sDirListing dirListing;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+#ifdef HAVE_DIRWALK
+
+/* Make the listing of DIRNAME, a directory at DEPTH of the recursion.
+ * The subdirectories found in it are read ahead in the background, in
+ * the order the recursion visits them. Deleting the listing stops the
+ * background reads. */
+extern dirListing *dirListingNew (const char *const dirName, unsigned int depth);
+
+/* Make the listing of the directory at INDEX in PARENT, taking the one
+ * read ahead if any. It must be deleted before PARENT. */
+extern dirListing *dirListingNewChild (dirListing *parent, unsigned int index);
+
+/* Wait until LISTING is read, or read it. On failure, returns false
+ * with errno set. */
+extern bool dirListingRead (dirListing *listing);
+
+/* The entries are in the order readdir () returns them, except "." and
+ * "..". The name of an entry is the path to pass to parseFile (). The
+ * members of a status other than the type of the file are valid only
+ * if the file had to be stat'ed. dirListingItem () sets errno to the
+ * error of stat'ing the file if it doesn't exist. */
+extern unsigned int dirListingCount (const dirListing *listing);
+extern const fileStatus *dirListingItem (const dirListing *listing, unsigned int index);
+/* Whether the entry at INDEX is matched by the ignore files of
+ * --use-ignore-files. An ignored directory is not read ahead. */
+extern bool dirListingItemIsIgnored (const dirListing *listing, unsigned int index);
+
+extern void dirListingDelete (dirListing *listing);
+
+#endif
+
+#endif	/* CTAGS_MAIN_DIRWALK_PRIVATE_H */
@@ -39,10 +39,12 @@
 #include <stdint.h>
 #include <limits.h>  /* to define INT_MAX */
 
+#include "arena_p.h"
 #include "debug.h"
 #include "entry_p.h"
 #include "field.h"
 #include "fmt_p.h"
+#include "htable.h"
 #include "kind.h"
 #include "interval_tree_generic.h"
 #include "nestlevel.h"
@@ -54,10 +56,12 @@
 #include "routines.h"
 #include "routines_p.h"
 #include "parse_p.h"
+#include "profile_p.h"
 #include "ptrarray.h"
 #include "sort_p.h"
 #include "strlist.h"
 #include "subparser_p.h"
+#include "tagindex_p.h"
 #include "trashbox.h"
 #include "writer_p.h"
 #include "xtag_p.h"
@@ -66,6 +70,10 @@
 *   MACROS
 */
 
+/* The tags are written to the tag file in batches of this size
+ * by the output thread of the tag file. */
+#define TAG_FILE_BATCH_SIZE (1024 * 1024)
+
 /*
  *  Portability defines
  */
@@ -96,9 +104,17 @@ typedef struct eTagFile {
 	int cork;
 	unsigned int corkFlags;
 	ptrArray *corkQueue;
+	arena *corkArena;			/* the entries in corkQueue are allocated here */
+	unsigned int corkFlushed;	/* the entries written by closeTopLevelCorkScopes ();
+								 * corkQueue holds the nil entry and the entries
+								 * after them */
 	struct rb_root intervaltab;
 
 	bool patternCacheValid;
+
+	/* --update */
+	char *updatedFileName;		/* the tag file merged with the new tags */
+	hashTable *updatedInputs;	/* input fields of the tags to be dropped */
 } tagFile;
 
 typedef struct sTagEntryInfoX  {
@@ -108,6 +124,8 @@ typedef struct sTagEntryInfoX  {
 	struct rb_node symnode;
 	struct rb_node intervalnode;
 	unsigned long __intervalnode_subtree_last;
+	size_t blockSize;			/* of the block in the cork arena holding this
+								 * entry and its strings; 0 for the nil entry */
 } tagEntryInfoX;
 
 /*
@@ -131,6 +149,8 @@ static tagFile TagFile = {
 	 *
 	 */
 	.patternCacheValid = false,
+	.updatedFileName = NULL,
+	.updatedInputs = NULL,
 };
 
 static bool TagsToStdout = false;
@@ -402,6 +422,22 @@ extern void openTagFile (void)
 	setDefaultTagFileName ();
 	TagsToStdout = isDestinationStdout ();
 
+	if (Option.tagIndex)
+	{
+		if (TagsToStdout)
+			error (WARNING, "--tag-index is ignored when writing tags to stdout");
+		else if (! writerIsCtagsFormat ())
+			error (WARNING, "--tag-index works only with u-ctags and e-ctags output formats");
+	}
+
+	if (Option.update)
+	{
+		if (TagsToStdout)
+			error (FATAL, "--update requires a tag file");
+		if (! writerIsCtagsFormat ())
+			error (FATAL, "--update works only with u-ctags and e-ctags output formats");
+	}
+
 	if (TagFile.vLine == NULL)
 		TagFile.vLine = vStringNew ();
 
@@ -415,7 +451,10 @@ extern void openTagFile (void)
 			TagFile.name = NULL;
 		}
 		else
+		{
 			TagFile.mio = tempFile ("w+", &TagFile.name);
+			mio_file_set_async_output (TagFile.mio, TAG_FILE_BATCH_SIZE);
+		}
 		if (isXtagEnabled (XTAG_PSEUDO_TAGS))
 			addCommonPseudoTags ();
 	}
@@ -430,12 +469,27 @@ extern void openTagFile (void)
 			  "\"%s\" doesn't look like a tag file; I refuse to overwrite it.",
 				  TagFile.name);
 
-		if (Option.etags)
+		if (Option.update  &&  fileExists)
+		{
+			/* Write the new tags to a temporary file, and merge it
+			 * with the tag file in closeTagFile (). */
+			TagFile.updatedFileName = TagFile.name;
+			TagFile.name = NULL;
+			TagFile.mio = tempFile ("w+", &TagFile.name);
+			mio_file_set_async_output (TagFile.mio, TAG_FILE_BATCH_SIZE);
+			if (isXtagEnabled (XTAG_PSEUDO_TAGS))
+				addCommonPseudoTags ();
+		}
+		else if (Option.etags)
 		{
 			if (Option.append  &&  fileExists)
 				TagFile.mio = mio_new_file (TagFile.name, "a+b");
 			else
+			{
 				TagFile.mio = mio_new_file (TagFile.name, "w+b");
+				if (TagFile.mio != NULL)
+					mio_file_set_async_output (TagFile.mio, TAG_FILE_BATCH_SIZE);
+			}
 		}
 		else
 		{
@@ -452,6 +506,8 @@ extern void openTagFile (void)
 			else
 			{
 				TagFile.mio = mio_new_file (TagFile.name, "w");
+				if (TagFile.mio != NULL)
+					mio_file_set_async_output (TagFile.mio, TAG_FILE_BATCH_SIZE);
 				if (TagFile.mio != NULL && isXtagEnabled (XTAG_PSEUDO_TAGS))
 					addCommonPseudoTags ();
 			}
@@ -464,6 +520,8 @@ extern void openTagFile (void)
 	{
 		if (TagsToStdout)
 			TagFile.directory = eStrdup (CurrentDirectory);
+		else if (TagFile.updatedFileName)
+			TagFile.directory = absoluteDirname (TagFile.updatedFileName);
 		else
 			TagFile.directory = absoluteDirname (TagFile.name);
 	}
@@ -610,6 +668,67 @@ static void resizeTagFile (const long newSize)
 		fprintf (stderr, "Cannot shorten tag file: errno = %d\n", errno);
 }
 
+extern void rememberInputFileForUpdate (const char *const fileName)
+{
+	if (TagFile.updatedFileName == NULL)
+		return;
+
+	if (TagFile.updatedInputs == NULL)
+		TagFile.updatedInputs = hashTableNew (127, hashCstrhash, hashCstreq,
+											  eFree, NULL);
+
+	char *tagPath = vStringDeleteUnwrap (makeInputFileTagPath (fileName));
+	if (hashTableHasItem (TagFile.updatedInputs, tagPath))
+		eFree (tagPath);
+	else
+		hashTablePutItem (TagFile.updatedInputs, tagPath, tagPath);
+}
+
+static void updateTagFile (void)
+{
+	const char *const target = TagFile.updatedFileName;
+	vString *mergedName = vStringNewInit (target);
+	MIO *oldTags, *newTags, *merged;
+
+	vStringCatS (mergedName, ".updating");
+	verbose ("merging the new tags into %s\n", target);
+
+	oldTags = mio_new_file (target, "r");
+	if (oldTags == NULL)
+		error (FATAL | PERROR, "cannot open tag file \"%s\"", target);
+	newTags = mio_new_file (TagFile.name, "r");
+	if (newTags == NULL)
+		error (FATAL | PERROR, "cannot open temporary file \"%s\"", TagFile.name);
+	merged = mio_new_file (vStringValue (mergedName), "w");
+	if (merged == NULL)
+		error (FATAL | PERROR, "cannot open \"%s\"", vStringValue (mergedName));
+
+	if (TagFile.updatedInputs == NULL)
+		TagFile.updatedInputs = hashTableNew (1, hashCstrhash, hashCstreq,
+											  eFree, NULL);
+	TagFile.numTags.prev = mergeUpdatedTags (oldTags, newTags, merged,
+											 TagFile.updatedInputs);
+
+	mio_unref (oldTags);
+	mio_unref (newTags);
+	if (mio_unref (merged) != 0)
+		error (FATAL | PERROR, "cannot close \"%s\"", vStringValue (mergedName));
+
+	/* rename () of Windows doesn't replace an existing file. */
+	if (rename (vStringValue (mergedName), target) != 0
+		&& (remove (target) != 0
+			|| rename (vStringValue (mergedName), target) != 0))
+		error (FATAL | PERROR, "cannot replace tag file \"%s\"", target);
+
+	remove (TagFile.name);
+	eFree (TagFile.name);
+	TagFile.name = TagFile.updatedFileName;
+	TagFile.updatedFileName = NULL;
+	hashTableDelete (TagFile.updatedInputs);
+	TagFile.updatedInputs = NULL;
+	vStringDelete (mergedName);
+}
+
 static void writeEtagsIncludes (MIO *const mio)
 {
 	if (Option.etagsInclude)
@@ -648,6 +767,12 @@ extern void closeTagFile (const bool resize)
 		resizeTagFile (desiredSize);
 	}
 	sortTagFile ();
+	if (TagFile.updatedFileName)
+		updateTagFile ();
+	if (Option.tagIndex  &&  ! TagsToStdout  &&  writerIsCtagsFormat ())
+		writeTagIndex (TagFile.name);
+	else if (! TagsToStdout)
+		removeTagIndex (TagFile.name);
 	if (TagsToStdout)
 	{
 		if (mio_unref (TagFile.mio) != 0)
@@ -666,69 +791,79 @@ extern void closeTagFile (const bool resize)
  *  Tag entry management
  */
 
-/*  This function copies the current line out to a specified file. It has no
+/*  This function copies the line between LINE and END to OUTPUT. It has no
  *  effect on the fileGetc () function.  During copying, any '\' characters
- *  are doubled and a leading '^' or trailing '$' is also quoted. End of line
- *  characters (line feed or carriage return) are dropped.
+ *  are doubled and a leading '^' or trailing '$' is also quoted. Copying
+ *  stops at a line end character (line feed or carriage return) or NUL.
+ *  Runs of bytes needing no quoting are copied at once.
  */
-static size_t appendInputLine (int putc_func (char , void *), const char *const line,
-							   unsigned int patternLengthLimit,
-							   void * data, bool *omitted)
+static size_t appendInputLine (vString *output, const char *const line, const char *const end,
+							   unsigned int patternLengthLimit, bool *omitted)
 {
+	static bool special [256];
+	static int specialSearchChar;
+	const int searchChar = Option.backward ? '?' : '/';
 	size_t length = 0;
 	const char *p;
 	int extraLength = 0;
 
+	if (specialSearchChar != searchChar)
+	{
+		memset (special, 0, sizeof (special));
+		special ['\0'] = special ['\r'] = special ['\n'] = true;
+		special ['\\'] = special ['$'] = special [searchChar] = true;
+		specialSearchChar = searchChar;
+	}
+
 	/*  Write everything up to, but not including, a line end character.
 	 */
 	*omitted = false;
-	for (p = line  ;  *p != '\0'  ;  ++p)
+	for (p = line  ;  p < end  ;  ++p)
 	{
-		const int next = *(p + 1);
-		const int c = *p;
+		const char *run = p;
+		size_t room = (patternLengthLimit == 0)? (size_t) (end - p)
+			: (length < patternLengthLimit)? patternLengthLimit - length: 0;
 
-		if (c == '\r'  ||  c == '\n')
+		while (p < end && (size_t) (p - run) < room && !special [(unsigned char) *p])
+			p++;
+		if (p > run)
+		{
+			vStringNCatSUnsafe (output, run, p - run);
+			length += p - run;
+			if (p == end)
+				break;
+		}
+
+		const int next = (p + 1 < end)? *(p + 1): '\0';
+		const unsigned char c = (unsigned char) *p;
+
+		if (c == '\0'  ||  c == '\r'  ||  c == '\n')
 			break;
 
 		if (patternLengthLimit != 0 && length >= patternLengthLimit &&
 			/* Do not cut inside a multi-byte UTF-8 character, but safe-guard it not to
 			 * allow more than one extra valid UTF-8 character in case it's not actually
 			 * UTF-8.  To do that, limit to an extra 3 UTF-8 sub-bytes (0b10xxxxxx). */
-			((((unsigned char) c) & 0xc0) != 0x80 || ++extraLength > 3))
+			((c & 0xc0) != 0x80 || ++extraLength > 3))
 		{
 			*omitted = true;
 			break;
 		}
 		/*  If character is '\', or a terminal '$', then quote it.
 		 */
-		if (c == '\\'  ||  c == (Option.backward ? '?' : '/')  ||
+		if (c == '\\'  ||  c == searchChar  ||
 			(c == '$'  &&  (next == '\n'  ||  next == '\r')))
 		{
-			putc_func ('\\', data);
+			vStringPut (output, '\\');
 			++length;
 		}
-		putc_func (c, data);
+		vStringPut (output, c);
 		++length;
 	}
 
 	return length;
 }
 
-static int vstring_putc (char c, void *data)
-{
-	vString *str = data;
-	vStringPut (str, c);
-	return 1;
-}
-
-static int vstring_puts (const char* s, void *data)
-{
-	vString *str = data;
-	size_t len = vStringLength (str);
-	vStringCatS (str, s);
-	return (int) (vStringLength (str) - len);
-}
-
 #ifdef DEBUG
 static bool isPosSet (MIOPos pos)
 {
@@ -872,87 +1007,88 @@ extern void getTagScopeInformation (tagEntryInfo *const tag,
 }
 
 
-static int   makePatternStringCommon (const tagEntryInfo *const tag,
-									  int (* putc_func) (char , void *),
-									  int (* puts_func) (const char* , void *),
-									  void *output)
+static void makePatternStringCommon (const tagEntryInfo *const tag, vString *output)
 {
-	int length = 0;
-
-	char *line;
-	int searchChar;
+	const char *line = NULL;
 	const char *terminator;
 	bool  omitted;
 	size_t line_len;
 
-	bool making_cache = false;
-	int (* puts_o_func)(const char* , void *);
-	void * o_output;
-
 	static vString *cached_pattern;
 	static MIOPos   cached_location;
 	if (TagFile.patternCacheValid
 		&& (! tag->truncateLineAfterTag)
 		&& (memcmp (&tag->filePosition, &cached_location, sizeof(MIOPos)) == 0))
-		return puts_func (vStringValue (cached_pattern), output);
+	{
+		vStringCat (output, cached_pattern);
+		return;
+	}
 
-	line = readLineFromBypassForTag (TagFile.vLine, tag, NULL);
-	if (line == NULL)
+	/* The line can be sliced from the input if it is in memory and
+	 * no need to be truncated. readLineFromBypass () treats a line
+	 * including NUL specially; leave it to the function. */
+	if (!tag->truncateLineAfterTag)
 	{
-		/* This can be occurs if the size of input file is zero, and
-		   an empty regex pattern (//) matches to the input. */
-		line = "";
-		line_len = 0;
+		line = sliceLineFromBypass (tag->filePosition, &line_len);
+		if (line && memchr (line, '\0', line_len))
+			line = NULL;
 	}
-	else
-		line_len = vStringLength (TagFile.vLine);
 
-	if (tag->truncateLineAfterTag)
+	if (line)
+		terminator = (line [line_len - 1] == '\n')? "$": "";
+	else
 	{
-		size_t truncted_len;
+		char *vline = readLineFromBypassForTag (TagFile.vLine, tag, NULL);
+		if (vline == NULL)
+		{
+			/* This can be occurs if the size of input file is zero, and
+			   an empty regex pattern (//) matches to the input. */
+			vline = "";
+			line_len = 0;
+		}
+		else
+			line_len = vStringLength (TagFile.vLine);
 
-		truncted_len = truncateTagLineAfterTag (line, tag->name, false);
-		if (truncted_len > 0)
-			line_len = truncted_len;
-	}
+		if (tag->truncateLineAfterTag)
+		{
+			size_t truncted_len;
 
-	searchChar = Option.backward ? '?' : '/';
-	terminator = (line_len > 0 && (line [line_len - 1] == '\n')) ? "$": "";
+			truncted_len = truncateTagLineAfterTag (vline, tag->name, false);
+			if (truncted_len > 0)
+				line_len = truncted_len;
+		}
 
+		terminator = (line_len > 0 && (vline [line_len - 1] == '\n')) ? "$": "";
+		line = vline;
+	}
+
+	vString *pattern = output;
 	if (!tag->truncateLineAfterTag)
 	{
-		making_cache = true;
 		cached_pattern = vStringNewOrClearWithAutoRelease (cached_pattern);
-
-		puts_o_func = puts_func;
-		o_output    = output;
-		putc_func   = vstring_putc;
-		puts_func   = vstring_puts;
-		output      = cached_pattern;
+		pattern = cached_pattern;
 	}
 
-	length += putc_func(searchChar, output);
+	vStringPut (pattern, Option.backward ? '?' : '/');
 	if ((tag->boundaryInfo & INPUT_BOUNDARY_START) == 0)
-		length += putc_func('^', output);
-	length += appendInputLine (putc_func, line, Option.patternLengthLimit,
-							   output, &omitted);
-	length += puts_func (omitted? "": terminator, output);
-	length += putc_func (searchChar, output);
+		vStringPut (pattern, '^');
+	appendInputLine (pattern, line, line + line_len, Option.patternLengthLimit,
+					 &omitted);
+	vStringCatS (pattern, omitted? "": terminator);
+	vStringPut (pattern, Option.backward ? '?' : '/');
 
-	if (making_cache)
+	if (pattern == cached_pattern)
 	{
-		puts_o_func (vStringValue (cached_pattern), o_output);
+		vStringCat (output, cached_pattern);
 		cached_location = tag->filePosition;
 		TagFile.patternCacheValid = true;
 	}
-
-	return length;
 }
 
 extern char* makePatternString (const tagEntryInfo *const tag)
 {
 	vString* pattern = vStringNew ();
-	makePatternStringCommon (tag, vstring_putc, vstring_puts, pattern);
+	makePatternStringCommon (tag, pattern);
 	return vStringDeleteUnwrap (pattern);
 }
 
@@ -1096,24 +1232,73 @@ static void copyExtraDynamic (const tagEntryInfo *const src, tagEntryInfo *const
 	}
 }
 
+static size_t corkStringSize (const char *str)
+{
+	return str? strlen (str) + 1: 0;
+}
+
+static const char *copyCorkString (char **block, const char *str)
+{
+	if (str == NULL)
+		return NULL;
+
+	size_t size = strlen (str) + 1;
+	char *copy = memcpy (*block, str, size);
+	*block += size;
+	return copy;
+}
+
+static const char *dupCorkString (const char *str)
+{
+	return str? eStrdup (str): NULL;
+}
+
+/* The entry, its extraDynamic, and the values of its parser fields are
+ * allocated as one block in the cork arena, and released all at once
+ * when the cork queue is uncorked. The string members are copied with
+ * eStrdup () as before: a parser may free one of them with eFree () and
+ * store its own string to the queued entry. */
 static tagEntryInfoX *copyTagEntry (const tagEntryInfo *const tag,
 									const char *shareInputFileName,
 									const char *sharedSourceFileName,
 									unsigned int corkFlags)
 {
-	tagEntryInfoX *x = xMalloc (1, tagEntryInfoX);
+	bool inputFileNameShared = (tag->inputFileName == getInputFileName ());
+	/* strcmp() is needed here.
+	 * sharedSourceFileName can be changed during parsing a file.
+	 * So we cannot use the condition like:
+	 *
+	 *    if (slot->sourceFileName == getSourceFileTagPath()) { ... }
+	 *
+	 */
+	bool sourceFileNameShared = (tag->sourceFileName
+								 && strcmp (tag->sourceFileName, sharedSourceFileName) == 0);
+	size_t extraDynamicSize = tag->extraDynamic? ((countXtags () - XTAG_COUNT) / 8) + 1: 0;
+	size_t blockSize = sizeof (tagEntryInfoX) + extraDynamicSize;
+
+	for (unsigned int i = 0; i < tag->usedParserFields; i++)
+		blockSize += corkStringSize (getParserFieldForIndex (tag, i)->value);
+
+	tagEntryInfoX *x = arenaAlloc (TagFile.corkArena, blockSize);
+	char *block = (char *) (x + 1);
 	x->symtab = RB_ROOT;
 	x->corkIndex = CORK_NIL;
 	memset(&x->intervalnode, 0, sizeof (x->intervalnode));
 	x->__intervalnode_subtree_last = 0;
+	x->blockSize = blockSize;
 	tagEntryInfo  *slot = (tagEntryInfo *)x;
 
 	*slot = *tag;
 
-	if (slot->pattern)
-		slot->pattern = eStrdup (slot->pattern);
+	if (slot->extraDynamic)
+	{
+		slot->extraDynamic = memcpy (block, tag->extraDynamic, extraDynamicSize);
+		block += extraDynamicSize;
+	}
+
+	slot->pattern = dupCorkString (slot->pattern);
 
-	if (slot->inputFileName == getInputFileName ())
+	if (inputFileNameShared)
 	{
 		slot->inputFileName = shareInputFileName;
 		slot->isInputFileNameShared = 1;
@@ -1125,40 +1310,21 @@ static tagEntryInfoX *copyTagEntry (const tagEntryInfo *const tag,
 	}
 
 	slot->name = eStrdup (slot->name);
-	if (slot->extensionFields.access)
-		slot->extensionFields.access = eStrdup (slot->extensionFields.access);
-	if (slot->extensionFields.implementation)
-		slot->extensionFields.implementation = eStrdup (slot->extensionFields.implementation);
-	if (slot->extensionFields.inheritance)
-		slot->extensionFields.inheritance = eStrdup (slot->extensionFields.inheritance);
-	if (slot->extensionFields.scopeName)
-		slot->extensionFields.scopeName = eStrdup (slot->extensionFields.scopeName);
-	if (slot->extensionFields.signature)
-		slot->extensionFields.signature = eStrdup (slot->extensionFields.signature);
-	if (slot->extensionFields.typeRef[0])
-		slot->extensionFields.typeRef[0] = eStrdup (slot->extensionFields.typeRef[0]);
-	if (slot->extensionFields.typeRef[1])
-		slot->extensionFields.typeRef[1] = eStrdup (slot->extensionFields.typeRef[1]);
+	slot->extensionFields.access = dupCorkString (slot->extensionFields.access);
+	slot->extensionFields.implementation = dupCorkString (slot->extensionFields.implementation);
+	slot->extensionFields.inheritance = dupCorkString (slot->extensionFields.inheritance);
+	slot->extensionFields.scopeName = dupCorkString (slot->extensionFields.scopeName);
+	slot->extensionFields.signature = dupCorkString (slot->extensionFields.signature);
+	slot->extensionFields.typeRef[0] = dupCorkString (slot->extensionFields.typeRef[0]);
+	slot->extensionFields.typeRef[1] = dupCorkString (slot->extensionFields.typeRef[1]);
 #ifdef HAVE_LIBXML
-	if (slot->extensionFields.xpath)
-		slot->extensionFields.xpath = eStrdup (slot->extensionFields.xpath);
+	slot->extensionFields.xpath = dupCorkString (slot->extensionFields.xpath);
 #endif
 
-	copyExtraDynamic (tag, slot);
-	if (slot->extraDynamic)
-		PARSER_TRASH_BOX_TAKE_BACK(slot->extraDynamic);
-
 	if (slot->sourceFileName == NULL)
 		slot->isSourceFileNameShared = 0;
-	else if (strcmp(slot->sourceFileName, sharedSourceFileName) == 0)
+	else if (sourceFileNameShared)
 	{
-		/* strcmp() is needed here.
-		 * sharedSourceFileName can be changed during parsing a file.
-		 * So we cannot use the condition like:
-		 *
-		 *    if (slot->sourceFileName == getSourceFileTagPath()) { ... }
-		 *
-		 */
 		slot->sourceFileName = sharedSourceFileName;
 		slot->isSourceFileNameShared = 1;
 	}
@@ -1170,10 +1336,15 @@ static tagEntryInfoX *copyTagEntry (const tagEntryInfo *const tag,
 
 	slot->usedParserFields = 0;
 	slot->parserFieldsDynamic = NULL;
-	copyParserFields (tag, slot);
+	for (unsigned int i = 0; i < tag->usedParserFields; i++)
+	{
+		const tagField *f = getParserFieldForIndex (tag, i);
+		attachParserFieldGeneric (slot, f->ftype, copyCorkString (&block, f->value), false);
+	}
 	if (slot->parserFieldsDynamic)
 		PARSER_TRASH_BOX_TAKE_BACK(slot->parserFieldsDynamic);
 
+	Assert (block == (char *) x + blockSize);
 	return x;
 }
 
@@ -1202,16 +1373,29 @@ static void clearParserFields (tagEntryInfo *const tag)
 	}
 }
 
+static bool isInCorkBlock (const tagEntryInfo *const tag, const void *const ptr)
+{
+	const tagEntryInfoX *x = (const tagEntryInfoX *)tag;
+	const char *p = ptr;
+
+	return (x->blockSize > 0
+			&& (const char *)x <= p && p < (const char *)x + x->blockSize);
+}
+
+/* The block of the entry is released with the cork arena. The string
+ * members are owned by the entry. */
 static void deleteTagEnry (void *data)
 {
 	tagEntryInfo *slot = data;
 
-	if (slot->kindIndex == KIND_FILE_INDEX)
+	if (((tagEntryInfoX *)slot)->blockSize == 0)
 	{
+		/* The nil entry made in newNilTagEntry () */
 		eFree ((char *)slot->inputFileName);
 		if (slot->sourceFileName)
 			eFree ((char *)slot->sourceFileName);
-		goto out;
+		eFree (slot);
+		return;
 	}
 
 	if (slot->pattern)
@@ -1241,16 +1425,29 @@ static void deleteTagEnry (void *data)
 		eFree ((char *)slot->extensionFields.xpath);
 #endif
 
-	if (slot->extraDynamic)
+	/* markTagExtraBit () allocates one if the entry had none. */
+	if (slot->extraDynamic && !isInCorkBlock (slot, slot->extraDynamic))
 		eFree (slot->extraDynamic);
 
 	if (slot->sourceFileName && !slot->isSourceFileNameShared)
 		eFree ((char *)slot->sourceFileName);
 
 	clearParserFields (slot);
+}
 
- out:
-	eFree (slot);
+/* Return the entry for CORKINDEX, the nil entry for CORK_NIL, or NULL if
+ * the entry was released by closeTopLevelCorkScopes (). */
+static tagEntryInfoX *getCorkEntry (int corkIndex)
+{
+	if (corkIndex == CORK_NIL)
+		return ptrArrayItem (TagFile.corkQueue, 0);
+	if (corkIndex < 0 || (unsigned int)corkIndex <= TagFile.corkFlushed)
+		return NULL;
+
+	unsigned int i = (unsigned int)corkIndex - TagFile.corkFlushed;
+	if (i >= ptrArrayCount (TagFile.corkQueue))
+		return NULL;
+	return ptrArrayItem (TagFile.corkQueue, i);
 }
 
 static void corkSymtabPut (tagEntryInfoX *scope, const char* name, tagEntryInfoX *item)
@@ -1315,7 +1512,9 @@ extern bool foreachEntriesInScope (int corkIndex,
 								   entryForeachFunc func,
 								   void *data)
 {
-	tagEntryInfoX *x = ptrArrayItem (TagFile.corkQueue, corkIndex);
+	tagEntryInfoX *x = getCorkEntry (corkIndex);
+	if (x == NULL)
+		return true;
 
 	struct rb_root *root = &x->symtab;
 	tagEntryInfoX *rep = NULL;
@@ -1559,11 +1758,10 @@ extern void registerEntry (int corkIndex)
 	Assert (TagFile.corkFlags & CORK_SYMTAB);
 	Assert (corkIndex != CORK_NIL);
 
-	tagEntryInfoX *e = ptrArrayItem (TagFile.corkQueue, corkIndex);
-	{
-		tagEntryInfoX *scope = ptrArrayItem (TagFile.corkQueue, e->slot.extensionFields.scopeIndex);
+	tagEntryInfoX *e = getCorkEntry (corkIndex);
+	tagEntryInfoX *scope = e? getCorkEntry (e->slot.extensionFields.scopeIndex): NULL;
+	if (scope)
 		corkSymtabPut (scope, e->slot.name, e);
-	}
 }
 
 extern void unregisterEntry (int corkIndex)
@@ -1571,12 +1769,10 @@ extern void unregisterEntry (int corkIndex)
 	Assert (TagFile.corkFlags & CORK_SYMTAB);
 	Assert (corkIndex != CORK_NIL);
 
-	tagEntryInfoX *e = ptrArrayItem (TagFile.corkQueue, corkIndex);
-	{
-		tagEntryInfoX *scope = ptrArrayItem (TagFile.corkQueue, e->slot.extensionFields.scopeIndex);
+	tagEntryInfoX *e = getCorkEntry (corkIndex);
+	tagEntryInfoX *scope = e? getCorkEntry (e->slot.extensionFields.scopeIndex): NULL;
+	if (scope)
 		corkSymtabUnlink (scope, e);
-	}
-
 }
 
 static int queueTagEntry (const tagEntryInfo *const tag)
@@ -1588,7 +1784,7 @@ static int queueTagEntry (const tagEntryInfo *const tag)
 	tagEntryInfoX * entry = copyTagEntry (tag, nil->inputFileName, nil->sourceFileName,
 										TagFile.corkFlags);
 
-	if (ptrArrayCount (TagFile.corkQueue) == (size_t)INT_MAX)
+	if (countEntryInCorkQueue () == (size_t)INT_MAX)
 	{
 		if (!warned)
 		{
@@ -1602,7 +1798,7 @@ static int queueTagEntry (const tagEntryInfo *const tag)
 	}
 	warned = false;
 
-	corkIndex = (int)ptrArrayAdd (TagFile.corkQueue, entry);
+	corkIndex = (int)(TagFile.corkFlushed + ptrArrayAdd (TagFile.corkQueue, entry));
 	entry->corkIndex = corkIndex;
 	entry->slot.inCorkQueue = 1;
 
@@ -1824,21 +2020,24 @@ extern void corkTagFile (unsigned int corkFlags)
 	{
 		TagFile.corkFlags = corkFlags;
 		TagFile.corkQueue = ptrArrayNew (deleteTagEnry);
+		TagFile.corkArena = arenaNew ();
 		tagEntryInfo *nil = newNilTagEntry (corkFlags);
 		ptrArrayAdd (TagFile.corkQueue, nil);
+		TagFile.corkFlushed = 0;
 		TagFile.intervaltab = RB_ROOT;
 	}
 }
 
-extern void uncorkTagFile (void)
+/* Write the entries in the cork queue.
+ * The entries made by makeQualifiedTagEntry () here are written
+ * directly; the caller must make TagFile.cork 0. */
+static void writeCorkQueue (void)
 {
 	unsigned int i;
 
-	TagFile.cork--;
-
-	if (TagFile.cork > 0)
-		return ;
+	Assert (TagFile.cork == 0);
 
+	profileEnter (PROFILE_WRITE);
 	for (i = 1; i < ptrArrayCount (TagFile.corkQueue); i++)
 	{
 		tagEntryInfo *tag = ptrArrayItem (TagFile.corkQueue, i);
@@ -1860,15 +2059,58 @@ extern void uncorkTagFile (void)
 					&& tag->extensionFields.scopeIndex == CORK_NIL)))
 			makeQualifiedTagEntry (tag);
 	}
+	profileLeave ();
+}
+
+extern void uncorkTagFile (void)
+{
+	TagFile.cork--;
+
+	if (TagFile.cork > 0)
+		return ;
+
+	writeCorkQueue ();
 
 	ptrArrayDelete (TagFile.corkQueue);
 	TagFile.corkQueue = NULL;
+	TagFile.corkFlushed = 0;
+	arenaDelete (TagFile.corkArena);
+	TagFile.corkArena = NULL;
+}
+
+/* Write the entries queued so far, and release them.
+ * The symbol table of the top level and the interval table refer
+ * only to the released entries; they are emptied. */
+extern void closeTopLevelCorkScopes (void)
+{
+	/* Don't flush the queue shared with the parser running outside. */
+	if (TagFile.cork != 1)
+		return;
+
+	unsigned int count = ptrArrayCount (TagFile.corkQueue);
+	if (count <= 1)
+		return;
+
+	TagFile.cork = 0;
+	writeCorkQueue ();
+	TagFile.cork = 1;
+
+	ptrArrayDeleteLastInBatch (TagFile.corkQueue, count - 1);
+	TagFile.corkFlushed += count - 1;
+	arenaClear (TagFile.corkArena);
+
+	tagEntryInfoX *nil = ptrArrayItem (TagFile.corkQueue, 0);
+	nil->symtab = RB_ROOT;
+	TagFile.intervaltab = RB_ROOT;
 }
 
 extern tagEntryInfo *getEntryInCorkQueue (int n)
 {
-	if ((CORK_NIL < n) && (((size_t)n) < ptrArrayCount (TagFile.corkQueue)))
-		return ptrArrayItem (TagFile.corkQueue, n);
+	if (CORK_NIL < n)
+	{
+		tagEntryInfoX *x = getCorkEntry (n);
+		return x? &x->slot: NULL;
+	}
 	else
 		return NULL;
 }
@@ -1882,7 +2124,7 @@ extern tagEntryInfo *getEntryOfNestingLevel (const NestingLevel *nl)
 
 extern size_t countEntryInCorkQueue (void)
 {
-	return ptrArrayCount (TagFile.corkQueue);
+	return TagFile.corkFlushed + ptrArrayCount (TagFile.corkQueue);
 }
 
 extern void markTagAsPlaceholder (tagEntryInfo *e, bool placeholder)
@@ -1936,10 +2178,17 @@ extern int makeTagEntry (const tagEntryInfo *const tag)
 		goto out;
 	}
 
+	if (ParseBudgetEnabled && !chargeParseBudgetForTag ())
+		goto out;
+
 	if (TagFile.cork)
 		r = queueTagEntry (tag);
 	else
+	{
+		profileEnter (PROFILE_WRITE);
 		writeTagEntry (tag);
+		profileLeave ();
+	}
 
 	if (r != CORK_NIL)
 		notifyMakeTagEntry (tag, r);
@@ -2306,6 +2555,16 @@ extern void invalidatePatternCache (void)
 	TagFile.patternCacheValid = false;
 }
 
+extern MIO *tagFileMio (void)
+{
+	return TagFile.mio;
+}
+
+extern void setTagFileMio (MIO *mio)
+{
+	TagFile.mio = mio;
+}
+
 extern void tagFilePosition (MIOPos *p)
 {
 	/* mini-geany doesn't set TagFile.mio. */
@@ -2388,7 +2647,9 @@ extern int queryIntervalTabByCorkEntry(int corkIndex)
 {
 	Assert (corkIndex != CORK_NIL);
 
-	tagEntryInfoX *ex = ptrArrayItem (TagFile.corkQueue, corkIndex);
+	tagEntryInfoX *ex = getCorkEntry (corkIndex);
+	if (ex == NULL)
+		return CORK_NIL;
 	tagEntryInfo *e = &ex->slot;
 
 	if (e->extensionFields._endLine == 0)
@@ -2401,7 +2662,9 @@ extern bool removeFromIntervalTabMaybe(int corkIndex)
 	if (corkIndex == CORK_NIL)
 		return false;
 
-	tagEntryInfoX *ex = ptrArrayItem (TagFile.corkQueue, corkIndex);
+	tagEntryInfoX *ex = getCorkEntry (corkIndex);
+	if (ex == NULL)
+		return false;
 	tagEntryInfo *e = &ex->slot;
 	if (!e->inIntevalTab)
 		return false;
@@ -198,6 +198,19 @@ tagEntryInfo *getEntryInCorkQueue   (int n);
 tagEntryInfo *getEntryOfNestingLevel (const NestingLevel *nl);
 size_t        countEntryInCorkQueue (void);
 
+/* A parser using the cork queue can call closeTopLevelCorkScopes() when
+ * it is at the top level of the input, where all the scopes it opened are
+ * closed. This declares the tags queued so far complete: the parser
+ * doesn't update them, look them up in the symbol tables or the interval
+ * table, or use their cork indexes as the scope of new tags.
+ *
+ * The tags are written to the tag file and released before the end of
+ * the input. The memory for the cork queue scales with the tags of a
+ * top-level scope, not with the size of the input. getEntryInCorkQueue()
+ * returns NULL for the cork indexes of the released tags.
+ */
+void          closeTopLevelCorkScopes (void);
+
 /* If a parser sets (CORK_QUEUE and )CORK_SYMTAB to useCork,
  * the parsesr can use symbol lookup tables for the current input.
  * Each scope has a symbol lookup table.
@@ -30,6 +30,7 @@ extern void freeTagFileResources (void);
 extern const char *tagFileName (void);
 extern void openTagFile (void);
 extern void closeTagFile (const bool resize);
+extern void rememberInputFileForUpdate (const char *const fileName);
 extern void  setupWriter (void *writerClientData);
 extern bool  teardownWriter (const char *inputFilename);
 
@@ -41,6 +42,10 @@ extern void invalidatePatternCache(void);
 extern void tagFilePosition (MIOPos *p);
 extern void setTagFilePosition (MIOPos *p, bool truncation);
 extern const char* getTagFileDirectory (void);
+
+/* Used in jobs.c to redirect the tags written in a worker process. */
+extern MIO *tagFileMio (void);
+extern void setTagFileMio (MIO *mio);
 extern void getTagScopeInformation (tagEntryInfo *const tag,
 				    const char **kind, const char **name);
 
@@ -0,0 +1,568 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for finding the files changed since
+*   the previous run from the git index, without running git
+*   (--git-changes=MANIFEST).
+*
+*   The index, .git/index, lists the tracked files with the hash value of
+*   their contents and the status (the modification time and the size)
+*   the files had when the hash value was computed. If the status of a
+*   file in the working tree is the same as the cached one, the hash
+*   value in the index is the one of the file; the file is clean. A file
+*   modified in the same second as the index was written may be changed
+*   without changing its status, so it is not taken as clean, as git
+*   does.
+*
+*   The manifest records the state of each tracked file, the hash value
+*   for a clean file and the status for the others, when the previous
+*   run made the tags. A file is changed if it is not recorded, if its
+*   hash value differs from the recorded one, or, if either of them is
+*   not clean, if its status differs. The manifest also records a
+*   fingerprint of the options; all the files are changed if the options
+*   differ.
+*
+*   Only the regular files at stage 0 are read; files in conflict,
+*   symbolic links, submodules, and the files outside the sparse
+*   checkout are not. The index of a repository using SHA-256 is not
+*   supported.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+
+#include "cache_p.h"
+#include "ctags.h"
+#include "debug.h"
+#include "gitindex_p.h"
+#include "htable.h"
+#include "options.h"
+#include "ptrarray.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define MANIFEST_MAGIC "!_GIT_CHANGES_MANIFEST"
+#define GIT_HASH_SIZE 20		/* SHA-1 */
+
+#define GIT_MODE_TYPE     0170000
+#define GIT_MODE_REGULAR  0100000
+
+#define GIT_FLAG_EXTENDED     0x4000
+#define GIT_FLAG_STAGE        0x3000
+#define GIT_XFLAG_SKIP_WORKTREE 0x4000
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sGitFileState {
+	unsigned char hash [GIT_HASH_SIZE];
+	bool clean;					/* HASH is the one of the file */
+	bool seen;					/* in the index (for recorded states) */
+	int64_t mtime;
+	uint64_t size;
+} gitFileState;
+
+typedef struct sGitEntry {
+	char *name;
+	gitFileState state;
+} gitEntry;
+
+struct sGitIndex {
+	char *manifestName;
+	uint64_t fingerprint;
+	gitEntry *entries;
+	unsigned int count;
+	unsigned int allocated;
+	ptrArray *changed;			/* the names in ENTRIES */
+	ptrArray *removed;
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static uint32_t getBE32 (const unsigned char *p)
+{
+	return ((uint32_t) p [0] << 24) | ((uint32_t) p [1] << 16)
+		| ((uint32_t) p [2] << 8) | (uint32_t) p [3];
+}
+
+static uint16_t getBE16 (const unsigned char *p)
+{
+	return (uint16_t) ((p [0] << 8) | p [1]);
+}
+
+/* Read the whole contents of FILENAME. Returns NULL if the file can't
+ * be opened. */
+static unsigned char *readWholeFile (const char *const fileName, size_t *size)
+{
+	FILE *fp = fopen (fileName, "rb");
+	unsigned char *data;
+	long length = 0;
+
+	if (fp == NULL)
+		return NULL;
+
+	if (fseek (fp, 0L, SEEK_END) != 0 || (length = ftell (fp)) < 0
+		|| fseek (fp, 0L, SEEK_SET) != 0)
+		error (FATAL | PERROR, "cannot read \"%s\"", fileName);
+
+	data = eMalloc ((size_t) length + 1);
+	if (fread (data, 1, (size_t) length, fp) != (size_t) length)
+		error (FATAL | PERROR, "cannot read \"%s\"", fileName);
+	data [length] = '\0';
+	fclose (fp);
+
+	*size = (size_t) length;
+	return data;
+}
+
+/* The git directory of the working tree at the current directory: .git,
+ * or the directory named in .git of a linked working tree or a
+ * submodule. */
+static char *findGitDir (void)
+{
+	struct stat st;
+
+	if (stat (".git", &st) != 0)
+		error (FATAL, "--git-changes: the current directory is not the top of a git working tree");
+
+	if (S_ISDIR (st.st_mode))
+		return eStrdup (".git");
+
+	size_t size;
+	char *data = (char *) readWholeFile (".git", &size);
+	const char *const prefix = "gitdir: ";
+
+	if (data == NULL || strncmp (data, prefix, strlen (prefix)) != 0)
+		error (FATAL, "--git-changes: cannot find the git directory in \".git\"");
+
+	char *dir = data + strlen (prefix);
+	dir [strcspn (dir, "\r\n")] = '\0';
+	dir = eStrdup (dir);
+	eFree (data);
+	return dir;
+}
+
+static gitEntry *addEntry (gitIndex *index, const char *const name, size_t length)
+{
+	if (index->count == index->allocated)
+	{
+		index->allocated = index->allocated? index->allocated * 2: 1024;
+		index->entries = xRealloc (index->entries, index->allocated, gitEntry);
+	}
+
+	gitEntry *entry = index->entries + index->count++;
+	memset (entry, 0, sizeof (*entry));
+	entry->name = eStrndup (name, length);
+	return entry;
+}
+
+/* Fill the state of ENTRY from the working tree. ST is the cached status
+ * in the index. Returns false if the file doesn't exist. */
+static bool fillEntryState (gitEntry *entry, const unsigned char *st,
+							time_t indexMtime)
+{
+	struct stat status;
+	const uint32_t mtime = getBE32 (st + 8);
+	const uint32_t size = getBE32 (st + 36);
+
+	if (stat (entry->name, &status) != 0 || !S_ISREG (status.st_mode))
+		return false;
+
+	entry->state.mtime = (int64_t) status.st_mtime;
+	entry->state.size = (uint64_t) status.st_size;
+	/* The index has the lower 32 bits of the size. */
+	entry->state.clean = ((uint32_t) status.st_mtime == mtime
+						  && (uint32_t) status.st_size == size
+						  && (time_t) mtime < indexMtime);
+	return true;
+}
+
+/* Decode a variable length integer of the index version 4. */
+static bool getVarint (const unsigned char **pp, const unsigned char *end,
+					   size_t *value)
+{
+	const unsigned char *p = *pp;
+	size_t v;
+
+	if (p >= end)
+		return false;
+	v = *p & 0x7f;
+	while (*p++ & 0x80)
+	{
+		if (p >= end)
+			return false;
+		v = ((v + 1) << 7) | (*p & 0x7f);
+	}
+	*pp = p;
+	*value = v;
+	return true;
+}
+
+static void readIndex (gitIndex *index, const char *const gitDir)
+{
+	char *const indexName = combinePathAndFile (gitDir, "index");
+	struct stat st;
+	size_t size;
+	unsigned char *data;
+
+	if (stat (indexName, &st) != 0
+		|| (data = readWholeFile (indexName, &size)) == NULL)
+		error (FATAL | PERROR, "--git-changes: cannot open \"%s\"", indexName);
+
+	/* The header, the entries, the extensions, and the hash value */
+	const unsigned char *const end = data + size;
+	const unsigned char *p = data + 12;
+	uint32_t version = 0;
+	uint32_t count = 0;
+
+	if (size >= 12 + GIT_HASH_SIZE && memcmp (data, "DIRC", 4) == 0)
+	{
+		version = getBE32 (data + 4);
+		count = getBE32 (data + 8);
+	}
+	if (version < 2 || version > 4)
+		error (FATAL, "--git-changes: unsupported index \"%s\"", indexName);
+
+	vString *name = vStringNew ();
+	bool broken = false;
+
+	for (uint32_t i = 0; i < count && !broken; i++)
+	{
+		/* ctime, mtime, dev, ino, mode, uid, gid, size, hash, flags */
+		const unsigned char *const entry = p;
+		const size_t fixedLength = 40 + GIT_HASH_SIZE + 2;
+		uint16_t flags, xflags = 0;
+		uint32_t mode;
+
+		if ((size_t) (end - p) < fixedLength + 2)
+		{
+			broken = true;
+			break;
+		}
+		mode = getBE32 (entry + 24);
+		flags = getBE16 (entry + 40 + GIT_HASH_SIZE);
+		p += fixedLength;
+		if (version >= 3 && (flags & GIT_FLAG_EXTENDED))
+		{
+			xflags = getBE16 (p);
+			p += 2;
+		}
+
+		if (version == 4)
+		{
+			size_t strip;
+			const unsigned char *nul;
+
+			if (!getVarint (&p, end, &strip) || strip > vStringLength (name)
+				|| (nul = memchr (p, '\0', end - p)) == NULL)
+			{
+				broken = true;
+				break;
+			}
+			vStringTruncate (name, vStringLength (name) - strip);
+			vStringNCatS (name, (const char *) p, nul - p);
+			p = nul + 1;
+		}
+		else
+		{
+			const unsigned char *nul = memchr (p, '\0', end - p);
+
+			if (nul == NULL)
+			{
+				broken = true;
+				break;
+			}
+			vStringNCopyS (name, (const char *) p, nul - p);
+			/* Entries are padded with 1-8 NULs to a multiple of 8 bytes. */
+			p = entry + ((p - entry + (nul - p) + 8) & ~(size_t) 7);
+			if (p > end)
+			{
+				broken = true;
+				break;
+			}
+		}
+
+		if ((mode & GIT_MODE_TYPE) != GIT_MODE_REGULAR
+			|| (flags & GIT_FLAG_STAGE) != 0
+			|| (xflags & GIT_XFLAG_SKIP_WORKTREE))
+			continue;
+
+		gitEntry *e = addEntry (index, vStringValue (name), vStringLength (name));
+		if (fillEntryState (e, entry, st.st_mtime))
+			memcpy (e->state.hash, entry + 40, GIT_HASH_SIZE);
+		else
+		{
+			/* Removed from the working tree */
+			eFree (e->name);
+			index->count--;
+		}
+	}
+
+	if (broken)
+		error (FATAL, "--git-changes: broken index \"%s\"", indexName);
+
+	vStringDelete (name);
+	eFree (data);
+	eFree (indexName);
+}
+
+static int hexValue (int c)
+{
+	if ('0' <= c && c <= '9')
+		return c - '0';
+	if ('a' <= c && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+/* Parse a line of the manifest:
+ *   <hash or "-"> TAB <mtime> TAB <size> TAB <name> */
+static bool parseManifestLine (char *line, gitFileState *state, char **name)
+{
+	char *p = line;
+
+	memset (state, 0, sizeof (*state));
+	if (*p == '-')
+		p++;
+	else
+	{
+		for (unsigned int i = 0; i < GIT_HASH_SIZE; i++, p += 2)
+		{
+			const int hi = hexValue (p [0]);
+			const int lo = (hi < 0)? -1: hexValue (p [1]);
+			if (lo < 0)
+				return false;
+			state->hash [i] = (unsigned char) (hi << 4 | lo);
+		}
+		state->clean = true;
+	}
+
+	if (*p++ != '\t')
+		return false;
+	state->mtime = (int64_t) strtoll (p, &p, 10);
+	if (*p++ != '\t')
+		return false;
+	state->size = (uint64_t) strtoull (p, &p, 10);
+	if (*p++ != '\t' || *p == '\0')
+		return false;
+
+	*name = p;
+	return true;
+}
+
+/* Read the manifest into a table mapping the names of the files to
+ * their states. Returns NULL if there is no usable manifest. */
+static hashTable *readManifest (const gitIndex *index)
+{
+	size_t size;
+	char *data = (char *) readWholeFile (index->manifestName, &size);
+
+	if (data == NULL)
+	{
+		verbose ("no manifest \"%s\"; all the tracked files are changed\n",
+				 index->manifestName);
+		return NULL;
+	}
+
+	char *line = data;
+	char *next = strchr (line, '\n');
+	vString *header = vStringNew ();
+
+	vStringCatS (header, MANIFEST_MAGIC "\t" PROGRAM_VERSION "\t");
+	if (next == NULL
+		|| strncmp (line, vStringValue (header), vStringLength (header)) != 0
+		|| strtoull (line + vStringLength (header), NULL, 16) != index->fingerprint)
+	{
+		verbose ("the manifest \"%s\" was saved with different options; "
+				 "all the tracked files are changed\n", index->manifestName);
+		vStringDelete (header);
+		eFree (data);
+		return NULL;
+	}
+	vStringDelete (header);
+
+	hashTable *table = hashTableNew (index->count? index->count: 1,
+									 hashCstrhash, hashCstreq, eFree, eFree);
+	for (line = next + 1; *line != '\0'; line = next + 1)
+	{
+		gitFileState state;
+		char *name;
+
+		next = strchr (line, '\n');
+		if (next == NULL)
+			break;
+		*next = '\0';
+
+		if (!parseManifestLine (line, &state, &name))
+		{
+			error (WARNING, "broken line in the manifest \"%s\"",
+				   index->manifestName);
+			continue;
+		}
+		gitFileState *s = xMalloc (1, gitFileState);
+		*s = state;
+		hashTableUpdateOrPutItem (table, eStrdup (name), s);
+	}
+
+	eFree (data);
+	return table;
+}
+
+static bool isChanged (const gitFileState *current, const gitFileState *recorded)
+{
+	if (current->clean && recorded->clean)
+		return memcmp (current->hash, recorded->hash, GIT_HASH_SIZE) != 0;
+	return (current->mtime != recorded->mtime
+			|| current->size != recorded->size);
+}
+
+static bool collectRemoved (const void *key, void *value, void *user_data)
+{
+	const gitFileState *const state = value;
+	ptrArray *removed = user_data;
+
+	if (!state->seen)
+		ptrArrayAdd (removed, eStrdup (key));
+	return true;
+}
+
+static int compareNames (const void *a, const void *b)
+{
+	return strcmp (a, b);
+}
+
+extern gitIndex *gitIndexNew (const char *const manifestName)
+{
+	gitIndex *index = xCalloc (1, gitIndex);
+	char *gitDir = findGitDir ();
+
+	index->manifestName = eStrdup (manifestName);
+	index->fingerprint = getOptionsFingerprint ();
+	index->changed = ptrArrayNew (NULL);
+	index->removed = ptrArrayNew (eFree);
+
+	readIndex (index, gitDir);
+	eFree (gitDir);
+
+	hashTable *recorded = readManifest (index);
+	for (unsigned int i = 0; i < index->count; i++)
+	{
+		gitEntry *const entry = index->entries + i;
+		gitFileState *const state = recorded
+			? hashTableGetItem (recorded, entry->name)
+			: NULL;
+
+		if (state)
+			state->seen = true;
+		if (state == NULL || isChanged (&entry->state, state))
+			ptrArrayAdd (index->changed, entry->name);
+	}
+
+	if (recorded)
+	{
+		hashTableForeachItem (recorded, collectRemoved, index->removed);
+		ptrArraySort (index->removed, compareNames);
+		hashTableDelete (recorded);
+	}
+
+	verbose ("%u tracked files; %u changed, %u removed\n", index->count,
+			 ptrArrayCount (index->changed), ptrArrayCount (index->removed));
+	return index;
+}
+
+extern const ptrArray *gitIndexChangedFiles (const gitIndex *index)
+{
+	return index->changed;
+}
+
+extern const ptrArray *gitIndexRemovedFiles (const gitIndex *index)
+{
+	return index->removed;
+}
+
+extern void gitIndexSaveManifest (const gitIndex *index)
+{
+	char *tmpName = eMalloc (strlen (index->manifestName) + 5);
+	FILE *fp;
+
+	sprintf (tmpName, "%s.tmp", index->manifestName);
+	fp = fopen (tmpName, "wb");
+	if (fp == NULL)
+	{
+		error (WARNING | PERROR, "cannot create manifest \"%s\"", tmpName);
+		eFree (tmpName);
+		return;
+	}
+
+	fprintf (fp, "%s\t%s\t%016llx\n", MANIFEST_MAGIC, PROGRAM_VERSION,
+			 (unsigned long long) index->fingerprint);
+	for (unsigned int i = 0; i < index->count; i++)
+	{
+		const gitEntry *const entry = index->entries + i;
+
+		/* Such a file is changed in every run. */
+		if (strchr (entry->name, '\n'))
+			continue;
+
+		if (entry->state.clean)
+			for (unsigned int j = 0; j < GIT_HASH_SIZE; j++)
+				fprintf (fp, "%02x", entry->state.hash [j]);
+		else
+			fputc ('-', fp);
+		fprintf (fp, "\t%lld\t%llu\t%s\n", (long long) entry->state.mtime,
+				 (unsigned long long) entry->state.size, entry->name);
+	}
+
+	bool failed = ferror (fp);
+	if (fclose (fp) != 0)
+		failed = true;
+
+	if (failed)
+	{
+		error (WARNING | PERROR, "cannot write manifest \"%s\"", tmpName);
+		remove (tmpName);
+	}
+	else if (rename (tmpName, index->manifestName) != 0)
+	{
+		/* rename () doesn't overwrite an existing file on Windows. */
+		remove (index->manifestName);
+		if (rename (tmpName, index->manifestName) != 0)
+		{
+			error (WARNING | PERROR, "cannot rename \"%s\" to \"%s\"",
+				   tmpName, index->manifestName);
+			remove (tmpName);
+		}
+	}
+	eFree (tmpName);
+}
+
+extern void gitIndexDelete (gitIndex *index)
+{
+	for (unsigned int i = 0; i < index->count; i++)
+		eFree (index->entries [i].name);
+	if (index->entries)
+		eFree (index->entries);
+	ptrArrayDelete (index->changed);
+	ptrArrayDelete (index->removed);
+	eFree (index->manifestName);
+	eFree (index);
+}
@@ -0,0 +1,49 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Private interface to gitindex.c, finding the files changed since the
+*   previous run from the git index (--git-changes=MANIFEST).
+*/
+#ifndef CTAGS_MAIN_GITINDEX_PRIVATE_H
+#define CTAGS_MAIN_GITINDEX_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "ptrarray.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sGitIndex gitIndex;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Read the index of the git working tree at the current directory, and
+ * compare the tracked files with the ones recorded in MANIFESTNAME by
+ * the previous run. The options processed so far must be the same as
+ * the ones of the previous run; otherwise every file is changed. */
+extern gitIndex *gitIndexNew (const char *const manifestName);
+
+/* The names of the files whose contents may differ from the ones
+ * recorded, in the order of the index */
+extern const ptrArray *gitIndexChangedFiles (const gitIndex *index);
+
+/* The names of the files recorded but not in the working tree anymore,
+ * sorted */
+extern const ptrArray *gitIndexRemovedFiles (const gitIndex *index);
+
+/* Record the current state of the tracked files to the manifest. Call
+ * this after the tags of the changed files are written. */
+extern void gitIndexSaveManifest (const gitIndex *index);
+
+extern void gitIndexDelete (gitIndex *index);
+
+#endif	/* CTAGS_MAIN_GITINDEX_PRIVATE_H */
@@ -0,0 +1,225 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for matching a file name against a
+*   set of fnmatch () patterns, like the ones of --exclude, without
+*   trying the patterns one by one.
+*
+*   A pattern is sorted into one of three kinds when it is added:
+*
+*   - a literal, a pattern without any special character, is stored in
+*     a hash table, and looked up with the name,
+*   - a suffix, a literal after a "*" like "*.o", is stored in a trie of
+*     the reversed suffixes, and looked up by walking the name from its
+*     end,
+*   - the other patterns are matched with fnmatch () one by one.
+*
+*   Since "*" of fnmatch () without flags matches any string including
+*   "/", a pattern ending with "*" that matches a string matches every
+*   string starting with it. globSetMatchAllWithPrefix () tests the
+*   patterns ending with "*" for telling whether all the files in a
+*   directory are matched.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <fnmatch.h>
+
+#include "debug.h"
+#include "globset_p.h"
+#include "htable.h"
+#include "ptrarray.h"
+#include "routines.h"
+#include "routines_p.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sSuffixNode {
+	unsigned int child;			/* the first child, or 0 if none */
+	unsigned int sibling;		/* the next child of the parent, or 0 */
+	unsigned char c;
+	bool terminal;				/* a suffix ends at this node */
+} suffixNode;
+
+struct sGlobSet {
+	hashTable *literals;
+	suffixNode *suffixes;		/* the root of the trie is at 0 */
+	unsigned int suffixCount;
+	unsigned int suffixAllocated;
+	ptrArray *globs;
+	ptrArray *prefixClosed;		/* the patterns ending with "*" */
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern globSet *globSetNew (void)
+{
+	globSet *set = xCalloc (1, globSet);
+
+	set->literals = hashTableNew (64, hashCstrhash, hashCstreq, eFree, NULL);
+	set->suffixAllocated = 16;
+	set->suffixes = xCalloc (set->suffixAllocated, suffixNode);
+	set->suffixCount = 1;
+	set->globs = ptrArrayNew (eFree);
+	set->prefixClosed = ptrArrayNew (eFree);
+	return set;
+}
+
+extern void globSetDelete (globSet *set)
+{
+	hashTableDelete (set->literals);
+	eFree (set->suffixes);
+	ptrArrayDelete (set->globs);
+	ptrArrayDelete (set->prefixClosed);
+	eFree (set);
+}
+
+/* Convert NAME to the form in which the patterns are matched, as
+ * stringListFileFinds () does. *COPY is set to the memory to free if
+ * NAME is converted. */
+static const char *normalizeName (const char *const name, char **copy)
+{
+	*copy = NULL;
+#if defined (CASE_INSENSITIVE_FILENAMES)
+	*copy = newUpperString (name);
+#elif defined (_WIN32)
+	*copy = eStrdup (name);
+#endif
+#if defined (_WIN32)
+	for (char *p = *copy; *p != '\0'; p++)
+		if (*p == PATH_SEPARATOR)
+			*p = OUTPUT_PATH_SEPARATOR;
+#endif
+	return *copy? *copy: name;
+}
+
+static bool isLiteral (const char *s)
+{
+	return strpbrk (s, "*?[\\") == NULL;
+}
+
+static unsigned int findSuffixChild (const globSet *set, unsigned int node,
+									 unsigned char c)
+{
+	for (unsigned int n = set->suffixes [node].child; n; n = set->suffixes [n].sibling)
+		if (set->suffixes [n].c == c)
+			return n;
+	return 0;
+}
+
+static void addSuffix (globSet *set, const char *const suffix)
+{
+	unsigned int node = 0;
+
+	for (const char *p = suffix + strlen (suffix); p > suffix; p--)
+	{
+		const unsigned char c = (unsigned char) p [-1];
+		unsigned int n = findSuffixChild (set, node, c);
+
+		if (n == 0)
+		{
+			if (set->suffixCount == set->suffixAllocated)
+			{
+				set->suffixAllocated *= 2;
+				set->suffixes = xRealloc (set->suffixes, set->suffixAllocated,
+										  suffixNode);
+			}
+			n = set->suffixCount++;
+			set->suffixes [n].child = 0;
+			set->suffixes [n].sibling = set->suffixes [node].child;
+			set->suffixes [n].c = c;
+			set->suffixes [n].terminal = false;
+			set->suffixes [node].child = n;
+		}
+		node = n;
+	}
+	set->suffixes [node].terminal = true;
+}
+
+static bool matchSuffix (const globSet *set, const char *const name)
+{
+	unsigned int node = 0;
+
+	if (set->suffixes [0].terminal)
+		return true;
+
+	for (const char *p = name + strlen (name); p > name; p--)
+	{
+		node = findSuffixChild (set, node, (unsigned char) p [-1]);
+		if (node == 0)
+			return false;
+		if (set->suffixes [node].terminal)
+			return true;
+	}
+	return false;
+}
+
+extern void globSetAdd (globSet *set, const char *const pattern)
+{
+	char *p;
+	const size_t length = strlen (pattern);
+
+#ifdef CASE_INSENSITIVE_FILENAMES
+	p = newUpperString (pattern);
+#else
+	p = eStrdup (pattern);
+#endif
+
+	if (length > 0 && p [length - 1] == '*'
+		&& (length == 1 || p [length - 2] != '\\'))
+		ptrArrayAdd (set->prefixClosed, eStrdup (p));
+
+	if (isLiteral (p))
+	{
+		if (hashTableHasItem (set->literals, p))
+			eFree (p);
+		else
+			hashTablePutItem (set->literals, p, HT_INT_TO_PTR (1));
+	}
+	else if (p [0] == '*' && isLiteral (p + 1))
+	{
+		addSuffix (set, p + 1);
+		eFree (p);
+	}
+	else
+		ptrArrayAdd (set->globs, p);
+}
+
+extern bool globSetMatch (const globSet *set, const char *const fileName)
+{
+	char *copy;
+	const char *const name = normalizeName (fileName, &copy);
+	bool matched;
+
+	matched = hashTableHasItem (set->literals, name) || matchSuffix (set, name);
+	for (unsigned int i = 0; !matched && i < ptrArrayCount (set->globs); i++)
+		matched = (fnmatch (ptrArrayItem (set->globs, i), name, 0) == 0);
+
+	if (copy)
+		eFree (copy);
+	return matched;
+}
+
+extern bool globSetMatchAllWithPrefix (const globSet *set, const char *const prefix)
+{
+	char *copy;
+	const char *const name = normalizeName (prefix, &copy);
+	bool matched = false;
+
+	for (unsigned int i = 0; !matched && i < ptrArrayCount (set->prefixClosed); i++)
+		matched = (fnmatch (ptrArrayItem (set->prefixClosed, i), name, 0) == 0);
+
+	if (copy)
+		eFree (copy);
+	return matched;
+}
@@ -0,0 +1,40 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Private interface to globset.c, sets of file name patterns matched
+*   at once.
+*/
+#ifndef CTAGS_MAIN_GLOBSET_PRIVATE_H
+#define CTAGS_MAIN_GLOBSET_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sGlobSet globSet;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern globSet *globSetNew (void);
+extern void globSetDelete (globSet *set);
+
+extern void globSetAdd (globSet *set, const char *const pattern);
+
+/* Return true if FILENAME matches one of the patterns in SET, like
+ * stringListFileMatched () does. SET is not modified; it can be
+ * matched from multiple threads. */
+extern bool globSetMatch (const globSet *set, const char *const fileName);
+
+/* Return true if every name starting with PREFIX matches one of the
+ * patterns in SET. A false result doesn't mean a name doesn't match. */
+extern bool globSetMatchAllWithPrefix (const globSet *set, const char *const prefix);
+
+#endif	/* CTAGS_MAIN_GLOBSET_PRIVATE_H */
@@ -18,17 +18,28 @@
 #include <string.h>
 
 
+/* The items are stored in an open addressing table with linear
+ * probing.  The hash values of the slots are in an array of their own
+ * so that probing reads a few cache lines; the key and the value are
+ * read only when the hash value matches.  Putting an item doesn't
+ * allocate memory unless the table grows.
+ *
+ * Items for the same key are adjacent on the probe sequence starting
+ * from the home slot of the key, the newest first.  hashTablePutItem()
+ * puts an item for a key already in the table in front of the older
+ * items by shifting the rest of the run by one slot. */
 typedef struct sHashEntry hentry;
 struct sHashEntry {
 	void *key;
 	void *value;
-	unsigned int hash;
-	hentry *next;
 };
 
 struct sHashTable {
-	hentry** table;
-	unsigned int size;
+	hentry* table;				/* NULL until the first item is put */
+	unsigned int *hashes;		/* 0 for an empty slot; in the block of table */
+	unsigned int size;			/* a power of 2, or 0 */
+	unsigned int shift;			/* 32 - log2(size) */
+	unsigned int initialSize;
 	unsigned int count;
 	hashTableHashFunc hashfn;
 	hashTableEqualFunc equalfn;
@@ -38,24 +49,8 @@ struct sHashTable {
 	hashTableDeleteFunc valForNotUnknownKeyfreefn;
 };
 
-struct chainTracker {
-	const void *const target_key;
-	hashTableForeachFunc user_proc;
-	void *user_data;
-	hashTableEqualFunc equalfn;
-};
-
-static hentry* entry_new (void *key, void *value, unsigned int hash, hentry* next)
-{
-	hentry* entry = xMalloc (1, hentry);
-
-	entry->key = key;
-	entry->value = value;
-	entry->next = next;
-	entry->hash = hash;
-
-	return entry;
-}
+#define HT_MIN_SIZE 8			/* must be a power of 2 */
+#define HT_NO_SLOT ((unsigned int)-1)
 
 static void entry_reset  (hentry* entry,
 						  void *newkey,
@@ -73,99 +68,86 @@ static void entry_reset  (hentry* entry,
 	entry->value = newval;
 }
 
-static hentry* entry_destroy (hentry* entry,
-			      hashTableDeleteFunc keyfreefn,
-			      hashTableDeleteFunc valfreefn)
+/* 0 marks an empty slot. */
+static unsigned int stored_hash (unsigned int h)
 {
-	hentry* tmp;
-
-	entry_reset (entry, NULL, NULL, keyfreefn, valfreefn);
-	tmp = entry->next;
-	eFree (entry);
+	return h? h: 1;
+}
 
-	return tmp;
+/* Fibonacci hashing: take the upper bits of the product.
+ * hashPtrhash() returns aligned addresses, and their lower bits
+ * are always zero. */
+static unsigned int home_slot (const hashTable *htable, unsigned int sh)
+{
+	return (unsigned int)(((uint32_t)sh * UINT32_C(2654435769)) >> htable->shift);
 }
 
-static void  entry_reclaim (hentry* entry,
-			    hashTableDeleteFunc keyfreefn,
-			    hashTableDeleteFunc valfreefn)
+static unsigned int next_slot (const hashTable *htable, unsigned int i)
 {
-	while (entry)
-		entry = entry_destroy (entry, keyfreefn, valfreefn);
+	return (i + 1) & (htable->size - 1);
 }
 
-/* Looking for an entry having KEY as its key in the chain:
- * entry, entry->next, entry->next->next,...
- *
- * We have a chance to optimize for the case when a same key is
- * used repeatedly. By moving the entry found in the last time to
- * the head of the chain, we can avoid taking time for tracking
- * down the ->next-> chain.
- * The cost for the optimization is very small.
- */
-static void *entry_find (hentry** root_entry, const void* const key, hashTableEqualFunc equalfn,
-						 void *valForNotUnknownKey)
-{
-	hentry *entry = *root_entry;
-	hentry *last = NULL;
-	while (entry)
-	{
-		if (equalfn( key, entry->key))
-		{
-			if (last)
-			{
-				last->next = entry->next;
-				entry->next = *root_entry;
-				*root_entry = entry;
-			}
-			return entry->value;
-		}
+static unsigned int find_slot (hashTable *htable, const void *const key, unsigned int sh)
+{
+	if (htable->count == 0)
+		return HT_NO_SLOT;
 
-		last = entry;
-		entry = entry->next;
+	for (unsigned int i = home_slot (htable, sh);
+		 htable->hashes[i];
+		 i = next_slot (htable, i))
+	{
+		if (htable->hashes[i] == sh
+			&& htable->equalfn (key, htable->table[i].key))
+			return i;
 	}
-	return valForNotUnknownKey;
+	return HT_NO_SLOT;
 }
 
-static bool		entry_delete (hentry **entry, const void *key, hashTableEqualFunc equalfn,
-			      hashTableDeleteFunc keyfreefn, hashTableDeleteFunc valfreefn)
+/* Put the item into slot I, and move the items from I to the next
+ * empty slot forward by one. */
+static void insert_at (hashTable *htable, unsigned int i,
+					   unsigned int sh, hentry entry)
 {
-	while (*entry)
+	while (true)
 	{
-		if (equalfn (key, (*entry)->key))
-		{
-			*entry = entry_destroy (*entry, keyfreefn, valfreefn);
-			return true;
-		}
-		entry = &((*entry)->next);
+		unsigned int tmp_sh = htable->hashes[i];
+		hentry tmp = htable->table[i];
+
+		htable->hashes[i] = sh;
+		htable->table[i] = entry;
+		if (tmp_sh == 0)
+			break;
+		sh = tmp_sh;
+		entry = tmp;
+		i = next_slot (htable, i);
 	}
-	return false;
 }
 
-static bool		entry_update (hentry *entry, void *key, void *value, hashTableEqualFunc equalfn,
-			      hashTableDeleteFunc keyfreefn, hashTableDeleteFunc valfreefn)
+static unsigned int slot_distance (const hashTable *htable,
+								   unsigned int from, unsigned int to)
 {
-	while (entry)
-	{
-		if (equalfn (key, entry->key))
-		{
-			entry_reset (entry, key, value, keyfreefn, valfreefn);
-			return true;
-		}
-		entry = entry->next;
-	}
-	return false;
+	return (to - from) & (htable->size - 1);
 }
 
-static bool  entry_foreach (hentry *entry, hashTableForeachFunc proc, void *user_data)
+/* Fill the slot I emptied by deletion with the items following it
+ * on the run (backward shift deletion). */
+static void remove_at (hashTable *htable, unsigned int i)
 {
-	while (entry)
+	for (unsigned int j = next_slot (htable, i);
+		 htable->hashes[j];
+		 j = next_slot (htable, j))
 	{
-		if (!proc (entry->key, entry->value, user_data))
-			return false;
-		entry = entry->next;
+		unsigned int k = home_slot (htable, htable->hashes[j]);
+
+		/* Can the item at J move to I without leaving its run? */
+		if (slot_distance (htable, k, j) >= slot_distance (htable, i, j))
+		{
+			htable->hashes[i] = htable->hashes[j];
+			htable->table[i] = htable->table[j];
+			i = j;
+		}
 	}
-	return true;
+	htable->hashes[i] = 0;
 }
 
 extern hashTable *hashTableNew    (unsigned int size,
@@ -178,14 +160,14 @@ extern hashTable *hashTableNew    (unsigned int size,
 
 	htable = xMalloc (1, hashTable);
 
-	if (size < 3)
-		size = 3;
-	if ((size % 2) == 0)
-		size++;
-
-	htable->size = size;
+	htable->hashes = NULL;
+	htable->table = NULL;
+	htable->size = 0;
+	htable->shift = 32;
+	htable->initialSize = HT_MIN_SIZE;
+	while (htable->initialSize < size && htable->initialSize < (1U << 30))
+		htable->initialSize *= 2;
 	htable->count = 0;
-	htable->table = xCalloc (size, hentry*);
 
 	htable->hashfn = hashfn;
 	htable->equalfn = equalfn;
@@ -217,7 +199,8 @@ extern void       hashTableDelete (hashTable *htable)
 
 	if (htable->valForNotUnknownKeyfreefn)
 		htable->valForNotUnknownKeyfreefn (htable->valForNotUnknownKey);
-	eFree (htable->table);
+	if (htable->table)
+		eFree (htable->table);
 	eFree (htable);
 }
 
@@ -229,82 +212,78 @@ extern void       hashTableClear (hashTable *htable)
 
 	for (i = 0; i < htable->size; i++)
 	{
-		hentry *entry;
-
-		entry = htable->table[i];
-		entry_reclaim (entry, htable->keyfreefn, htable->valfreefn);
-		htable->table[i] = NULL;
+		if (!htable->hashes[i])
+			continue;
+		entry_reset (htable->table + i, NULL, NULL, htable->keyfreefn, htable->valfreefn);
+		htable->hashes[i] = 0;
 	}
-}
-
-static void       hashTablePutItem00    (hashTable *htable, void *key, void *value, unsigned int h)
-{
-	unsigned int i = h % htable->size;
-	htable->table[i] = entry_new(key, value, h, htable->table[i]);
-	htable->count++;
-}
-
-/* "doubling" primes smaller than 2^32 */
-static const unsigned int primes[] = {
-	3, 7, 17, 37, 79, 163, 331, 673, 1361, 2729, 5471, 10949, 21911,
-	43853, 87719, 175447, 350899, 701819, 1403641, 2807303, 5614657,
-	11229331, 22458671, 44917381, 89834777, 179669557, 359339171,
-	718678369, 1437356741, 2874713497,
-};
-
-static unsigned int
-prime_double(unsigned int i)
-{
-	unsigned int j;
-
-	Assert (i > 2);
-	Assert (i % 2);
-
-	for (j = 0; j < sizeof(primes) / sizeof(primes[0]); ++j)
-		if (primes[j] > i)
-			return primes[j];
-
-	return i;
+	htable->count = 0;
 }
 
 static void       hashTableGrow        (hashTable *htable)
 {
-	unsigned int current_size = htable->size;
-	unsigned int new_size = prime_double (current_size);
+	unsigned int *old_hashes = htable->hashes;
+	hentry *old_table = htable->table;
+	unsigned int old_size = htable->size;
+	unsigned int new_size = old_size? old_size * 2: htable->initialSize;
+	unsigned int start;
+
+	htable->table = eMalloc (new_size * (sizeof (hentry) + sizeof (unsigned int)));
+	htable->hashes = (unsigned int *)(htable->table + new_size);
+	memset (htable->hashes, 0, new_size * sizeof (unsigned int));
+	htable->size = new_size;
+	htable->shift = 32;
+	while (new_size > 1)
+	{
+		htable->shift--;
+		new_size >>= 1;
+	}
 
-	if (new_size <= current_size)
+	if (old_table == NULL)
 		return;
 
-	hentry** new_table = xCalloc (new_size, hentry*);
-	for (unsigned int i = 0; i < current_size; i++)
+	/* Start from the head of a run so that the items for a key are
+	 * visited in the order on their probe sequence. */
+	for (start = 0; old_hashes[start]; start++)
+		;
+	for (unsigned int n = 0; n < old_size; n++)
 	{
-		hentry *entry;
-		while ((entry = htable->table[i]))
-		{
-			unsigned int hash = entry->hash;
-			unsigned int j = hash % new_size;
-			htable->table[i] = entry->next;
-			entry->next = new_table[j];
-			new_table[j] = entry;
-		}
-	}
+		unsigned int j = (start + n) & (old_size - 1);
+		unsigned int sh = old_hashes[j];
 
-	hentry** old_table = htable->table;
-	htable->table = new_table;
-	htable->size = new_size;
+		if (!sh)
+			continue;
+
+		unsigned int i = home_slot (htable, sh);
+		while (htable->hashes[i])
+			i = next_slot (htable, i);
+		htable->hashes[i] = sh;
+		htable->table[i] = old_table[j];
+	}
 	eFree (old_table);
 }
 
 static void       hashTablePutItem0    (hashTable *htable, void *key, void *value, unsigned int h)
 {
-	if (((double)htable->count / (double)htable->size) < 0.8)
+	/* Keep the load factor at most 3/4. */
+	if ((htable->count + 1) * 4 > htable->size * 3)
+		hashTableGrow (htable);
+
+	hentry entry = {
+		.key = key,
+		.value = value,
+	};
+	unsigned int sh = stored_hash (h);
+	unsigned int i;
+
+	for (i = home_slot (htable, sh); htable->hashes[i]; i = next_slot (htable, i))
 	{
-		hashTablePutItem00 (htable, key, value,  h);
-		return;
+		if (htable->hashes[i] == sh
+			&& htable->equalfn (key, htable->table[i].key))
+			break;
 	}
-
-	hashTableGrow (htable);
-	hashTablePutItem00 (htable, key, value, h);
+	insert_at (htable, i, sh, entry);
+	htable->count++;
 }
 
 extern void       hashTablePutItem    (hashTable *htable, void *key, void *value)
@@ -314,36 +293,38 @@ extern void       hashTablePutItem    (hashTable *htable, void *key, void *value
 
 extern void*      hashTableGetItem   (hashTable *htable, const void * key)
 {
-	unsigned int h, i;
+	unsigned int i;
 
-	h = htable->hashfn (key);
-	i = h % htable->size;
-	return entry_find(& (htable->table[i]), key, htable->equalfn, htable->valForNotUnknownKey);
+	i = find_slot (htable, key, stored_hash (htable->hashfn (key)));
+	if (i == HT_NO_SLOT)
+		return htable->valForNotUnknownKey;
+	return htable->table[i].value;
 }
 
 extern bool     hashTableDeleteItem (hashTable *htable, const void *key)
 {
-	unsigned int h;
 	unsigned int i;
-	h = htable->hashfn (key);
-	i = h % htable->size;
 
-	bool r = entry_delete(&htable->table[i], key,
-			    htable->equalfn, htable->keyfreefn, htable->valfreefn);
-	if (r)
-		htable->count--;
-	return r;
+	i = find_slot (htable, key, stored_hash (htable->hashfn (key)));
+	if (i == HT_NO_SLOT)
+		return false;
+
+	entry_reset (htable->table + i, NULL, NULL, htable->keyfreefn, htable->valfreefn);
+	remove_at (htable, i);
+	htable->count--;
+	return true;
 }
 
 extern bool    hashTableUpdateItem (hashTable *htable, const void *key, void *value)
 {
-	unsigned int h, i;
+	unsigned int i;
 
-	h = htable->hashfn (key);
-	i = h % htable->size;
-	bool r = entry_update(htable->table[i], (void *)key, value,
-						  htable->equalfn, NULL, htable->valfreefn);
-	return r;
+	i = find_slot (htable, key, stored_hash (htable->hashfn (key)));
+	if (i == HT_NO_SLOT)
+		return false;
+
+	entry_reset (htable->table + i, (void *)key, value, NULL, htable->valfreefn);
+	return true;
 }
 
 extern bool    hashTableUpdateOrPutItem (hashTable *htable, void *key, void *value)
@@ -351,13 +332,15 @@ extern bool    hashTableUpdateOrPutItem (hashTable *htable, void *key, void *val
 	unsigned int h, i;
 
 	h = htable->hashfn (key);
-	i = h % htable->size;
-	bool r = entry_update(htable->table[i], key, value,
-						  htable->equalfn, NULL, htable->valfreefn);
-	if (!r)
+	i = find_slot (htable, key, stored_hash (h));
+	if (i == HT_NO_SLOT)
+	{
 		hashTablePutItem0(htable, key, value, h);
+		return false;
+	}
 
-	return r;
+	entry_reset (htable->table + i, key, value, NULL, htable->valfreefn);
+	return true;
 }
 
 extern bool    hashTableHasItem    (hashTable *htable, const void *key)
@@ -370,18 +353,9 @@ extern bool       hashTableForeachItem (hashTable *htable, hashTableForeachFunc
 	unsigned int i;
 
 	for (i = 0; i < htable->size; i++)
-		if (!entry_foreach(htable->table[i], proc, user_data))
-			return false;
-	return true;
-}
-
-static bool track_chain (const void *const key, void *value, void *chain_data)
-{
-	struct chainTracker *chain_tracker = chain_data;
-
-	if (chain_tracker->equalfn (chain_tracker->target_key, key))
 	{
-		if (! chain_tracker->user_proc (key, value, chain_tracker->user_data))
+		hentry *entry = htable->table + i;
+		if (htable->hashes[i] && !proc (entry->key, entry->value, user_data))
 			return false;
 	}
 	return true;
@@ -390,54 +364,49 @@ static bool track_chain (const void *const key, void *value, void *chain_data)
 extern bool       hashTableForeachItemOnChain (hashTable *htable, const void *key, hashTableForeachFunc proc, void *user_data)
 {
 	unsigned int h, i;
-	struct chainTracker chain_tracker = {
-		.target_key = key,
-		.user_proc = proc,
-		.user_data = user_data,
-		.equalfn   = htable->equalfn,
-	};
 
-	h = htable->hashfn (key);
-	i = h % htable->size;
-	if (!entry_foreach(htable->table[i], track_chain, &chain_tracker))
-		return false;
+	if (htable->count == 0)
+		return true;
+
+	h = stored_hash (htable->hashfn (key));
+	for (i = home_slot (htable, h); htable->hashes[i]; i = next_slot (htable, i))
+	{
+		hentry *entry = htable->table + i;
+		if (htable->hashes[i] == h && htable->equalfn (key, entry->key))
+		{
+			if (!proc (entry->key, entry->value, user_data))
+				return false;
+		}
+	}
 	return true;
 }
 
 extern void hashTablePrintStatistics(hashTable *htable)
 {
 	if (htable->size == 0 || htable->count == 0)
+	{
 		fprintf(stderr, "size: %u, count: %u, average: 0\n",
 				htable->size, htable->count);
+		return;
+	}
 
+	/* The distance of each item from its home slot */
 	double sum = 0.0;
-	for (size_t i = 0; i < htable->size; i++)
+	unsigned int max = 0;
+	for (unsigned int i = 0; i < htable->size; i++)
 	{
-		hentry *e = htable->table[i];
-		while (e)
-		{
-			sum += 1.0;
-			e = e->next;
-		}
-	}
-	double average = sum / (double)htable->size;
+		if (!htable->hashes[i])
+			continue;
 
-	double variance = 0.0;
-	for (size_t i = 0; i < htable->size; i++)
-	{
-		double sum0 = 0;
-		hentry *e = htable->table[i];
-		while (e)
-		{
-			sum0 += 1.0;
-			e = e->next;
-		}
-		double d = sum0 - average;
-		variance += (d * d);
+		unsigned int d = slot_distance (htable, home_slot (htable, htable->hashes[i]), i);
+		sum += (double)d;
+		if (d > max)
+			max = d;
 	}
-	variance = variance / (double)htable->size;
-	fprintf(stderr, "size: %u, count: %u, average: %lf, s.d.: sqrt(%lf)\n",
-			htable->size, htable->count, average, variance);
+	fprintf(stderr, "size: %u, count: %u, load: %lf, average distance: %lf, max distance: %u\n",
+			htable->size, htable->count,
+			(double)htable->count / (double)htable->size,
+			sum / (double)htable->count, max);
 }
 
 extern unsigned int hashTableCountItem   (hashTable *htable)
@@ -0,0 +1,470 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for excluding the files matched by
+*   the patterns of .gitignore, .ignore, and .git/info/exclude from
+*   --recurse (--use-ignore-files).
+*
+*   The patterns are interpreted as gitignore (5) describes. A pattern
+*   without a slash except at its end matches the base name of a file at
+*   any level below the directory of the ignore file; the other patterns
+*   match the path relative to that directory, where "*" and "?" don't
+*   match a slash and "**" matches any number of directories. A pattern
+*   ending with a slash matches only a directory, and a pattern starting
+*   with "!" re-includes the files an earlier pattern excludes.
+*
+*   A directory visited by the recursion has its own rules, linked to the
+*   rules of its parent directory. The last pattern matching a file in the
+*   innermost directory having one decides; .ignore takes precedence over
+*   .gitignore in the same directory, and .git/info/exclude has the
+*   lowest precedence. An ignored directory is not read at all, so a
+*   pattern can't re-include a file in it, as git does.
+*
+*   The top directory of the recursion also applies the ignore files in
+*   its parent directories, up to the top of the git working tree, the
+*   directory having .git. The names of the files are made relative to
+*   those directories by prepending the path of the top directory.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+
+#include "debug.h"
+#include "ignore_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sIgnoreRule {
+	char *pattern;
+	bool negated;				/* "!pattern" */
+	bool directoryOnly;			/* "pattern/" */
+	bool anchored;				/* matched against the path, not the base name */
+} ignoreRule;
+
+struct sIgnoreRules {
+	ignoreRules *parent;
+	bool ownsParent;			/* the parent is made for the top directory */
+
+	/* The path of a file relative to the directory of the rules is
+	 * PREFIX followed by the name of the file after BASELENGTH bytes.
+	 * PREFIX is NULL except for the parent directories of the top. */
+	size_t baseLength;
+	char *prefix;
+
+	ignoreRule *rules;
+	unsigned int count;
+	unsigned int allocated;
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/* Return 1 if C is in the bracket expression at *PP, 0 if not, and -1
+ * if the expression is not terminated. *PP is moved to the closing
+ * bracket. */
+static int matchBracket (const char **pp, unsigned char c)
+{
+	const char *q = *pp + 1;
+	bool negated = false;
+	bool matched = false;
+
+	if (*q == '!' || *q == '^')
+	{
+		negated = true;
+		q++;
+	}
+
+	for (bool first = true; *q != '\0' && (*q != ']' || first); q++, first = false)
+	{
+		unsigned char lo = (unsigned char) *q;
+
+		if (lo == '\\' && q [1] != '\0')
+			lo = (unsigned char) *++q;
+		if (q [1] == '-' && q [2] != '\0' && q [2] != ']')
+		{
+			unsigned char hi = (unsigned char) q [2];
+
+			q += 2;
+			if (hi == '\\' && q [1] != '\0')
+				hi = (unsigned char) *++q;
+			if (lo <= c && c <= hi)
+				matched = true;
+		}
+		else if (lo == c)
+			matched = true;
+	}
+
+	if (*q != ']')
+		return -1;
+	*pp = q;
+	return (matched != negated);
+}
+
+/* Match TEXT against P, a part of PATTERN. */
+static bool wildmatch (const char *const pattern, const char *p, const char *text)
+{
+	const char *t = text;
+
+	for (; *p != '\0'; p++, t++)
+	{
+		switch (*p)
+		{
+			case '?':
+				if (*t == '\0' || *t == '/')
+					return false;
+				break;
+			case '*':
+			{
+				const char *rest = p;
+
+				while (*rest == '*')
+					rest++;
+
+				/* "**" as a whole component of the path */
+				if (rest - p >= 2 && (p == pattern || p [-1] == '/'))
+				{
+					if (*rest == '\0')
+						return true;
+					if (*rest == '/')
+					{
+						for (const char *s = t; s != NULL; s = strchr (s, '/'))
+						{
+							if (*s == '/')
+								s++;
+							if (wildmatch (pattern, rest + 1, s))
+								return true;
+						}
+						return false;
+					}
+				}
+
+				for (const char *s = t; ; s++)
+				{
+					if (wildmatch (pattern, rest, s))
+						return true;
+					if (*s == '\0' || *s == '/')
+						return false;
+				}
+			}
+			case '[':
+			{
+				const char *q = p;
+				int r;
+
+				if (*t == '\0' || *t == '/')
+					return false;
+				r = matchBracket (&q, (unsigned char) *t);
+				if (r < 0)
+				{
+					/* Not a bracket expression */
+					if (*t != '[')
+						return false;
+				}
+				else if (r == 0)
+					return false;
+				else
+					p = q;
+				break;
+			}
+			case '\\':
+				if (p [1] != '\0')
+					p++;
+				/* Fall through */
+			default:
+				if (*t != *p)
+					return false;
+				break;
+		}
+	}
+	return (*t == '\0');
+}
+
+static void addRule (ignoreRules *rules, vString *line)
+{
+	char *s = vStringValue (line);
+	size_t length = vStringLength (line);
+	ignoreRule rule = { .negated = false, };
+
+	/* Trailing spaces are ignored unless they are quoted with a
+	 * backslash. */
+	while (length > 0 && s [length - 1] == ' '
+		   && !(length > 1 && s [length - 2] == '\\'))
+		length--;
+	s [length] = '\0';
+
+	if (length == 0 || s [0] == '#')
+		return;
+
+	if (s [0] == '!')
+	{
+		rule.negated = true;
+		s++;
+		length--;
+	}
+
+	if (length > 0 && s [length - 1] == '/')
+	{
+		rule.directoryOnly = true;
+		s [--length] = '\0';
+	}
+
+	if (strchr (s, '/') != NULL)
+	{
+		rule.anchored = true;
+		if (s [0] == '/')
+			s++;
+	}
+
+	if (*s == '\0')
+		return;
+
+	if (rules->count == rules->allocated)
+	{
+		rules->allocated = rules->allocated? rules->allocated * 2: 8;
+		rules->rules = xRealloc (rules->rules, rules->allocated, ignoreRule);
+	}
+	rule.pattern = eStrdup (s);
+	rules->rules [rules->count++] = rule;
+}
+
+static void readRules (ignoreRules *rules, const char *const dirName,
+					   const char *const fileName)
+{
+	char *path = combinePathAndFile (dirName, fileName);
+	FILE *fp = fopen (path, "r");
+	vString *line;
+	int c;
+
+	eFree (path);
+	if (fp == NULL)
+		return;
+
+	line = vStringNew ();
+	do
+	{
+		c = getc (fp);
+		if (c == '\n' || c == EOF)
+		{
+			if (vStringLength (line) > 0 && vStringLast (line) == '\r')
+				vStringChop (line);
+			addRule (rules, line);
+			vStringClear (line);
+		}
+		else
+			vStringPut (line, c);
+	} while (c != EOF);
+	vStringDelete (line);
+	fclose (fp);
+}
+
+static ignoreRules *newRules (ignoreRules *parent, bool ownsParent,
+							  size_t baseLength, const char *const prefix)
+{
+	ignoreRules *rules = xCalloc (1, ignoreRules);
+
+	rules->parent = parent;
+	rules->ownsParent = ownsParent;
+	rules->baseLength = baseLength;
+	rules->prefix = (prefix && *prefix)? eStrdup (prefix): NULL;
+	return rules;
+}
+
+/* The length of the prefix of the names the recursion makes for the
+ * files in DIRNAME; see recurseIntoDirectory () in main.c. */
+static size_t baseLengthOf (const char *const dirName)
+{
+	if (strcmp (dirName, ".") == 0)
+		return 0;
+
+	char *const prefix = combinePathAndFile (dirName, "");
+	const size_t length = strlen (prefix);
+	eFree (prefix);
+	return length;
+}
+
+static bool isWorkingTreeTop (const char *const path, size_t length)
+{
+	struct stat st;
+	char *const dir = eStrndup (path, length);
+	char *const git = combinePathAndFile (dir, ".git");
+	const bool r = (stat (git, &st) == 0);
+
+	eFree (git);
+	eFree (dir);
+	return r;
+}
+
+/* The length of the parent directory of the first LENGTH bytes of PATH,
+ * an absolute path. It is LENGTH for "/". */
+static size_t parentLength (const char *const path, size_t length)
+{
+	while (length > 0 && path [length - 1] != '/')
+		length--;
+	if (length > 1)
+		length--;
+	return length;
+}
+
+/* The path of TOP relative to its first DIRLENGTH bytes */
+static const char *relativeTop (const char *const top, size_t dirLength)
+{
+	return top + dirLength + (top [dirLength] == '/');
+}
+
+/* Make the rules of .git/info/exclude and the parent directories of
+ * TOPNAME up to the top of the working tree. Returns NULL if TOPNAME is
+ * not in a working tree. */
+static ignoreRules *newAncestorRules (const char *const topName, size_t baseLength)
+{
+	char *const top = absoluteFilename (topName);
+	size_t length = strlen (top);
+	size_t rootLength;
+	ignoreRules *rules;
+
+	while (length > 1 && top [length - 1] == '/')
+		top [--length] = '\0';
+
+	for (rootLength = length; ! isWorkingTreeTop (top, rootLength); )
+	{
+		const size_t parent = parentLength (top, rootLength);
+		if (parent == rootLength)
+		{
+			eFree (top);
+			return NULL;
+		}
+		rootLength = parent;
+	}
+
+	vString *const prefix = vStringNew ();
+	char *dir = eStrndup (top, rootLength);
+	char *const gitDir = combinePathAndFile (dir, ".git");
+	char *const infoDir = combinePathAndFile (gitDir, "info");
+
+	vStringCopyS (prefix, relativeTop (top, rootLength));
+	if (vStringLength (prefix) > 0)
+		vStringPut (prefix, '/');
+	rules = newRules (NULL, false, baseLength, vStringValue (prefix));
+	readRules (rules, infoDir, "exclude");
+	eFree (infoDir);
+	eFree (gitDir);
+
+	for (size_t dirLength = rootLength; dirLength < length; )
+	{
+		rules = newRules (rules, true, baseLength, vStringValue (prefix));
+		readRules (rules, dir, ".gitignore");
+		readRules (rules, dir, ".ignore");
+
+		/* Go down to the next directory. */
+		dirLength = relativeTop (top, dirLength) - top;
+		while (dirLength < length && top [dirLength] != '/')
+			dirLength++;
+		eFree (dir);
+		dir = eStrndup (top, dirLength);
+		vStringCopyS (prefix, relativeTop (top, dirLength));
+		if (vStringLength (prefix) > 0)
+			vStringPut (prefix, '/');
+	}
+
+	eFree (dir);
+	vStringDelete (prefix);
+	eFree (top);
+	return rules;
+}
+
+extern ignoreRules *ignoreRulesNew (ignoreRules *parent, const char *const dirName)
+{
+	const size_t baseLength = baseLengthOf (dirName);
+	bool ownsParent = false;
+	ignoreRules *rules;
+
+	if (parent == NULL)
+	{
+		parent = newAncestorRules (dirName, baseLength);
+		ownsParent = true;
+	}
+
+	rules = newRules (parent, ownsParent, baseLength, NULL);
+	readRules (rules, dirName, ".gitignore");
+	readRules (rules, dirName, ".ignore");
+	return rules;
+}
+
+extern void ignoreRulesDelete (ignoreRules *rules)
+{
+	while (rules)
+	{
+		ignoreRules *parent = rules->ownsParent? rules->parent: NULL;
+
+		for (unsigned int i = 0; i < rules->count; i++)
+			eFree (rules->rules [i].pattern);
+		if (rules->rules)
+			eFree (rules->rules);
+		if (rules->prefix)
+			eFree (rules->prefix);
+		eFree (rules);
+		rules = parent;
+	}
+}
+
+extern bool isIgnoredByRules (const ignoreRules *rules, const char *const name,
+							  bool isDirectory)
+{
+	const char *const base = baseFilename (name);
+	vString *path = NULL;
+	bool ignored = false;
+	bool decided = false;
+
+	for (; rules && !decided; rules = rules->parent)
+	{
+		const char *relative;
+
+		if (rules->count == 0)
+			continue;
+
+		Assert (strlen (name) >= rules->baseLength);
+		relative = name + rules->baseLength;
+		if (rules->prefix)
+		{
+			if (path == NULL)
+				path = vStringNew ();
+			vStringCopyS (path, rules->prefix);
+			vStringCatS (path, relative);
+			relative = vStringValue (path);
+		}
+
+		for (unsigned int i = rules->count; i > 0; i--)
+		{
+			const ignoreRule *const rule = rules->rules + i - 1;
+			const char *const text = rule->anchored? relative: base;
+
+			if (rule->directoryOnly && !isDirectory)
+				continue;
+			if (wildmatch (rule->pattern, rule->pattern, text))
+			{
+				ignored = !rule->negated;
+				decided = true;
+				break;
+			}
+		}
+	}
+
+	if (path)
+		vStringDelete (path);
+	return ignored;
+}
@@ -0,0 +1,44 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Private interface to ignore.c, the rules of .gitignore, .ignore, and
+*   .git/info/exclude applied by --recurse (--use-ignore-files).
+*/
+#ifndef CTAGS_MAIN_IGNORE_PRIVATE_H
+#define CTAGS_MAIN_IGNORE_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sIgnoreRules ignoreRules;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Make the rules applied to the files in DIRNAME, a directory visited by
+ * the recursion: the ones of PARENT, the rules of the parent directory,
+ * and the ones read from the ignore files in DIRNAME. If PARENT is NULL,
+ * DIRNAME is the top of the recursion, and the ignore files in its
+ * parent directories up to the top of the git working tree are also
+ * read. The rules don't touch global states; they can be made and
+ * matched in any thread. */
+extern ignoreRules *ignoreRulesNew (ignoreRules *parent, const char *const dirName);
+
+/* Delete RULES, which must be deleted before the rules given as PARENT. */
+extern void ignoreRulesDelete (ignoreRules *rules);
+
+/* NAME is the path of a file in the directory of RULES, as the
+ * recursion makes it. */
+extern bool isIgnoredByRules (const ignoreRules *rules, const char *const name,
+							  bool isDirectory);
+
+#endif	/* CTAGS_MAIN_IGNORE_PRIVATE_H */
@@ -0,0 +1,515 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for parsing input files in worker
+*   processes (--jobs=N).
+*
+*   The main process queues the names of input files instead of parsing
+*   them. When the queue is flushed, N worker processes are forked. The
+*   parent passes the indexes of the queued files to the workers through
+*   a pipe; each worker parses the files it receives, writes their tags
+*   to its own temporary file, and records where the tags of each file
+*   end in a second temporary file. After all the workers exit, the
+*   parent concatenates the outputs in the order of the queue. The
+*   result is the same as the tag file made without --jobs.
+*
+*   Parser specific pseudo tags are written only once, before the tags
+*   of the first file parsed with the parser. Workers don't write them;
+*   they record the request, and the parent emits the pseudo tags while
+*   concatenating.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "jobs_p.h"
+
+#ifdef HAVE_JOBS
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
+#include <unistd.h>
+#endif
+
+#include "debug.h"
+#include "entry_p.h"
+#include "options_p.h"
+#include "parse_p.h"
+#include "profile_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "stats_p.h"
+#include "strlist.h"
+#include "writer_p.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+#ifdef HAVE_JOBS
+typedef enum eJobRecordType {
+	JOB_RECORD_PTAG,			/* parser specific pseudo tags are requested */
+	JOB_RECORD_FILE,			/* parsing a file is done */
+	JOB_RECORD_TOTALS,			/* the worker is done */
+} jobRecordType;
+
+typedef struct sJobRecord {
+	jobRecordType type;
+	unsigned int index;			/* index of the file in JobQueue */
+	long offset;				/* position in the output of the worker */
+	langType language;			/* JOB_RECORD_PTAG */
+	unsigned long tags;			/* JOB_RECORD_FILE */
+	bool resize;				/* JOB_RECORD_FILE */
+	profileRecord profile;		/* JOB_RECORD_FILE, with --profile */
+	long files, lines, bytes;	/* JOB_RECORD_TOTALS */
+} jobRecord;
+
+typedef struct sJobWorker {
+	pid_t pid;
+	char *outputName;
+	char *recordName;
+
+	/* Used in the parent process after the worker exits */
+	FILE *output;
+	long outputOffset;
+	jobRecord *records;
+	size_t count;
+	size_t cursor;
+} jobWorker;
+#endif
+
+/*
+*   DATA DEFINITIONS
+*/
+static stringList *JobQueue;
+
+#ifdef HAVE_JOBS
+static FILE *WorkerRecords;		/* non-NULL only in a worker process */
+static unsigned int WorkerCurrentIndex;
+static jobRecord *WorkerPtags;	/* requested while parsing the current file */
+static size_t WorkerPtagCount;
+static size_t WorkerPtagAllocated;
+#endif
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern bool jobsEnabled (void)
+{
+#ifdef HAVE_JOBS
+	return (Option.jobs > 1
+			&& !Option.filter
+			&& !Option.printLanguage
+			&& !Option.interactive
+			&& tagFileMio () != NULL);
+#else
+	return false;
+#endif
+}
+
+extern void queueJob (const char *const fileName)
+{
+	if (JobQueue == NULL)
+		JobQueue = stringListNew ();
+	stringListAdd (JobQueue, vStringNewInit (fileName));
+}
+
+static bool parseQueuedFiles (void)
+{
+	bool resize = false;
+
+	for (unsigned int i = 0; i < stringListCount (JobQueue); i++)
+		resize |= parseFile (vStringValue (stringListItem (JobQueue, i)));
+	return resize;
+}
+
+#ifdef HAVE_JOBS
+extern bool isJobWorker (void)
+{
+	return WorkerRecords != NULL;
+}
+
+static void writeJobRecord (const jobRecord *const record)
+{
+	if (fwrite (record, sizeof (*record), 1, WorkerRecords) != 1)
+		error (FATAL | PERROR, "cannot write to job record file");
+}
+
+extern void requestParserPseudoTagsForJob (langType language)
+{
+	jobRecord record = {
+		.type = JOB_RECORD_PTAG,
+		.index = WorkerCurrentIndex,
+		.offset = mio_tell (tagFileMio ()),
+		.language = language,
+	};
+
+	Assert (isJobWorker ());
+	if (WorkerPtagCount == WorkerPtagAllocated)
+	{
+		WorkerPtagAllocated = WorkerPtagAllocated? WorkerPtagAllocated * 2: 8;
+		WorkerPtags = xRealloc (WorkerPtags, WorkerPtagAllocated, jobRecord);
+	}
+	WorkerPtags [WorkerPtagCount++] = record;
+}
+
+/* Write the requests of pseudo tags made while parsing a file. If the
+ * tags of the file are discarded, an offset may be after the output of
+ * the file, END. */
+static void writeWorkerPtags (long end)
+{
+	for (size_t i = 0; i < WorkerPtagCount; i++)
+	{
+		if (WorkerPtags [i].offset > end)
+			WorkerPtags [i].offset = end;
+		writeJobRecord (WorkerPtags + i);
+	}
+	WorkerPtagCount = 0;
+}
+
+static bool readJobIndex (int fd, unsigned int *index)
+{
+	ssize_t r;
+
+	/* The parent writes whole indexes in single write(2) calls smaller
+	 * than PIPE_BUF, so a read never returns a partial index. */
+	do
+		r = read (fd, index, sizeof (*index));
+	while (r < 0 && errno == EINTR);
+
+	if (r < 0)
+		error (FATAL | PERROR, "cannot read job index");
+	return (r == sizeof (*index));
+}
+
+static void runWorker (jobWorker *const worker, int fd)
+{
+	long files, lines, bytes;
+	unsigned int index;
+	MIO *mio;
+
+	mio = mio_new_file (worker->outputName, "wb");
+	if (mio == NULL)
+		error (FATAL | PERROR, "cannot open job output file \"%s\"", worker->outputName);
+	WorkerRecords = fopen (worker->recordName, "wb");
+	if (WorkerRecords == NULL)
+		error (FATAL | PERROR, "cannot open job record file \"%s\"", worker->recordName);
+
+	/* The parent's tag file is left as is; it is flushed before forking. */
+	setTagFileMio (mio);
+	getTotals (&files, &lines, &bytes);
+
+	while (readJobIndex (fd, &index))
+	{
+		const char *const fileName = vStringValue (stringListItem (JobQueue, index));
+		const unsigned long tags = numTagsAdded ();
+		jobRecord record = {
+			.type = JOB_RECORD_FILE,
+			.index = index,
+		};
+
+		WorkerCurrentIndex = index;
+		record.resize = parseFile (fileName);
+		record.offset = mio_tell (mio);
+		record.tags = numTagsAdded () - tags;
+		writeWorkerPtags (record.offset);
+		if (Profiling)
+			record.profile = *getLastProfileRecord ();
+		writeJobRecord (&record);
+	}
+	close (fd);
+
+	jobRecord totals = { .type = JOB_RECORD_TOTALS, };
+	getTotals (&totals.files, &totals.lines, &totals.bytes);
+	totals.files -= files;
+	totals.lines -= lines;
+	totals.bytes -= bytes;
+	writeJobRecord (&totals);
+
+	if (mio_unref (mio) != 0)
+		error (FATAL | PERROR, "cannot close job output file \"%s\"", worker->outputName);
+	if (fclose (WorkerRecords) != 0)
+		error (FATAL | PERROR, "cannot close job record file \"%s\"", worker->recordName);
+	fflush (stderr);
+
+	/* Don't run the clean up handlers of the parent. */
+	_exit (0);
+}
+
+static char *makeTempFileName (void)
+{
+	char *name = NULL;
+	FILE *fp = tempFileFP ("w", &name);
+
+	fclose (fp);
+	return name;
+}
+
+static void sendJobIndexes (int fd, unsigned int count)
+{
+	/* 512 is the smallest PIPE_BUF allowed by POSIX. */
+	unsigned int buf [512 / sizeof (unsigned int)];
+	unsigned int i = 0;
+	void (* handler) (int) = signal (SIGPIPE, SIG_IGN);
+
+	while (i < count)
+	{
+		size_t n = 0;
+		while (n < ARRAY_SIZE (buf) && i < count)
+			buf [n++] = i++;
+
+		ssize_t r;
+		do
+			r = write (fd, buf, n * sizeof (buf [0]));
+		while (r < 0 && errno == EINTR);
+
+		/* All workers are gone. Let waitpid() tell the reason. */
+		if (r < 0)
+			break;
+	}
+
+	signal (SIGPIPE, handler);
+}
+
+static void loadJobRecords (jobWorker *const worker)
+{
+	FILE *fp = fopen (worker->recordName, "rb");
+	size_t allocated = 0;
+	jobRecord record;
+
+	if (fp == NULL)
+		error (FATAL | PERROR, "cannot open job record file \"%s\"", worker->recordName);
+
+	while (fread (&record, sizeof (record), 1, fp) == 1)
+	{
+		if (record.type == JOB_RECORD_TOTALS)
+		{
+			addTotals ((unsigned int) record.files,
+					   (unsigned long) record.lines, (unsigned long) record.bytes);
+			continue;
+		}
+
+		if (worker->count == allocated)
+		{
+			allocated = allocated? allocated * 2: 64;
+			worker->records = xRealloc (worker->records, allocated, jobRecord);
+		}
+		worker->records [worker->count++] = record;
+	}
+	fclose (fp);
+
+	worker->output = fopen (worker->outputName, "rb");
+	if (worker->output == NULL)
+		error (FATAL | PERROR, "cannot open job output file \"%s\"", worker->outputName);
+}
+
+static void copyWorkerOutput (jobWorker *const worker, long offset, MIO *mio)
+{
+	char buf [BUFSIZ];
+
+	while (worker->outputOffset < offset)
+	{
+		size_t n = (size_t) (offset - worker->outputOffset);
+		if (n > sizeof (buf))
+			n = sizeof (buf);
+
+		if (fread (buf, 1, n, worker->output) != n)
+			error (FATAL | PERROR, "cannot read job output file \"%s\"", worker->outputName);
+		mio_write (mio, buf, 1, n);
+		worker->outputOffset += (long) n;
+	}
+}
+
+static jobWorker *findWorkerForIndex (jobWorker *const workers, unsigned int nWorkers,
+									  unsigned int index)
+{
+	/* Each worker receives increasing indexes, so the next record of
+	 * the worker that parsed the file at INDEX has INDEX. */
+	for (unsigned int i = 0; i < nWorkers; i++)
+	{
+		jobWorker *const worker = workers + i;
+		if (worker->cursor < worker->count
+			&& worker->records [worker->cursor].index == index)
+			return worker;
+	}
+	return NULL;
+}
+
+static bool mergeWorkerOutputs (jobWorker *const workers, unsigned int nWorkers,
+								unsigned int count)
+{
+	bool resize = false;
+	MIO *mio = tagFileMio ();
+
+	for (unsigned int index = 0; index < count; index++)
+	{
+		jobWorker *const worker = findWorkerForIndex (workers, nWorkers, index);
+		const unsigned long tags = numTagsAdded ();
+		if (worker == NULL)
+			error (FATAL, "no job worker parsed \"%s\"",
+				   vStringValue (stringListItem (JobQueue, index)));
+
+		while (true)
+		{
+			jobRecord *const record = worker->records + worker->cursor++;
+
+			copyWorkerOutput (worker, record->offset, mio);
+			if (record->type == JOB_RECORD_PTAG)
+				makeParserPseudoTags (record->language);
+			else
+			{
+				setNumTagsAdded (numTagsAdded () + record->tags);
+				resize |= record->resize;
+				if (Profiling)
+				{
+					/* Count the pseudo tags made here as a serial run does. */
+					record->profile.tags = numTagsAdded () - tags;
+					writeProfileRecord (vStringValue (stringListItem (JobQueue, index)),
+										&record->profile);
+				}
+				break;
+			}
+		}
+	}
+	abort_if_ferror (mio);
+
+	return resize;
+}
+
+static void deleteWorkers (jobWorker *const workers, unsigned int nWorkers)
+{
+	for (unsigned int i = 0; i < nWorkers; i++)
+	{
+		jobWorker *const worker = workers + i;
+		if (worker->output)
+			fclose (worker->output);
+		remove (worker->outputName);
+		remove (worker->recordName);
+		eFree (worker->outputName);
+		eFree (worker->recordName);
+		if (worker->records)
+			eFree (worker->records);
+	}
+	eFree (workers);
+}
+
+static bool runWorkers (unsigned int nWorkers)
+{
+	const unsigned int count = stringListCount (JobQueue);
+	jobWorker *const workers = xCalloc (nWorkers, jobWorker);
+	bool failed = false;
+	bool resize;
+	int fds [2];
+
+	verbose ("parsing %u files with %u jobs\n", count, nWorkers);
+
+	for (unsigned int i = 0; i < nWorkers; i++)
+	{
+		workers [i].outputName = makeTempFileName ();
+		workers [i].recordName = makeTempFileName ();
+	}
+
+	if (pipe (fds) != 0)
+		error (FATAL | PERROR, "cannot make a pipe for jobs");
+
+	/* Don't let the workers write the data buffered in the parent again.
+	 * fflush (NULL) also covers the --profile file. */
+	mio_flush (tagFileMio ());
+	fflush (NULL);
+
+	for (unsigned int i = 0; i < nWorkers; i++)
+	{
+		pid_t pid = fork ();
+		if (pid < 0)
+			error (FATAL | PERROR, "cannot fork a job worker");
+		else if (pid == 0)
+		{
+			close (fds [1]);
+			runWorker (workers + i, fds [0]);
+		}
+		workers [i].pid = pid;
+	}
+	close (fds [0]);
+
+	sendJobIndexes (fds [1], count);
+	close (fds [1]);
+
+	for (unsigned int i = 0; i < nWorkers; i++)
+	{
+		int status;
+		pid_t r;
+
+		do
+			r = waitpid (workers [i].pid, &status, 0);
+		while (r < 0 && errno == EINTR);
+
+		if (r < 0 || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+			failed = true;
+	}
+
+	if (failed)
+	{
+		deleteWorkers (workers, nWorkers);
+		error (FATAL, "a job worker failed");
+	}
+
+	for (unsigned int i = 0; i < nWorkers; i++)
+		loadJobRecords (workers + i);
+	resize = mergeWorkerOutputs (workers, nWorkers, count);
+
+	deleteWorkers (workers, nWorkers);
+	return resize;
+}
+
+extern bool runQueuedJobs (void)
+{
+	bool resize;
+	unsigned int count;
+
+	if (JobQueue == NULL || (count = stringListCount (JobQueue)) == 0)
+		return false;
+
+	/* Forking is not worth for a file. */
+	if (count == 1)
+		resize = parseQueuedFiles ();
+	else
+		resize = runWorkers (count < Option.jobs? count: Option.jobs);
+
+	stringListClear (JobQueue);
+	return resize;
+}
+
+#else  /* HAVE_JOBS */
+
+extern bool isJobWorker (void)
+{
+	return false;
+}
+
+extern void requestParserPseudoTagsForJob (langType language CTAGS_ATTR_UNUSED)
+{
+	AssertNotReached ();
+}
+
+extern bool runQueuedJobs (void)
+{
+	bool resize;
+
+	if (JobQueue == NULL)
+		return false;
+
+	resize = parseQueuedFiles ();
+	stringListClear (JobQueue);
+	return resize;
+}
+#endif
@@ -0,0 +1,46 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Private interface to jobs.c, running parsers in worker processes
+*   (--jobs=N).
+*/
+#ifndef CTAGS_MAIN_JOBS_PRIVATE_H
+#define CTAGS_MAIN_JOBS_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+#include "types.h"
+
+/*
+*   MACROS
+*/
+#if defined (HAVE_FORK) && defined (HAVE_PIPE) && defined (HAVE_WAITPID)
+#define HAVE_JOBS 1
+#endif
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* True if input files should be handed to queueJob () instead of
+ * being parsed immediately. */
+extern bool jobsEnabled (void);
+
+extern void queueJob (const char *const fileName);
+
+/* Parse all the queued files, and append their tags to the tag file
+ * in the order they were queued. Returns true if the tag file must be
+ * resized like parseFile (). */
+extern bool runQueuedJobs (void);
+
+/* Used in parse.c. The parent process emits the parser specific pseudo
+ * tags at the place where a worker process requests them. */
+extern bool isJobWorker (void);
+extern void requestParserPseudoTagsForJob (langType language);
+
+#endif	/* CTAGS_MAIN_JOBS_PRIVATE_H */
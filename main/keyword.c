@@ -14,6 +14,7 @@
 
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
 
 #include "debug.h"
 #include "keyword.h"
@@ -21,94 +22,130 @@
 #include "parse.h"
 #include "routines.h"
 
+/*
+*   MACROS
+*/
+#define KEYWORD_TABLE_MIN_SIZE 16	/* must be a power of 2 */
+#define KEYWORD_MAX_LENGTH_BIT 63
+
 /*
 *   DATA DECLARATIONS
 */
-typedef struct sHashEntry {
-	struct sHashEntry *next;
-	const char *string;
-	langType language;
+typedef struct sKeywordEntry {
+	const char *string;			/* NULL if the slot is empty */
+	unsigned int hash;
+	unsigned int length;
 	int value;
-} hashEntry;
+} keywordEntry;
+
+/* The keywords of a language in an open addressing hash table.
+ * Most identifiers passed to lookupKeyword () are not keywords. They are
+ * rejected by the first character or the length before probing. */
+typedef struct sKeywordHashTable {
+	keywordEntry *entries;
+	unsigned int size;			/* a power of 2 */
+	unsigned int count;
+	unsigned int maxLength;
+	uint64_t lengths;			/* bit N: a keyword of length N exists */
+	uint32_t firstChars [256 / 32];	/* in lower case */
+} keywordHashTable;
 
 /*
 *   DATA DEFINITIONS
 */
-static const unsigned int TableSize = 2039;  /* prime */
-static hashEntry **HashTable = NULL;
-static unsigned int MaxEntryLen = 0;
+static keywordHashTable **KeywordHashTables = NULL;	/* indexed by langType */
+static unsigned int KeywordHashTableCount = 0;
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static hashEntry **getHashTable (void)
+static keywordHashTable *getKeywordHashTable (langType language, bool creating)
 {
-	static bool allocated = false;
-
-	if (! allocated)
+	if (language < 0 || (unsigned int) language >= KeywordHashTableCount)
 	{
-		unsigned int i;
-
-		HashTable = xMalloc (TableSize, hashEntry*);
-
-		for (i = 0  ;  i < TableSize  ;  ++i)
-			HashTable [i] = NULL;
+		if (! creating)
+			return NULL;
+		Assert (language >= 0);
+
+		unsigned int count = KeywordHashTableCount? KeywordHashTableCount: 64;
+		while (count <= (unsigned int) language)
+			count *= 2;
+		KeywordHashTables = xRealloc (KeywordHashTables, count, keywordHashTable*);
+		memset (KeywordHashTables + KeywordHashTableCount, 0,
+				sizeof (keywordHashTable*) * (count - KeywordHashTableCount));
+		KeywordHashTableCount = count;
+	}
 
-		allocated = true;
+	if (KeywordHashTables [language] == NULL && creating)
+	{
+		keywordHashTable *table = xCalloc (1, keywordHashTable);
+		table->size = KEYWORD_TABLE_MIN_SIZE;
+		table->entries = xCalloc (table->size, keywordEntry);
+		KeywordHashTables [language] = table;
 	}
-	return HashTable;
+	return KeywordHashTables [language];
 }
 
-static hashEntry *getHashTableEntry (unsigned long hashedValue)
+static uint64_t lengthBit (size_t length)
 {
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry;
-
-	Assert (hashedValue < TableSize);
-	entry = table [hashedValue];
+	return ((uint64_t) 1) << (length < KEYWORD_MAX_LENGTH_BIT
+							  ? length: KEYWORD_MAX_LENGTH_BIT);
+}
 
-	return entry;
+static bool hasFirstChar (const keywordHashTable *const table, unsigned char c)
+{
+	return (table->firstChars [c / 32] & (((uint32_t) 1) << (c % 32))) != 0;
 }
 
-static unsigned int hashValue (const char *const string, langType language,
-	unsigned int maxLen, bool *maxLenReached)
+/* "djb" hash as used in g_str_hash() in glib, computed in lower case
+ * for lookupCaseKeyword (). */
+static unsigned int hashValue (const char *const string, size_t *length,
+							   size_t maxLen, bool *maxLenReached)
 {
 	const char *p;
 	unsigned int h = 5381;
 
 	Assert (string != NULL);
 
-	/* "djb" hash as used in g_str_hash() in glib */
 	for (p = string; *p != '\0'; p++)
 	{
-		h = (h << 5) + h + (signed char) tolower ((unsigned char) *p);
-
-		if (p > string + maxLen)
+		if ((size_t) (p - string) >= maxLen)
 		{
+			*length = 0;
 			*maxLenReached = true;
 			return 0;
 		}
+		h = (h << 5) + h + (signed char) tolower ((unsigned char) *p);
 	}
 
-	/* consider language as an extra "character" and add it to the hash */
-	h = (h << 5) + h + language;
-
+	*length = p - string;
 	*maxLenReached = false;
 	return h;
 }
 
-static hashEntry *newEntry (
-		const char *const string, langType language, int value)
+static void insertEntry (keywordHashTable *const table, const keywordEntry *const entry)
 {
-	hashEntry *const entry = xMalloc (1, hashEntry);
+	unsigned int i = entry->hash & (table->size - 1);
 
-	entry->next     = NULL;
-	entry->string   = string;
-	entry->language = language;
-	entry->value    = value;
+	while (table->entries [i].string != NULL)
+		i = (i + 1) & (table->size - 1);
+	table->entries [i] = *entry;
+}
 
-	return entry;
+static void growKeywordHashTable (keywordHashTable *const table)
+{
+	keywordEntry *const oldEntries = table->entries;
+	const unsigned int oldSize = table->size;
+
+	table->size *= 2;
+	table->entries = xCalloc (table->size, keywordEntry);
+	for (unsigned int i = 0; i < oldSize; i++)
+	{
+		if (oldEntries [i].string != NULL)
+			insertEntry (table, oldEntries + i);
+	}
+	eFree (oldEntries);
 }
 
 /*  Note that it is assumed that a "value" of zero means an undefined keyword
@@ -118,65 +155,60 @@ static hashEntry *newEntry (
  */
 extern void addKeyword (const char *const string, langType language, int value)
 {
+	keywordHashTable *const table = getKeywordHashTable (language, true);
+	keywordEntry entry;
 	bool dummy;
-	const unsigned int index = hashValue (string, language, 1000, &dummy) % TableSize;
-	hashEntry *entry = getHashTableEntry (index);
-	size_t len = strlen (string);
+	size_t length;
 
-	if (len > MaxEntryLen)
-		MaxEntryLen = len;
+	entry.hash = hashValue (string, &length, SIZE_MAX, &dummy);
+	entry.string = string;
+	entry.length = (unsigned int) length;
+	entry.value = value;
 
-	if (entry == NULL)
-	{
-		hashEntry **const table = getHashTable ();
-		table [index] = newEntry (string, language, value);
-	}
-	else
-	{
-		hashEntry *prev = NULL;
+	Assert (length > 0);
+	Assert (lookupKeyword (string, language) == KEYWORD_NONE);	/* already in table */
 
-		while (entry != NULL)
-		{
-			if (language == entry->language  &&
-				strcmp (string, entry->string) == 0)
-			{
-				Assert (("Already in table" == NULL));
-			}
-			prev = entry;
-			entry = entry->next;
-		}
-		if (entry == NULL)
-		{
-			Assert (prev != NULL);
-			prev->next = newEntry (string, language, value);
-		}
-	}
+	/* Keep the load factor at most 1/2. */
+	if ((table->count + 1) * 2 > table->size)
+		growKeywordHashTable (table);
+	insertEntry (table, &entry);
+	table->count++;
+
+	if (length > table->maxLength)
+		table->maxLength = (unsigned int) length;
+	table->lengths |= lengthBit (length);
+
+	const unsigned char c = (unsigned char) tolower ((unsigned char) string [0]);
+	table->firstChars [c / 32] |= ((uint32_t) 1) << (c % 32);
 }
 
 static int lookupKeywordFull (const char *const string, bool caseSensitive, langType language)
 {
+	const keywordHashTable *const table = getKeywordHashTable (language, false);
 	bool maxLenReached;
-	const unsigned int index = hashValue (string, language, MaxEntryLen, &maxLenReached) % TableSize;
-	hashEntry *entry;
-	int result = KEYWORD_NONE;
+	size_t length;
+	unsigned int hash, i;
 
-	if (maxLenReached)
+	if (table == NULL
+		|| ! hasFirstChar (table, (unsigned char) tolower ((unsigned char) string [0])))
 		return KEYWORD_NONE;
 
-	entry = getHashTableEntry (index);
+	hash = hashValue (string, &length, table->maxLength, &maxLenReached);
+	if (maxLenReached || (table->lengths & lengthBit (length)) == 0)
+		return KEYWORD_NONE;
 
-	while (entry != NULL)
+	for (i = hash & (table->size - 1);
+		 table->entries [i].string != NULL;
+		 i = (i + 1) & (table->size - 1))
 	{
-		if (language == entry->language &&
-			((caseSensitive && strcmp (string, entry->string) == 0) ||
-			 (!caseSensitive && strcasecmp (string, entry->string) == 0)))
-		{
-			result = entry->value;
-			break;
-		}
-		entry = entry->next;
+		const keywordEntry *const entry = table->entries + i;
+
+		if (entry->hash == hash && entry->length == length
+			&& ((caseSensitive && strcmp (string, entry->string) == 0) ||
+				(!caseSensitive && strcasecmp (string, entry->string) == 0)))
+			return entry->value;
 	}
-	return result;
+	return KEYWORD_NONE;
 }
 
 extern int lookupKeyword (const char *const string, langType language)
@@ -191,90 +223,80 @@ extern int lookupCaseKeyword (const char *const string, langType language)
 
 extern void freeKeywordTable (void)
 {
-	if (HashTable != NULL)
+	if (KeywordHashTables != NULL)
 	{
 		unsigned int i;
 
-		for (i = 0  ;  i < TableSize  ;  ++i)
+		for (i = 0  ;  i < KeywordHashTableCount  ;  ++i)
 		{
-			hashEntry *entry = HashTable [i];
+			keywordHashTable *const table = KeywordHashTables [i];
 
-			while (entry != NULL)
+			if (table != NULL)
 			{
-				hashEntry *next = entry->next;
-				eFree (entry);
-				entry = next;
+				eFree (table->entries);
+				eFree (table);
 			}
 		}
-		eFree (HashTable);
+		eFree (KeywordHashTables);
+		KeywordHashTables = NULL;
+		KeywordHashTableCount = 0;
 	}
 }
 
 #ifdef DEBUG
 
-static void printEntry (const hashEntry *const entry)
+static void printKeywordHashTable (langType language, const keywordHashTable *const table)
 {
-	printf ("  %-15s %-7s\n", entry->string, getLanguageName (entry->language));
-}
+	unsigned long probes = 0;
+	unsigned int i;
 
-static unsigned int printBucket (const unsigned int i)
-{
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry = table [i];
-	unsigned int measure = 1;
-	bool first = true;
-
-	printf ("%2d:", i);
-	if (entry == NULL)
-		printf ("\n");
-	else while (entry != NULL)
+	for (i = 0  ;  i < table->size  ;  ++i)
 	{
-		if (! first)
-			printf ("    ");
-		else
-		{
-			printf (" ");
-			first = false;
-		}
-		printEntry (entry);
-		entry = entry->next;
-		measure = 2 * measure;
+		const keywordEntry *const entry = table->entries + i;
+
+		if (entry->string == NULL)
+			continue;
+
+		const unsigned int home = entry->hash & (table->size - 1);
+		const unsigned int distance = (i - home) & (table->size - 1);
+
+		printf ("%4u: %-15s %-7s (+%u)\n", i, entry->string,
+				getLanguageName (language), distance);
+		probes += distance + 1;
 	}
-	return measure - 1;
+	printf ("%s: %u keywords in %u slots, %lu probes\n",
+			getLanguageName (language), table->count, table->size, probes);
 }
 
 extern void printKeywordTable (void)
 {
-	unsigned long emptyBucketCount = 0;
-	unsigned long measure = 0;
 	unsigned int i;
 
-	for (i = 0  ;  i < TableSize  ;  ++i)
+	for (i = 0  ;  i < KeywordHashTableCount  ;  ++i)
 	{
-		const unsigned int pass = printBucket (i);
-
-		measure += pass;
-		if (pass == 0)
-			++emptyBucketCount;
+		if (KeywordHashTables [i] != NULL)
+			printKeywordHashTable ((langType) i, KeywordHashTables [i]);
 	}
-
-	printf ("spread measure = %ld\n", measure);
-	printf ("%ld empty buckets\n", emptyBucketCount);
 }
 
 #endif
 
 extern void dumpKeywordTable (FILE *fp)
 {
-	unsigned int i;
-	for (i = 0  ;  i < TableSize  ;  ++i)
+	unsigned int i, j;
+
+	for (i = 0  ;  i < KeywordHashTableCount  ;  ++i)
 	{
-		hashEntry **const table = getHashTable ();
-		hashEntry *entry = table [i];
-		while (entry != NULL)
+		const keywordHashTable *const table = KeywordHashTables [i];
+
+		if (table == NULL)
+			continue;
+
+		for (j = 0  ;  j < table->size  ;  ++j)
 		{
-			fprintf(fp, "%s	%s\n", entry->string, getLanguageName (entry->language));
-			entry = entry->next;
+			const keywordEntry *const entry = table->entries + j;
+			if (entry->string != NULL)
+				fprintf(fp, "%s	%s\n", entry->string, getLanguageName ((langType) i));
 		}
 	}
 }
@@ -30,6 +30,7 @@ static regexCompiledCode compile (struct regexBackend *backend,
 								  int flags);
 static void delete_code (void *code);
 static void set_icase_flag (int *flags);
+static enum regexLiteralSyntax literal_syntax (int flags);
 
 /*
 *    DATA DEFINITIONS
@@ -41,6 +42,7 @@ static struct regexBackend defaultRegexBackend = {
 	.compile = compile,
 	.match = match,
 	.delete_code = delete_code,
+	.literal_syntax = literal_syntax,
 };
 
 /*
@@ -125,3 +127,10 @@ static void set_icase_flag (int *flags)
 {
 	*flags |= REG_ICASE;
 }
+
+static enum regexLiteralSyntax literal_syntax (int flags)
+{
+	if (flags & REG_ICASE)
+		return REGEX_LITERAL_SYNTAX_NONE;
+	return (flags & REG_EXTENDED)? REGEX_LITERAL_SYNTAX_ERE: REGEX_LITERAL_SYNTAX_NONE;
+}
@@ -38,6 +38,7 @@ static regexCompiledCode compile (struct regexBackend *backend,
 								  int flags);
 static void delete_code (void *code);
 static void set_icase_flag (int *flags);
+static enum regexLiteralSyntax literal_syntax (int flags);
 
 /*
 *    DATA DEFINITIONS
@@ -49,6 +50,7 @@ static struct regexBackend pcre2RegexBackend = {
 	.compile = compile,
 	.match = match,
 	.delete_code = delete_code,
+	.literal_syntax = literal_syntax,
 };
 
 /*
@@ -138,3 +140,8 @@ static void set_icase_flag (int *flags)
 {
 	*flags |= PCRE2_CASELESS;
 }
+
+static enum regexLiteralSyntax literal_syntax (int flags)
+{
+	return (flags & PCRE2_CASELESS)? REGEX_LITERAL_SYNTAX_NONE: REGEX_LITERAL_SYNTAX_PCRE2;
+}
@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include <ctype.h>
+#include <limits.h>
 #include <stddef.h>
 #ifdef HAVE_SYS_TYPES_H
 # include <sys/types.h>  /* declare off_t (not known to regex.h on FreeBSD) */
@@ -36,6 +37,7 @@
 #include "options.h"
 #include "optscript.h"
 #include "parse_p.h"
+#include "profile_p.h"
 #include "promise.h"
 #include "read.h"
 #include "read_p.h"
@@ -90,6 +92,16 @@ enum tableAction {
 	TACTION_QUIT,					/* {tquit} */
 };
 
+/* A literal substring that every line matched by a single line pattern
+ * contains. Patterns sharing the same literal share one object, so the
+ * literal is searched at most once per line. */
+struct regexLiteral {
+	char *string;
+	size_t length;
+	unsigned int stamp;			/* the line the result is for */
+	bool found;
+};
+
 struct fieldPattern {
 	fieldType ftype;
 	const char *template;
@@ -179,6 +191,9 @@ typedef struct {
 	char *optscript_src;
 	EsObject *optscript;
 
+	/* Owned by the control block. NULL if not available. */
+	struct regexLiteral *required_literal;
+
 	int refcount;
 } regexPattern;
 
@@ -191,6 +206,9 @@ typedef struct {
 	struct {
 		unsigned int match;
 		unsigned int unmatch;
+		/* lines on which the backend was not called because the
+		 * required literal of the pattern was not found */
+		unsigned int skip;
 	} statistics;
 } regexTableEntry;
 
@@ -239,6 +257,13 @@ struct lregexControlBlock {
 	ptrArray *hook[SCRIPT_HOOK_MAX];
 	ptrArray *hook_code[SCRIPT_HOOK_MAX];
 
+	/* The required literals of single line patterns, and the bytes
+	 * appearing in the current line. */
+	ptrArray *literals;
+	unsigned int lineStamp;
+	unsigned int bytesStamp;
+	unsigned char bytes[(UCHAR_MAX + 1) / CHAR_BIT];
+
 	langType owner;
 };
 
@@ -364,6 +389,15 @@ static void clearPatternSet (struct lregexControlBlock *lcb)
 	ptrArrayClear (lcb->entries [REG_PARSER_SINGLE_LINE]);
 	ptrArrayClear (lcb->entries [REG_PARSER_MULTI_LINE]);
 	ptrArrayClear (lcb->tables);
+	ptrArrayClear (lcb->literals);
+}
+
+static void deleteLiteral (void *data)
+{
+	struct regexLiteral *literal = data;
+
+	eFree (literal->string);
+	eFree (literal);
 }
 
 extern struct lregexControlBlock* allocLregexControlBlock (parserDefinition *parser)
@@ -374,6 +408,7 @@ extern struct lregexControlBlock* allocLregexControlBlock (parserDefinition *par
 	lcb->entries[REG_PARSER_MULTI_LINE] = ptrArrayNew(deleteTableEntry);
 	lcb->tables = ptrArrayNew(deleteTable);
 	lcb->tstack = ptrArrayNew(NULL);
+	lcb->literals = ptrArrayNew(deleteLiteral);
 	lcb->guest_req = guestRequestNew ();
 	lcb->local_dict = es_nil;
 	lcb->param_dict = hashTableNew (3, hashCstrhash, hashCstreq,
@@ -404,6 +439,9 @@ extern void freeLregexControlBlock (struct lregexControlBlock* lcb)
 	ptrArrayDelete (lcb->tstack);
 	lcb->tstack = NULL;
 
+	ptrArrayDelete (lcb->literals);
+	lcb->literals = NULL;
+
 	guestRequestDelete (lcb->guest_req);
 	lcb->guest_req = NULL;
 
@@ -1574,7 +1612,8 @@ static struct flagDefsDescriptor choose_backend (const char *flags, enum regexPa
 }
 
 static regexCompiledCode compileRegex (enum regexParserType regptype,
-									   const char* const regexp, const char* const flags)
+									   const char* const regexp, const char* const flags,
+									   enum regexLiteralSyntax *literalSyntax)
 {
 	struct flagDefsDescriptor desc = choose_backend (flags, regptype, false);
 
@@ -1589,9 +1628,253 @@ static regexCompiledCode compileRegex (enum regexParserType regptype,
 			   ARRAY_SIZE (backendCommonRegexFlagDefs),
 			   &desc);
 
+	if (literalSyntax)
+		*literalSyntax = desc.backend->literal_syntax
+			? desc.backend->literal_syntax (desc.flags)
+			: REGEX_LITERAL_SYNTAX_NONE;
+
 	return desc.backend->compile (desc.backend, regexp, desc.flags);
 }
 
+/*
+ * Extracting a literal substring that every line matching a pattern
+ * contains. A pattern is split into runs of literal characters that
+ * the pattern requires; the longest run is used. Anything not
+ * understood here gives up the extraction: a missing literal only
+ * costs the prefilter, a wrong one breaks the output.
+ */
+static const char *skipBracketInRegex (const char *p, enum regexLiteralSyntax syntax)
+{
+	Assert (*p == '[');
+
+	p++;
+	if (*p == '^')
+		p++;
+	if (*p == ']')
+		p++;
+	while (*p != '\0' && *p != ']')
+	{
+		if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '='))
+		{
+			char d = p[1];
+			for (p += 2; *p != '\0' && !(*p == d && p[1] == ']'); p++)
+				;
+			if (*p == '\0')
+				return NULL;
+			p += 2;
+		}
+		else if (*p == '\\' && syntax == REGEX_LITERAL_SYNTAX_PCRE2)
+		{
+			if (p[1] == '\0')
+				return NULL;
+			p += 2;
+		}
+		else
+			p++;
+	}
+	return (*p == ']')? p + 1: NULL;
+}
+
+/* Return the position after the closing parenthesis. */
+static const char *skipGroupInRegex (const char *p, enum regexLiteralSyntax syntax,
+									 bool *alternation)
+{
+	int depth = 0;
+
+	Assert (*p == '(');
+
+	*alternation = false;
+	while (*p != '\0')
+	{
+		if (*p == '\\')
+		{
+			if (p[1] == '\0')
+				return NULL;
+			p += 2;
+			continue;
+		}
+		else if (*p == '[')
+		{
+			p = skipBracketInRegex (p, syntax);
+			if (p == NULL)
+				return NULL;
+			continue;
+		}
+		else if (*p == '(')
+			depth++;
+		else if (*p == ')')
+		{
+			if (--depth == 0)
+				return p + 1;
+		}
+		else if (*p == '|' && depth == 1)
+			*alternation = true;
+		p++;
+	}
+	return NULL;
+}
+
+static const char *skipQuantifierInRegex (const char *p, enum regexLiteralSyntax syntax)
+{
+	if (*p == '{')
+	{
+		p = strchr (p, '}');
+		if (p == NULL)
+			return NULL;
+	}
+	p++;
+	/* lazy or possessive */
+	if (syntax == REGEX_LITERAL_SYNTAX_PCRE2 && (*p == '?' || *p == '+'))
+		p++;
+	return p;
+}
+
+static bool isQuantifierInRegex (char c)
+{
+	return (c == '*' || c == '+' || c == '?' || c == '{');
+}
+
+static void flushLiteralRun (vString *run, vString *best)
+{
+	if (vStringLength (run) > vStringLength (best))
+		vStringCopy (best, run);
+	vStringClear (run);
+}
+
+static bool collectLiteralRuns (const char *p, const char *end,
+								enum regexLiteralSyntax syntax,
+								vString *run, vString *best)
+{
+	while (p < end)
+	{
+		int literal = -1;
+		const char *next;
+		bool alternation;
+
+		switch (*p)
+		{
+		case '|':
+			/* Groups having alternatives are skipped. So this is
+			 * an alternative at the top level. */
+			return false;
+		case '[':
+			next = skipBracketInRegex (p, syntax);
+			if (next == NULL)
+				return false;
+			break;
+		case '(':
+			if (syntax == REGEX_LITERAL_SYNTAX_PCRE2
+				&& (p[1] == '*' || (p[1] == '?' && p[2] != ':')))
+				return false;
+			next = skipGroupInRegex (p, syntax, &alternation);
+			if (next == NULL)
+				return false;
+			flushLiteralRun (run, best);
+			if (!alternation
+				&& !(next < end && (*next == '*' || *next == '?' || *next == '{')))
+			{
+				const char *inner = p + ((p[1] == '?')? 3: 1);
+				if (!collectLiteralRuns (inner, next - 1, syntax, run, best))
+					return false;
+				flushLiteralRun (run, best);
+			}
+			break;
+		case '\\':
+			if (p[1] == '\0')
+				return false;
+			if (isalnum ((unsigned char) p[1]))
+			{
+				/* \w, \s, \b, \1,... consume just two characters.
+				 * Multi-character escapes are not handled. */
+				if (syntax == REGEX_LITERAL_SYNTAX_PCRE2
+					&& strchr ("cgkNopPQuxE0", p[1]))
+					return false;
+			}
+			else if (strchr ("<>`'", p[1]) == NULL)
+				literal = (unsigned char) p[1];
+			next = p + 2;
+			break;
+		case '.':
+		case '^':
+		case '$':
+			next = p + 1;
+			break;
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+			/* applied to a bracket, a group, or nothing */
+			next = skipQuantifierInRegex (p, syntax);
+			if (next == NULL)
+				return false;
+			break;
+		default:
+			literal = (unsigned char) *p;
+			next = p + 1;
+			break;
+		}
+
+		if (literal == -1)
+			flushLiteralRun (run, best);
+		else if (next < end && isQuantifierInRegex (*next))
+		{
+			/* "x+" requires an x; "x*", "x?", and "x{m,n}" don't. */
+			if (*next == '+')
+				vStringPut (run, literal);
+			flushLiteralRun (run, best);
+			next = skipQuantifierInRegex (next, syntax);
+			if (next == NULL)
+				return false;
+		}
+		else
+			vStringPut (run, literal);
+
+		p = next;
+	}
+
+	flushLiteralRun (run, best);
+	return true;
+}
+
+static struct regexLiteral *internRequiredLiteral (struct lregexControlBlock *lcb,
+												   const char *regex,
+												   enum regexLiteralSyntax syntax)
+{
+	struct regexLiteral *literal = NULL;
+
+	if (syntax == REGEX_LITERAL_SYNTAX_NONE)
+		return NULL;
+
+	vString *run = vStringNew ();
+	vString *best = vStringNew ();
+
+	if (collectLiteralRuns (regex, regex + strlen (regex), syntax, run, best)
+		&& vStringLength (best) > 0)
+	{
+		for (unsigned int i = 0; i < ptrArrayCount (lcb->literals); i++)
+		{
+			struct regexLiteral *l = ptrArrayItem (lcb->literals, i);
+			if (strcmp (l->string, vStringValue (best)) == 0)
+			{
+				literal = l;
+				break;
+			}
+		}
+		if (literal == NULL)
+		{
+			literal = xCalloc (1, struct regexLiteral);
+			literal->length = vStringLength (best);
+			literal->string = vStringDeleteUnwrap (best);
+			best = NULL;
+			ptrArrayAdd (lcb->literals, literal);
+		}
+	}
+
+	vStringDelete (run);
+	vStringDelete (best);	/* NULL is acceptable. */
+	return literal;
+}
+
 
 /* If a letter and/or a name are defined in kindSpec, return true. */
 static bool parseKinds (
@@ -1995,6 +2278,59 @@ static bool fillGuestRequest (const char *start,
 	return guestRequestIsFilled (guest_req);
 }
 
+static bool findLiteral (const char *s, size_t n, const char *literal, size_t length)
+{
+	while (n >= length)
+	{
+		const char *p = memchr (s, literal[0], n - length + 1);
+		if (p == NULL)
+			return false;
+		if (memcmp (p + 1, literal + 1, length - 1) == 0)
+			return true;
+		n -= (p + 1) - s;
+		s = p + 1;
+	}
+	return false;
+}
+
+/* The result is computed once per line, and shared by the patterns
+ * requiring the same literal. The bytes in the line are collected in
+ * one pass first; a literal having a byte not in the line is rejected
+ * without searching. */
+static bool isRequiredLiteralInLine (struct lregexControlBlock *lcb,
+									 struct regexLiteral *literal,
+									 const vString* const line)
+{
+	if (literal->stamp == lcb->lineStamp)
+		return literal->found;
+
+	if (lcb->bytesStamp != lcb->lineStamp)
+	{
+		const unsigned char *s = (const unsigned char *) vStringValue (line);
+		const unsigned char *end = s + vStringLength (line);
+
+		memset (lcb->bytes, 0, sizeof (lcb->bytes));
+		for (; s < end; s++)
+			lcb->bytes[*s / CHAR_BIT] |= 1U << (*s % CHAR_BIT);
+		lcb->bytesStamp = lcb->lineStamp;
+	}
+
+	literal->stamp = lcb->lineStamp;
+	literal->found = true;
+	for (size_t i = 0; i < literal->length; i++)
+	{
+		unsigned char c = literal->string[i];
+		if (!(lcb->bytes[c / CHAR_BIT] & (1U << (c % CHAR_BIT))))
+		{
+			literal->found = false;
+			return false;
+		}
+	}
+	literal->found = findLiteral (vStringValue (line), vStringLength (line),
+								  literal->string, literal->length);
+	return literal->found;
+}
+
 static bool matchRegexPattern (struct lregexControlBlock *lcb,
 							   const vString* const line,
 							   regexTableEntry *entry)
@@ -2008,6 +2344,13 @@ static bool matchRegexPattern (struct lregexControlBlock *lcb,
 	if (patbuf->disabled && *(patbuf->disabled))
 		return false;
 
+	if (patbuf->required_literal
+		&& !isRequiredLiteralInLine (lcb, patbuf->required_literal, line))
+	{
+		entry->statistics.skip++;
+		return false;
+	}
+
 	match = patbuf->pattern.backend->match (patbuf->pattern.backend,
 											patbuf->pattern.code, vStringValue (line),
 											vStringLength (line),
@@ -2199,6 +2542,14 @@ extern bool matchRegex (struct lregexControlBlock *lcb, const vString* const lin
 {
 	bool result = false;
 	unsigned int i;
+
+	if (ptrArrayCount(lcb->entries[REG_PARSER_SINGLE_LINE]) == 0)
+		return false;
+
+	/* Invalidate the results of the literal searches for the last line. */
+	lcb->lineStamp++;
+
+	profileEnter (PROFILE_REGEX);
 	for (i = 0  ;  i < ptrArrayCount(lcb->entries[REG_PARSER_SINGLE_LINE])  ;  ++i)
 	{
 		regexTableEntry *entry = ptrArrayItem(lcb->entries[REG_PARSER_SINGLE_LINE], i);
@@ -2220,6 +2571,7 @@ extern bool matchRegex (struct lregexControlBlock *lcb, const vString* const lin
 				break;
 		}
 	}
+	profileLeave ();
 	return result;
 }
 
@@ -2339,7 +2691,8 @@ static regexPattern *addTagRegexInternal (struct lregexControlBlock *lcb,
 	if (!regexAvailable)
 		return NULL;
 
-	regexCompiledCode cp = compileRegex (regptype, regex, flags);
+	enum regexLiteralSyntax literalSyntax;
+	regexCompiledCode cp = compileRegex (regptype, regex, flags, &literalSyntax);
 	if (cp.code == NULL)
 	{
 		error (WARNING, "pattern: %s", regex);
@@ -2423,6 +2776,8 @@ static regexPattern *addTagRegexInternal (struct lregexControlBlock *lcb,
 												explictly_defined,
 												disabled);
 	rptr->pattern_string = escapeRegexPattern(regex);
+	if (regptype == REG_PARSER_SINGLE_LINE)
+		rptr->required_literal = internRequiredLiteral (lcb, regex, literalSyntax);
 
 	eFree (kindName);
 	if (description)
@@ -2499,7 +2854,8 @@ extern void addCallbackRegex (struct lregexControlBlock *lcb,
 		return;
 
 
-	regexCompiledCode cp = compileRegex (REG_PARSER_SINGLE_LINE, regex, flags);
+	enum regexLiteralSyntax literalSyntax;
+	regexCompiledCode cp = compileRegex (REG_PARSER_SINGLE_LINE, regex, flags, &literalSyntax);
 	if (cp.code == NULL)
 	{
 		error (WARNING, "pattern: %s", regex);
@@ -2510,6 +2866,7 @@ extern void addCallbackRegex (struct lregexControlBlock *lcb,
 	regexPattern *rptr = addCompiledCallbackPattern (lcb, &cp, callback, flags,
 													 disabled, userData);
 	rptr->pattern_string = escapeRegexPattern(regex);
+	rptr->required_literal = internRequiredLiteral (lcb, regex, literalSyntax);
 }
 
 static void addTagRegexOption (struct lregexControlBlock *lcb,
@@ -2727,6 +3084,7 @@ extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const vString*
 
 	unsigned int i;
 
+	profileEnter (PROFILE_REGEX);
 	for (i = 0; i < ptrArrayCount(lcb->entries [REG_PARSER_MULTI_LINE]); ++i)
 	{
 		regexTableEntry *entry = ptrArrayItem(lcb->entries [REG_PARSER_MULTI_LINE], i);
@@ -2738,6 +3096,7 @@ extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const vString*
 
 		result = matchMultilineRegexPattern (lcb, allLines, entry) || result;
 	}
+	profileLeave ();
 	return result;
 }
 
@@ -3139,6 +3498,28 @@ extern void extendRegexTable (struct lregexControlBlock *lcb, const char *src, c
 	}
 }
 
+extern void printRegexStatistics (struct lregexControlBlock *lcb)
+{
+	ptrArray *entries = lcb->entries[REG_PARSER_SINGLE_LINE];
+
+	if (ptrArrayCount(entries) == 0)
+		return;
+
+	fprintf(stderr, "\nREGEX STATISTICS of %s\n", getLanguageName (lcb->owner));
+	fputs("==============================================\n", stderr);
+	for (unsigned int i = 0; i < ptrArrayCount(entries); i++)
+	{
+		regexTableEntry *entry = ptrArrayItem (entries, i);
+		Assert (entry && entry->pattern);
+		fprintf(stderr, "%10u/%-10u%-40s skip: %u\n",
+				entry->statistics.match,
+				entry->statistics.unmatch + entry->statistics.match
+				+ entry->statistics.skip,
+				entry->pattern->pattern_string,
+				entry->statistics.skip);
+	}
+}
+
 extern void printMultitableStatistics (struct lregexControlBlock *lcb)
 {
 	if (ptrArrayCount(lcb->tables) == 0)
@@ -3176,7 +3557,7 @@ extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const vString*
 	int motionless_counter = 0;
 	unsigned int last_offset;
 
-
+	profileEnter (PROFILE_REGEX);
 	while (table)
 	{
 		last_offset = offset;
@@ -3214,6 +3595,7 @@ extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const vString*
 			break;
 		}
 	}
+	profileLeave ();
 
 	return true;
 }
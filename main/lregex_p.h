@@ -41,6 +41,14 @@ enum regexParserType {
 	REG_PARSER_MULTI_TABLE,
 };
 
+/* How the literal parts of a pattern are written. Used for extracting
+ * a literal substring that every line matching the pattern contains. */
+enum regexLiteralSyntax {
+	REGEX_LITERAL_SYNTAX_NONE,	/* don't try to extract */
+	REGEX_LITERAL_SYNTAX_ERE,
+	REGEX_LITERAL_SYNTAX_PCRE2,
+};
+
 struct lregexControlBlock;
 
 typedef struct sRegexCompiledCode {
@@ -60,6 +68,7 @@ struct regexBackend {
 									   void *, const char *, size_t,
 									   regmatch_t[BACK_REFERENCE_COUNT]);
 	void              (* delete_code) (void *);
+	enum regexLiteralSyntax (* literal_syntax) (int);
 };
 
 struct flagDefsDescriptor {
@@ -117,6 +126,7 @@ extern void listRegexOpscriptOperators (FILE *fp);
 extern void addOptscriptToHook (struct lregexControlBlock *lcb, enum scriptHook hook, const char *code);
 extern void propagateParamToOptscript (struct lregexControlBlock *lcb, const char *param, const char *value);
 
+extern void printRegexStatistics (struct lregexControlBlock *lcb);
 extern void printMultitableStatistics (struct lregexControlBlock *lcb);
 
 extern void basic_regex_flag_short (char c, void* data);
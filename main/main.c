@@ -51,14 +51,19 @@
 
 #include "ctags.h"
 #include "debug.h"
+#include "dirwalk_p.h"
 #include "entry_p.h"
 #include "error_p.h"
 #include "field_p.h"
+#include "gitindex_p.h"
+#include "ignore_p.h"
+#include "jobs_p.h"
 #include "keyword_p.h"
 #include "main_p.h"
 #include "options_p.h"
 #include "optscript.h"
 #include "parse_p.h"
+#include "profile_p.h"
 #include "read_p.h"
 #include "routines_p.h"
 #include "stats_p.h"
@@ -83,15 +88,44 @@ static void *mainData;
 *   FUNCTION PROTOTYPES
 */
 static bool createTagsForEntry (const char *const entryName);
+static bool createTagsForStatus (const char *const entryName,
+								 const fileStatus *const status,
+								 dirListing *parent, unsigned int index);
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-#if defined (HAVE_OPENDIR) && (defined (HAVE_DIRENT_H) || defined (_MSC_VER))
+#if defined (HAVE_DIRWALK)
+static bool recurseUsingDirListing (const char *const dirName, dirListing *listing)
+{
+	bool resize = false;
+	if (! dirListingRead (listing))
+		error (WARNING | PERROR, "cannot recurse into directory \"%s\"", dirName);
+	else
+	{
+		for (unsigned int i = 0; i < dirListingCount (listing); i++)
+		{
+			const fileStatus *const status = dirListingItem (listing, i);
+			if (dirListingItemIsIgnored (listing, i))
+				verbose ("ignoring \"%s\" (ignore files)\n", status->name);
+			else
+				resize |= createTagsForStatus (status->name, status, listing, i);
+		}
+	}
+	dirListingDelete (listing);
+	return resize;
+}
+#elif defined (HAVE_OPENDIR) && (defined (HAVE_DIRENT_H) || defined (_MSC_VER))
+/* The rules of the ignore files for the directory being read */
+static ignoreRules *IgnoreRules;
+
 static bool recurseUsingOpendir (const char *const dirName)
 {
 	bool resize = false;
+	ignoreRules *const parentIgnoreRules = IgnoreRules;
+	if (Option.useIgnoreFiles)
+		IgnoreRules = ignoreRulesNew (parentIgnoreRules, dirName);
 	DIR *const dir = opendir (dirName);
 	if (dir == NULL)
 		error (WARNING | PERROR, "cannot recurse into directory \"%s\"", dirName);
@@ -112,13 +146,24 @@ static bool recurseUsingOpendir (const char *const dirName)
 					filePath = combinePathAndFile (dirName, entry->d_name);
 					free_p = true;
 				}
-				resize |= createTagsForEntry (filePath);
+				fileStatus *status = eStat (filePath);
+				if (IgnoreRules
+					&& isIgnoredByRules (IgnoreRules, filePath, status->isDirectory))
+					verbose ("ignoring \"%s\" (ignore files)\n", filePath);
+				else
+					resize |= createTagsForStatus (filePath, status, NULL, 0);
+				eStatFree (status);
 				if (free_p)
 					eFree (filePath);
 			}
 		}
 		closedir (dir);
 	}
+	if (Option.useIgnoreFiles)
+	{
+		ignoreRulesDelete (IgnoreRules);
+		IgnoreRules = parentIgnoreRules;
+	}
 	return resize;
 }
 #endif
@@ -163,24 +208,34 @@ static bool createTagsForWildcardUsingFindfirst (const char *const pattern)
 #endif
 
 
-static bool recurseIntoDirectory (const char *const dirName)
+/* PARENT is the listing having DIRNAME at INDEX, or NULL if DIRNAME is
+ * not found by the recursion but given by the user. */
+static bool recurseIntoDirectory (const char *const dirName, bool isSymbolicLink,
+								  dirListing *parent CTAGS_ATTR_UNUSED,
+								  unsigned int index CTAGS_ATTR_UNUSED)
 {
 	static unsigned int recursionDepth = 0;
 
 	recursionDepth++;
 
 	bool resize = false;
-	if (isRecursiveLink (dirName))
+	if (isSymbolicLink && isRecursiveLink (dirName))
 		verbose ("ignoring \"%s\" (recursive link)\n", dirName);
 	else if (! Option.recurse)
 		verbose ("ignoring \"%s\" (directory)\n", dirName);
 	else if(recursionDepth > Option.maxRecursionDepth)
 		verbose ("not descending in directory \"%s\" (depth %u > %u)\n",
 				dirName, recursionDepth, Option.maxRecursionDepth);
+	else if (isExcludedDirectory (dirName))
+		verbose ("excluding the files in \"%s\"\n", dirName);
 	else
 	{
 		verbose ("RECURSING into directory \"%s\"\n", dirName);
-#if defined (HAVE_OPENDIR) && (defined (HAVE_DIRENT_H) || defined (_MSC_VER))
+#if defined (HAVE_DIRWALK)
+		resize = recurseUsingDirListing (dirName,
+										 parent? dirListingNewChild (parent, index)
+										 : dirListingNew (dirName, recursionDepth));
+#elif defined (HAVE_OPENDIR) && (defined (HAVE_DIRENT_H) || defined (_MSC_VER))
 		resize = recurseUsingOpendir (dirName);
 #elif defined (HAVE__FINDFIRST)
 		{
@@ -199,10 +254,11 @@ static bool recurseIntoDirectory (const char *const dirName)
 	return resize;
 }
 
-static bool createTagsForEntry (const char *const entryName)
+static bool createTagsForStatus (const char *const entryName,
+								 const fileStatus *const status,
+								 dirListing *parent, unsigned int index)
 {
 	bool resize = false;
-	fileStatus *status = eStat (entryName);
 
 	Assert (entryName != NULL);
 	if (isExcludedFile (entryName, true))
@@ -210,15 +266,34 @@ static bool createTagsForEntry (const char *const entryName)
 	else if (status->isSymbolicLink  &&  ! Option.followLinks)
 		verbose ("ignoring \"%s\" (symbolic link)\n", entryName);
 	else if (! status->exists)
+	{
 		error (WARNING | PERROR, "cannot open input file \"%s\"", entryName);
+		/* With --update, the tags of a removed file are dropped. */
+		rememberInputFileForUpdate (entryName);
+	}
 	else if (status->isDirectory)
-		resize = recurseIntoDirectory (entryName);
+		resize = recurseIntoDirectory (entryName, status->isSymbolicLink,
+									   parent, index);
 	else if (! status->isNormalFile)
 		verbose ("ignoring \"%s\" (special file)\n", entryName);
 	else if (isExcludedFile (entryName, false))
 		verbose ("excluding \"%s\"\n", entryName);
 	else
-		resize = parseFile (entryName);
+	{
+		rememberInputFileForUpdate (entryName);
+		if (jobsEnabled ())
+			queueJob (entryName);
+		else
+			resize = parseFile (entryName);
+	}
+
+	return resize;
+}
+
+static bool createTagsForEntry (const char *const entryName)
+{
+	fileStatus *status = eStat (entryName);
+	bool resize = createTagsForStatus (entryName, status, NULL, 0);
 
 	eStatFree (status);
 	return resize;
@@ -266,6 +341,9 @@ static bool createTagsForArgs (cookedArgs *const args)
 		resize |= createTagsForEntry (arg);
 #endif
 		cArgForth (args);
+		/* Options given between files apply only to the files after them. */
+		if (! cArgOff (args) && cArgIsOption (args))
+			resize |= runQueuedJobs ();
 		parseCmdlineOptions (args);
 	}
 	return resize;
@@ -290,6 +368,8 @@ static bool createTagsFromFileInput (FILE *const fp, const bool filter)
 				fflush (stdout);
 			}
 			cArgForth (args);
+			if (! cArgOff (args) && cArgIsOption (args))
+				resize |= runQueuedJobs ();
 			parseCmdlineOptions (args);
 		}
 		cArgDelete (args);
@@ -316,6 +396,26 @@ static bool createTagsFromListFile (const char *const fileName)
 	return resize;
 }
 
+/*  Generate tags for the files changed in the git working tree, and drop
+ *  the tags of the removed files with --update.
+ */
+static bool createTagsFromGitIndex (const gitIndex *const index)
+{
+	bool resize = false;
+	const ptrArray *const changed = gitIndexChangedFiles (index);
+	const ptrArray *const removed = gitIndexRemovedFiles (index);
+
+	for (unsigned int i = 0; i < ptrArrayCount (changed); i++)
+		resize |= createTagsForEntry (ptrArrayItem (changed, i));
+	for (unsigned int i = 0; i < ptrArrayCount (removed); i++)
+	{
+		const char *const fileName = ptrArrayItem (removed, i);
+		verbose ("removed \"%s\"\n", fileName);
+		rememberInputFileForUpdate (fileName);
+	}
+	return resize;
+}
+
 static bool etagsInclude (void)
 {
 	return (bool)(Option.etags && Option.etagsInclude != NULL);
@@ -336,7 +436,9 @@ static void batchMakeTags (cookedArgs *args, void *user CTAGS_ATTR_UNUSED)
 {
 	clock_t timeStamps [3];
 	bool resize = false;
+	gitIndex *gitChanges = NULL;
 	bool files = (bool)(! cArgOff (args) || Option.fileList != NULL
+							  || Option.gitChanges != NULL
 							  || Option.filter);
 
 	if (! files)
@@ -348,6 +450,12 @@ static void batchMakeTags (cookedArgs *args, void *user CTAGS_ATTR_UNUSED)
 			return;
 	}
 
+	/* Without --update, the tags of the unchanged files would be lost
+	 * while the manifest records them as up to date. */
+	if (Option.gitChanges != NULL
+		&& (! Option.update || Option.filter || Option.printLanguage))
+		error (FATAL, "--git-changes requires --update writing a tag file");
+
 #define timeStamp(n) timeStamps[(n)]=(Option.printTotals ? clock():(clock_t)0)
 	if ((! Option.filter) && (! Option.printLanguage))
 		openTagFile ();
@@ -364,19 +472,33 @@ static void batchMakeTags (cookedArgs *args, void *user CTAGS_ATTR_UNUSED)
 		verbose ("Reading list file\n");
 		resize = (bool) (createTagsFromListFile (Option.fileList) || resize);
 	}
+	if (Option.gitChanges != NULL)
+	{
+		verbose ("Reading git index\n");
+		gitChanges = gitIndexNew (Option.gitChanges);
+		resize = (bool) (createTagsFromGitIndex (gitChanges) || resize);
+	}
 	if (Option.filter)
 	{
 		verbose ("Reading filter input\n");
 		resize = (bool) (createTagsFromFileInput (stdin, true) || resize);
 	}
 	if (! files  &&  Option.recurse)
-		resize = recurseIntoDirectory (".");
+		resize = recurseIntoDirectory (".", false, NULL, 0);
+	resize |= runQueuedJobs ();
 
 	timeStamp (1);
 
 	if ((! Option.filter) && (!Option.printLanguage))
 		closeTagFile (resize);
 
+	/* The manifest is saved only after the tags are written. */
+	if (gitChanges)
+	{
+		gitIndexSaveManifest (gitChanges);
+		gitIndexDelete (gitChanges);
+	}
+
 	timeStamp (2);
 
 	if (Option.printTotals)
@@ -584,6 +706,7 @@ extern int ctags_cli_main (int argc CTAGS_ATTR_UNUSED, char **argv)
 	checkOptions ();
 
 	runMainLoop (args);
+	closeProfile ();
 
 	/*  Clean up.
 	 */
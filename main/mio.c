@@ -36,6 +36,21 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+/* The offsets of a stream in text mode on Windows don't match
+ * the numbers of bytes written to it. */
+#if defined (USE_POSIX_THREADS) && !defined (_WIN32)
+#define MIO_ASYNC_OUTPUT
+#include <pthread.h>
+#endif
+
 /* minimal reallocation chunk size */
 #define MIO_CHUNK_SIZE 4096
 
@@ -51,8 +66,8 @@
  * file based operations and in-memory operations. Its goal is to ease the port
  * of an application that uses C file I/O API to perform in-memory operations.
  *
- * A #MIO object is created using mio_new_file(), mio_new_memory() or mio_new_mio(),
- * depending on whether you want file or in-memory operations.
+ * A #MIO object is created using mio_new_file(), mio_new_memory(), mio_new_mmap()
+ * or mio_new_mio(), depending on whether you want file or in-memory operations.
  * Its life is managed by reference counting. Just after calling one of functions
  * for creating, the count is 1. mio_ref() increments the counter. mio_unref()
  * decrements it. When the counter becomes 0, the #MIO object will be destroyed
@@ -70,6 +85,7 @@
  */
 
 
+typedef struct _MIOAsyncOutput MIOAsyncOutput;
 typedef struct _MIOUserData MIOUserData;
 struct _MIOUserData {
 	void *d;
@@ -90,6 +106,7 @@ struct _MIO {
 		struct {
 			FILE *fp;
 			MIOFCloseFunc close_func;
+			MIOAsyncOutput *async;
 		} file;
 		struct {
 			unsigned char *buf;
@@ -101,11 +118,186 @@ struct _MIO {
 			MIODestroyNotify free_func;
 			bool error;
 			bool eof;
+			bool mapped;
 		} mem;
 	} impl;
 	MIOUserData udata;
 };
 
+#ifdef MIO_ASYNC_OUTPUT
+/* Two batches are used in turn: the stream fills one while the output
+ * thread writes the other to the file. */
+struct _MIOAsyncOutput {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned char *buf;			/* the batch being filled */
+	size_t size;
+	size_t batch_size;
+	unsigned char *pending;		/* the batch handed off to the thread */
+	size_t pending_size;		/* 0 when the thread is idle */
+	bool in_flight;				/* a batch may be handed off */
+	bool error;					/* the thread failed in writing */
+	int error_number;			/* errno of the failure */
+	bool quit;
+	long offset;				/* the position of the stream, or -1 if unknown */
+};
+#endif
+
+#ifdef MIO_ASYNC_OUTPUT
+static void *async_output_thread (void *data)
+{
+	MIO *mio = data;
+	MIOAsyncOutput *async = mio->impl.file.async;
+
+	pthread_mutex_lock (&async->lock);
+	while (true)
+	{
+		bool failed;
+
+		while (async->pending_size == 0 && !async->quit)
+			pthread_cond_wait (&async->cond, &async->lock);
+		if (async->pending_size == 0)
+			break;
+		pthread_mutex_unlock (&async->lock);
+
+		failed = (fwrite (async->pending, 1, async->pending_size,
+						  mio->impl.file.fp) != async->pending_size
+				  || fflush (mio->impl.file.fp) != 0);
+
+		pthread_mutex_lock (&async->lock);
+		if (failed && !async->error)
+		{
+			async->error = true;
+			async->error_number = errno;
+		}
+		async->pending_size = 0;
+		pthread_cond_broadcast (&async->cond);
+	}
+	pthread_mutex_unlock (&async->lock);
+
+	return NULL;
+}
+
+static void async_output_wait (MIOAsyncOutput *async)
+{
+	pthread_mutex_lock (&async->lock);
+	while (async->pending_size > 0)
+		pthread_cond_wait (&async->cond, &async->lock);
+	pthread_mutex_unlock (&async->lock);
+}
+
+static void async_output_hand_off (MIOAsyncOutput *async)
+{
+	unsigned char *buf;
+
+	if (async->size == 0)
+		return;
+
+	pthread_mutex_lock (&async->lock);
+	while (async->pending_size > 0)
+		pthread_cond_wait (&async->cond, &async->lock);
+	buf = async->pending;
+	async->pending = async->buf;
+	async->pending_size = async->size;
+	async->buf = buf;
+	async->size = 0;
+	async->in_flight = true;
+	pthread_cond_broadcast (&async->cond);
+	pthread_mutex_unlock (&async->lock);
+}
+
+static size_t async_output_write (MIO *mio, const void *ptr, size_t n)
+{
+	MIOAsyncOutput *async = mio->impl.file.async;
+
+	if (async->size + n > async->batch_size)
+	{
+		async_output_hand_off (async);
+		if (n > async->batch_size)
+		{
+			/* Too large for a batch. */
+			async_output_wait (async);
+			n = fwrite (ptr, 1, n, mio->impl.file.fp);
+			if (async->offset >= 0)
+				async->offset += (long)n;
+			return n;
+		}
+	}
+
+	memcpy (async->buf + async->size, ptr, n);
+	async->size += n;
+	if (async->offset >= 0)
+		async->offset += (long)n;
+	return n;
+}
+
+static int async_output_vprintf (MIO *mio, const char *format, va_list ap)
+{
+	MIOAsyncOutput *async = mio->impl.file.async;
+	size_t avail = async->batch_size - async->size;
+	va_list ap_copy;
+	int rv;
+
+	va_copy (ap_copy, ap);
+	rv = vsnprintf ((char *)async->buf + async->size, avail, format, ap_copy);
+	va_end (ap_copy);
+	if (rv < 0)
+		return rv;
+
+	if ((size_t)rv < avail)
+	{
+		async->size += (size_t)rv;
+		if (async->offset >= 0)
+			async->offset += rv;
+	}
+	else
+	{
+		char *str = xMalloc ((size_t)rv + 1, char);
+		vsnprintf (str, (size_t)rv + 1, format, ap);
+		if (async_output_write (mio, str, (size_t)rv) < (size_t)rv)
+			rv = -1;
+		eFree (str);
+	}
+
+	return rv;
+}
+
+static void async_output_delete (MIOAsyncOutput *async)
+{
+	pthread_mutex_lock (&async->lock);
+	async->quit = true;
+	pthread_cond_broadcast (&async->cond);
+	pthread_mutex_unlock (&async->lock);
+	pthread_join (async->thread, NULL);
+
+	pthread_cond_destroy (&async->cond);
+	pthread_mutex_destroy (&async->lock);
+	eFree (async->buf);
+	eFree (async->pending);
+	eFree (async);
+}
+#endif
+
+/* Get the FILE of a file stream for accessing it directly. The data
+ * written asynchronously reaches the file first. */
+static FILE *file_get_synced_fp (MIO *mio)
+{
+#ifdef MIO_ASYNC_OUTPUT
+	MIOAsyncOutput *async = mio->impl.file.async;
+
+	if (async && (async->size > 0 || async->in_flight))
+	{
+		async_output_hand_off (async);
+		async_output_wait (async);
+		async->in_flight = false;
+	}
+	if (async)
+		async->offset = -1;
+#endif
+	return mio->impl.file.fp;
+}
+
 
 /**
  * mio_new_file_full:
@@ -157,6 +349,7 @@ MIO *mio_new_file_full (const char *filename,
 			mio->type = MIO_TYPE_FILE;
 			mio->impl.file.fp = fp;
 			mio->impl.file.close_func = close_func;
+			mio->impl.file.async = NULL;
 			mio->refcount = 1;
 			mio->udata.d = NULL;
 			mio->udata.f = NULL;
@@ -218,6 +411,7 @@ MIO *mio_new_fp (FILE *fp, MIOFCloseFunc close_func)
 		mio->type = MIO_TYPE_FILE;
 		mio->impl.file.fp = fp;
 		mio->impl.file.close_func = close_func;
+		mio->impl.file.async = NULL;
 		mio->refcount = 1;
 		mio->udata.d = NULL;
 		mio->udata.f = NULL;
@@ -282,6 +476,7 @@ MIO *mio_new_memory (unsigned char *data,
 		mio->impl.mem.free_func = free_func;
 		mio->impl.mem.eof = false;
 		mio->impl.mem.error = false;
+		mio->impl.mem.mapped = false;
 		mio->refcount = 1;
 		mio->udata.d = NULL;
 		mio->udata.f = NULL;
@@ -290,6 +485,87 @@ MIO *mio_new_memory (unsigned char *data,
 	return mio;
 }
 
+/**
+ * mio_new_mmap:
+ * @filename: Filename to map
+ *
+ * Creates a new read-only #MIO object working on memory, mapping a regular
+ * file as a whole instead of reading it. The data is not copied;
+ * mio_memory_get_data() returns the mapped memory. Writing to the object
+ * fails.
+ *
+ * The behavior is undefined if the file is truncated while the object is
+ * alive.
+ *
+ * Free-function: mio_unref()
+ *
+ * Returns: A new #MIO on success, or %NULL on failure, if the file is empty,
+ *          or if it is not a regular file, or if mapping is not supported on
+ *          the platform.
+ */
+MIO *mio_new_mmap (const char *filename)
+{
+#ifdef HAVE_MMAP
+	struct stat st;
+	MIO *mio;
+	int fd;
+
+	fd = open (filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat (fd, &st) != 0
+		|| !S_ISREG (st.st_mode)
+		|| st.st_size <= 0
+		|| (unsigned long long) st.st_size > (unsigned long long) SIZE_MAX)
+	{
+		close (fd);
+		return NULL;
+	}
+
+	mio = mio_new_mmap_fd (fd, (size_t) st.st_size);
+	close (fd);
+	return mio;
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * mio_new_mmap_fd:
+ * @fd: File descriptor of a regular file opened for reading
+ * @size: Size of the file, as fstat() reports it
+ *
+ * Same as mio_new_mmap() but maps the file already open as @fd, for
+ * callers which have stat'ed the file themselves. @fd is not closed; it
+ * can be closed as soon as the function returns.
+ *
+ * Free-function: mio_unref()
+ *
+ * Returns: A new #MIO on success, or %NULL on failure, if @size is 0, or
+ *          if mapping is not supported on the platform.
+ */
+MIO *mio_new_mmap_fd (int fd, size_t size)
+{
+#ifdef HAVE_MMAP
+	void *addr;
+	MIO *mio;
+
+	if (size == 0)
+		return NULL;
+
+	addr = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (addr == MAP_FAILED)
+		return NULL;
+
+	mio = mio_new_memory (addr, size, NULL, NULL);
+	mio->impl.mem.mapped = true;
+	return mio;
+#else
+	return NULL;
+#endif
+}
+
 /**
  * mio_new_mio:
  * @base: The original mio
@@ -375,6 +651,10 @@ MIO *mio_ref        (MIO *mio)
  * mio_unref() if the stream was configured to close the file when
  * destroyed.</para></warning>
  *
+ * If the writes on the stream are asynchronous, this waits for the written
+ * data to reach the file. The returned object can be used until the next
+ * write on the stream.
+ *
  * Returns: The underlying #FILE object of the given stream, or %NULL if the
  *          stream is not a file stream.
  */
@@ -383,11 +663,60 @@ FILE *mio_file_get_fp (MIO *mio)
 	FILE *fp = NULL;
 
 	if (mio->type == MIO_TYPE_FILE)
-		fp = mio->impl.file.fp;
+		fp = file_get_synced_fp (mio);
 
 	return fp;
 }
 
+/**
+ * mio_file_set_async_output:
+ * @mio: A #MIO file stream
+ * @batch_size: Size of the batches of the written data
+ *
+ * Makes the writes on a #MIO file stream asynchronous. The written data is
+ * gathered into batches of @batch_size bytes, and a dedicated thread writes
+ * each batch to the file with a large write while the stream fills the
+ * next one. Any other operation on the stream waits for the written data
+ * to reach the file first. A write error is reported by mio_error() later.
+ *
+ * Call this before the first mio_getpos() on the stream, and only on a
+ * stream not opened for appending.
+ *
+ * Returns: 0 on success, -1 if the writes on the stream stay synchronous.
+ */
+int mio_file_set_async_output (MIO *mio, size_t batch_size)
+{
+#ifdef MIO_ASYNC_OUTPUT
+	MIOAsyncOutput *async;
+
+	if (mio->type != MIO_TYPE_FILE || mio->impl.file.async || batch_size == 0)
+		return -1;
+
+	async = xCalloc (1, MIOAsyncOutput);
+	async->batch_size = batch_size;
+	async->buf = xMalloc (batch_size, unsigned char);
+	async->pending = xMalloc (batch_size, unsigned char);
+	async->offset = ftell (mio->impl.file.fp);
+	pthread_mutex_init (&async->lock, NULL);
+	pthread_cond_init (&async->cond, NULL);
+
+	mio->impl.file.async = async;
+	if (pthread_create (&async->thread, NULL, async_output_thread, mio) != 0)
+	{
+		mio->impl.file.async = NULL;
+		pthread_cond_destroy (&async->cond);
+		pthread_mutex_destroy (&async->lock);
+		eFree (async->buf);
+		eFree (async->pending);
+		eFree (async);
+		return -1;
+	}
+	return 0;
+#else
+	return -1;
+#endif
+}
+
 /**
  * mio_memory_get_data:
  * @mio: A #MIO object
@@ -440,6 +769,14 @@ int mio_unref (MIO *mio)
 
 		if (mio->type == MIO_TYPE_FILE)
 		{
+#ifdef MIO_ASYNC_OUTPUT
+			if (mio->impl.file.async)
+			{
+				file_get_synced_fp (mio);
+				async_output_delete (mio->impl.file.async);
+				mio->impl.file.async = NULL;
+			}
+#endif
 			if (mio->impl.file.close_func)
 				rv = mio->impl.file.close_func (mio->impl.file.fp);
 			mio->impl.file.close_func = NULL;
@@ -447,6 +784,11 @@ int mio_unref (MIO *mio)
 		}
 		else if (mio->type == MIO_TYPE_MEMORY)
 		{
+#ifdef HAVE_MMAP
+			if (mio->impl.mem.mapped)
+				rv = munmap (mio->impl.mem.buf, mio->impl.mem.size);
+			else
+#endif
 			if (mio->impl.mem.free_func)
 				mio->impl.mem.free_func (mio->impl.mem.buf);
 			mio->impl.mem.buf = NULL;
@@ -457,6 +799,7 @@ int mio_unref (MIO *mio)
 			mio->impl.mem.free_func = NULL;
 			mio->impl.mem.eof = false;
 			mio->impl.mem.error = false;
+			mio->impl.mem.mapped = false;
 		}
 		else
 			AssertNotReached ();
@@ -488,7 +831,7 @@ size_t mio_read (MIO *mio,
 				 size_t nmemb)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		return fread (ptr_, size, nmemb, mio->impl.file.fp);
+		return fread (ptr_, size, nmemb, file_get_synced_fp (mio));
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		size_t n_read = 0;
@@ -545,7 +888,7 @@ static int mem_try_resize (MIO *mio, size_t new_size)
 {
 	int success = false;
 
-	if (mio->impl.mem.realloc_func)
+	if (mio->impl.mem.realloc_func && !mio->impl.mem.mapped)
 	{
 		if (new_size == ULONG_MAX)
 		{
@@ -637,7 +980,10 @@ static int mem_try_ensure_space (MIO *mio, size_t n)
 {
 	int success = true;
 
-	if (mio->impl.mem.pos + n > mio->impl.mem.size)
+	/* The memory mapped from a file is read-only. */
+	if (mio->impl.mem.mapped)
+		success = false;
+	else if (mio->impl.mem.pos + n > mio->impl.mem.size)
 		success = mem_try_resize (mio, mio->impl.mem.pos + n);
 
 	return success;
@@ -661,7 +1007,13 @@ size_t mio_write (MIO *mio,
 				  size_t nmemb)
 {
 	if (mio->type == MIO_TYPE_FILE)
+	{
+#ifdef MIO_ASYNC_OUTPUT
+		if (mio->impl.file.async)
+			return (size == 0)? 0: async_output_write (mio, ptr, size * nmemb) / size;
+#endif
 		return fwrite (ptr, size, nmemb, mio->impl.file.fp);
+	}
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		size_t n_written = 0;
@@ -698,7 +1050,16 @@ size_t mio_write (MIO *mio,
 int mio_putc (MIO *mio, int c)
 {
 	if (mio->type == MIO_TYPE_FILE)
+	{
+#ifdef MIO_ASYNC_OUTPUT
+		if (mio->impl.file.async)
+		{
+			unsigned char b = (unsigned char)c;
+			return async_output_write (mio, &b, 1) == 1? (int)b: EOF;
+		}
+#endif
 		return fputc (c, mio->impl.file.fp);
+	}
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		int rv = EOF;
@@ -731,7 +1092,16 @@ int mio_putc (MIO *mio, int c)
 int mio_puts (MIO *mio, const char *s)
 {
 	if (mio->type == MIO_TYPE_FILE)
+	{
+#ifdef MIO_ASYNC_OUTPUT
+		if (mio->impl.file.async)
+		{
+			size_t len = strlen (s);
+			return async_output_write (mio, s, len) == len? 1: EOF;
+		}
+#endif
 		return fputs (s, mio->impl.file.fp);
+	}
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		int rv = EOF;
@@ -769,7 +1139,13 @@ int mio_puts (MIO *mio, const char *s)
 int mio_vprintf (MIO *mio, const char *format, va_list ap)
 {
 	if (mio->type == MIO_TYPE_FILE)
+	{
+#ifdef MIO_ASYNC_OUTPUT
+		if (mio->impl.file.async)
+			return async_output_vprintf (mio, format, ap);
+#endif
 		return vfprintf (mio->impl.file.fp, format, ap);
+	}
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		int rv = -1;
@@ -853,7 +1229,7 @@ int mio_printf (MIO *mio, const char *format, ...)
 int mio_getc (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		return fgetc (mio->impl.file.fp);
+		return fgetc (file_get_synced_fp (mio));
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		int rv = EOF;
@@ -900,7 +1276,7 @@ int mio_getc (MIO *mio)
 int mio_ungetc (MIO *mio, int ch)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		return ungetc (ch, mio->impl.file.fp);
+		return ungetc (ch, file_get_synced_fp (mio));
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		int rv = EOF;
@@ -936,7 +1312,7 @@ int mio_ungetc (MIO *mio, int ch)
 char *mio_gets (MIO *mio, char *s, size_t size)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		return fgets (s, (int)size, mio->impl.file.fp);
+		return fgets (s, (int)size, file_get_synced_fp (mio));
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		char *rv = NULL;
@@ -958,16 +1334,24 @@ char *mio_gets (MIO *mio, char *s, size_t size)
 				pos++;
 				i++;
 			}
-			for (; pos < buf_size && i < (size - 1); i++)
+			if (pos < buf_size && i < (size - 1))
 			{
-				s[i] = (char)buf[pos];
-				pos++;
-				if (s[i] == '\n')
+				/* Search the new-line with memchr(), which is much
+				 * faster than checking the bytes one by one. */
+				size_t n = buf_size - pos;
+				unsigned char *nl;
+
+				if (n > (size - 1) - i)
+					n = (size - 1) - i;
+				nl = memchr (buf + pos, '\n', n);
+				if (nl)
 				{
-					i++;
+					n = (size_t)(nl - (buf + pos)) + 1;
 					newline = true;
-					break;
 				}
+				memcpy (s + i, buf + pos, n);
+				pos += n;
+				i += n;
 			}
 			if (i > 0)
 			{
@@ -999,7 +1383,14 @@ char *mio_gets (MIO *mio, char *s, size_t size)
 void mio_clearerr (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		clearerr (mio->impl.file.fp);
+	{
+		clearerr (file_get_synced_fp (mio));
+#ifdef MIO_ASYNC_OUTPUT
+		/* The output thread is idle after the sync. */
+		if (mio->impl.file.async)
+			mio->impl.file.async->error = false;
+#endif
+	}
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		mio->impl.mem.error = false;
@@ -1021,7 +1412,7 @@ void mio_clearerr (MIO *mio)
 int mio_eof (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		return feof (mio->impl.file.fp);
+		return feof (file_get_synced_fp (mio));
 	else if (mio->type == MIO_TYPE_MEMORY)
 		return mio->impl.mem.eof != false;
 	else
@@ -1043,7 +1434,29 @@ int mio_eof (MIO *mio)
 int mio_error (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
+	{
+#ifdef MIO_ASYNC_OUTPUT
+		MIOAsyncOutput *async = mio->impl.file.async;
+
+		if (async)
+		{
+			bool error;
+
+			pthread_mutex_lock (&async->lock);
+			error = async->error;
+			/* errno of the output thread is not visible in the caller. */
+			if (error)
+				errno = async->error_number;
+			pthread_mutex_unlock (&async->lock);
+
+			/* ferror() would wait for the output thread writing to
+			 * the file to release the lock of the FILE. */
+			if (error || async->in_flight)
+				return error;
+		}
+#endif
 		return ferror (mio->impl.file.fp);
+	}
 	else if (mio->type == MIO_TYPE_MEMORY)
 		return mio->impl.mem.error != false;
 	else
@@ -1070,7 +1483,7 @@ int mio_error (MIO *mio)
 int mio_seek (MIO *mio, long offset, int whence)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		return fseek (mio->impl.file.fp, offset, whence);
+		return fseek (file_get_synced_fp (mio), offset, whence);
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		/* FIXME: should we support seeking out of bounds like lseek() seems to do? */
@@ -1143,7 +1556,23 @@ int mio_seek (MIO *mio, long offset, int whence)
 long mio_tell (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
+	{
+#ifdef MIO_ASYNC_OUTPUT
+		MIOAsyncOutput *async = mio->impl.file.async;
+
+		/* Telling doesn't wait for the output thread. */
+		if (async)
+		{
+			if (async->offset < 0)
+			{
+				long offset = ftell (file_get_synced_fp (mio));
+				async->offset = offset;
+			}
+			return async->offset;
+		}
+#endif
 		return ftell (mio->impl.file.fp);
+	}
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		long rv = -1;
@@ -1177,7 +1606,7 @@ long mio_tell (MIO *mio)
 void mio_rewind (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		rewind (mio->impl.file.fp);
+		rewind (file_get_synced_fp (mio));
 	else if (mio->type == MIO_TYPE_MEMORY)
 	{
 		mio->impl.mem.pos = 0;
@@ -1206,6 +1635,20 @@ int mio_getpos (MIO *mio, MIOPos *pos)
 	int rv = -1;
 
 	pos->type = mio->type;
+#ifdef MIO_ASYNC_OUTPUT
+	/* The position of an asynchronous stream is its offset,
+	 * got without waiting for the output thread. */
+	if (mio->type == MIO_TYPE_FILE && mio->impl.file.async)
+	{
+		long offset = mio_tell (mio);
+		if (offset >= 0)
+		{
+			pos->impl.mem = (size_t)offset;
+			rv = 0;
+		}
+	}
+	else
+#endif
 	if (mio->type == MIO_TYPE_FILE)
 		rv = fgetpos (mio->impl.file.fp, &pos->impl.file);
 	else if (mio->type == MIO_TYPE_MEMORY)
@@ -1270,6 +1713,11 @@ int mio_setpos (MIO *mio, MIOPos *pos)
 	}
 #endif /* MIO_DEBUG */
 
+#ifdef MIO_ASYNC_OUTPUT
+	if (mio->type == MIO_TYPE_FILE && mio->impl.file.async)
+		rv = fseek (file_get_synced_fp (mio), (long)pos->impl.mem, SEEK_SET);
+	else
+#endif
 	if (mio->type == MIO_TYPE_FILE)
 		rv = fsetpos (mio->impl.file.fp, &pos->impl.file);
 	else if (mio->type == MIO_TYPE_MEMORY)
@@ -1304,7 +1752,7 @@ int mio_setpos (MIO *mio, MIOPos *pos)
 int mio_flush (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
-		return fflush (mio->impl.file.fp);
+		return fflush (file_get_synced_fp (mio));
 	return 0;
 }
 
@@ -123,11 +123,15 @@ MIO *mio_new_memory (unsigned char *data,
 					 MIOReallocFunc realloc_func,
 					 MIODestroyNotify free_func);
 
+MIO *mio_new_mmap (const char *filename);
+MIO *mio_new_mmap_fd (int fd, size_t size);
+
 MIO *mio_new_mio    (MIO *base, long start, long size);
 MIO *mio_ref        (MIO *mio);
 
 int mio_unref (MIO *mio);
 FILE *mio_file_get_fp (MIO *mio);
+int mio_file_set_async_output (MIO *mio, size_t batch_size);
 unsigned char *mio_memory_get_data (MIO *mio, size_t *size);
 size_t mio_read (MIO *mio,
 				 void *ptr,
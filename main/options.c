@@ -22,14 +22,19 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>  /* to declare isspace () */
+#include <errno.h>
+#include <limits.h>
 
+#include "cache_p.h"
 #include "ctags.h"
 #include "debug.h"
 #include "entry_p.h"
 #include "field_p.h"
+#include "globset_p.h"
 #include "gvars.h"
 #include "keyword_p.h"
 #include "parse_p.h"
+#include "profile_p.h"
 #include "ptag_p.h"
 #include "routines_p.h"
 #include "xtag_p.h"
@@ -37,6 +42,7 @@
 #include "param.h"
 #include "error_p.h"
 #include "interactive_p.h"
+#include "jobs_p.h"
 #include "writer_p.h"
 #include "trace.h"
 
@@ -125,6 +131,8 @@ typedef stringList searchPathList;
 static searchPathList *OptlibPathList;
 
 static stringList *Excluded, *ExcludedException;
+/* The patterns of Excluded and ExcludedException compiled for matching */
+static globSet *ExcludedSet, *ExcludedExceptionSet;
 static bool FilesRequired = true;
 static bool SkipConfiguration;
 
@@ -137,6 +145,8 @@ bool ctags_verbose = false;
 
 optionValues Option = {
 	.append = false,
+	.update = false,
+	.tagIndex = false,
 	.backward = false,
 	.etags = false,
 	.locate =
@@ -151,6 +161,7 @@ optionValues Option = {
 	.xref = false,
 	.customXfmt = NULL,
 	.fileList = NULL,
+	.gitChanges = NULL,
 	.tagFileName = NULL,
 	.headerExt = NULL,
 	.etagsInclude = NULL,
@@ -173,6 +184,14 @@ optionValues Option = {
 	.patternLengthLimit = 96,
 	.putFieldPrefix = false,
 	.maxRecursionDepth = 0xffffffff,
+	.useIgnoreFiles = false,
+	.maxFileSize = 0,
+	.maxParseTime = 0.0,
+	.maxTagsPerFile = 0,
+	.jobs = 1,
+	.cacheDir = NULL,
+	.profileFile = NULL,
+	.sortMemory = 128 * 1024 * 1024,
 	.interactive = false,
 	.fieldsReset = false,
 #ifdef _WIN32
@@ -210,6 +229,9 @@ static OptionLoadingStage Stage = OptionLoadingStageNone;
 
 static optionDescription LongOptionDescription [] = {
  {1,0,"Input/Output Options"},
+ {1,0,"  --cache-dir=<dir>"},
+ {1,0,"       Store the tags of each input file in <dir>, and reuse them while"},
+ {1,0,"       the file and the options are unchanged."},
  {1,0,"  --exclude=<pattern>"},
  {1,0,"       Exclude files and directories matching <pattern>."},
  {1,0,"       See also --exclude-exception option."},
@@ -222,6 +244,12 @@ static optionDescription LongOptionDescription [] = {
  {1,0,"  --filter-terminator=<string>"},
  {1,0,"       Specify <string> to print to stdout following the tags for each file"},
  {1,0,"       parsed when --filter is enabled."},
+ {1,0,"  --jobs=<N>"},
+#ifdef HAVE_JOBS
+ {1,0,"       Parse input files in <N> worker processes [1]."},
+#else
+ {1,0,"       Not supported on this platform."},
+#endif
  {1,0,"  --links[=(yes|no)]"},
  {1,0,"       Indicate whether symbolic links should be followed [yes]."},
  {1,0,"  --maxdepth=<N>"},
@@ -230,6 +258,12 @@ static optionDescription LongOptionDescription [] = {
 #else
  {1,0,"       Not supported on this platform."},
 #endif
+ {1,0,"  --max-file-size=<size>[k|m|g]"},
+ {1,0,"       Skip input files larger than <size> bytes [0 (no limit)]."},
+ {1,0,"  --max-parse-time=<seconds>"},
+ {1,0,"       Skip input files taking longer than <seconds> to parse [0 (no limit)]."},
+ {1,0,"  --max-tags-per-file=<N>"},
+ {1,0,"       Skip input files making more than <N> tags [0 (no limit)]."},
  {1,0,"  --recurse[=(yes|no)]"},
 #ifdef RECURSE_SUPPORTED
  {1,0,"       Recurse into directories supplied on command line [no]."},
@@ -237,13 +271,28 @@ static optionDescription LongOptionDescription [] = {
 #else
  {1,0,"       Not supported on this platform."},
  {1,0,"  -R   Not supported on this platform."},
+#endif
+ {1,0,"  --use-ignore-files[=(yes|no)]"},
+#ifdef RECURSE_SUPPORTED
+ {1,0,"       Skip the files matched by .gitignore, .ignore, and .git/info/exclude"},
+ {1,0,"       when recursing [no]."},
+#else
+ {1,0,"       Not supported on this platform."},
 #endif
  {1,0,"  -L <file>"},
  {1,0,"       A list of input file names is read from the specified <file>."},
  {1,0,"       If specified as \"-\", then standard input is read."},
+ {1,0,"  --git-changes=<manifest>"},
+ {1,0,"       Tag the files tracked in the git working tree at the current directory"},
+ {1,0,"       that changed since the run saving <manifest>, and save <manifest>."},
+ {1,0,"       Requires --update."},
  {1,0,"  --append[=(yes|no)]"},
  {1,0,"       Should tags should be appended to existing tag file [no]?"},
  {1,0,"  -a   Append the tags to an existing tag file."},
+ {1,0,"  --update[=(yes|no)]"},
+ {1,0,"       Replace the tags of the input files in an existing tag file [no]."},
+ {1,0,"  --tag-index[=(yes|no)]"},
+ {1,0,"       Write an index of the tag file to <tagfile>.idx for readtags [no]."},
  {1,0,"  -f <tagfile>"},
  {1,0,"       Write tags to specified <tagfile>. Value of \"-\" writes tags to stdout"},
  {1,0,"       [\"tags\"; or \"TAGS\" when -e supplied]."},
@@ -266,6 +315,13 @@ static optionDescription LongOptionDescription [] = {
  {1,0,"  -x   Print a tabular cross reference file to standard output."},
  {0,0,"  --sort=(yes|no|foldcase)"},
  {0,0,"       Should tags be sorted (optionally ignoring case) [yes]?"},
+ {1,0,"  --sort-memory=<size>[k|m|g]"},
+#ifdef EXTERNAL_SORT
+ {1,0,"       Not supported in this build; the sort command is used."},
+#else
+ {1,0,"       Use about <size> bytes of memory for sorting; larger tag files"},
+ {1,0,"       are sorted with temporary files [128m]."},
+#endif
  {0,0,"  -u   Equivalent to --sort=no."},
  {1,0,"  --etags-include=<file>"},
  {1,0,"       Include reference to <file> in Emacs-style tag file (requires -e)."},
@@ -482,6 +538,9 @@ static optionDescription LongOptionDescription [] = {
  {0,0,"  --print-language"},
  {0,0,"       Don't make tags file but just print the guessed language name for"},
  {0,0,"       input file."},
+ {1,0,"  --profile=<file>"},
+ {1,0,"       Write the time spent on each input file to <file> as JSON lines, and"},
+ {1,0,"       print the slowest files to stderr."},
  {1,0,"  --quiet[=(yes|no)]"},
  {0,0,"       Don't print NOTICE class messages [no]."},
  {1,0,"  --totals[=(yes|no|extra)]"},
@@ -583,6 +642,9 @@ static struct Feature {
 #if defined (HAVE_DIRENT_H) || defined (_MSC_VER)
 	{"option-directory", "TO BE WRITTEN"},
 #endif
+#ifdef HAVE_JOBS
+	{"jobs", "can parse input files in worker processes"},
+#endif
 #ifdef HAVE_LIBXML
 	{"xpath", "linked with library for parsing xml input"},
 #endif
@@ -1168,17 +1230,34 @@ static void processEtagsInclude (
 	}
 }
 
+static void freeGlobSet (globSet **set)
+{
+	if (*set != NULL)
+	{
+		globSetDelete (*set);
+		*set = NULL;
+	}
+}
+
 static void processExcludeOptionCommon (
-	stringList** list, const char *const optname, const char *const parameter)
+	stringList** list, globSet** set,
+	const char *const optname, const char *const parameter)
 {
 	const char *const fileName = parameter + 1;
 	if (parameter [0] == '\0')
+	{
 		freeList (list);
+		freeGlobSet (set);
+	}
 	else if (parameter [0] == '@')
 	{
 		stringList* const sl = stringListNewFromFile (fileName);
 		if (sl == NULL)
 			error (FATAL | PERROR, "cannot open \"%s\"", fileName);
+		if (*set == NULL)
+			*set = globSetNew ();
+		for (unsigned int i = 0; i < stringListCount (sl); i++)
+			globSetAdd (*set, vStringValue (stringListItem (sl, i)));
 		if (*list == NULL)
 			*list = sl;
 		else
@@ -1191,6 +1270,9 @@ static void processExcludeOptionCommon (
 #if defined (_WIN32)
 		vStringTranslate(item, PATH_SEPARATOR, OUTPUT_PATH_SEPARATOR);
 #endif
+		if (*set == NULL)
+			*set = globSetNew ();
+		globSetAdd (*set, vStringValue (item));
 		if (*list == NULL)
 			*list = stringListNew ();
 		stringListAdd (*list, item);
@@ -1201,13 +1283,14 @@ static void processExcludeOptionCommon (
 static void processExcludeOption (
 		const char *const option, const char *const parameter)
 {
-	processExcludeOptionCommon (&Excluded, option, parameter);
+	processExcludeOptionCommon (&Excluded, &ExcludedSet, option, parameter);
 }
 
 static void processExcludeExceptionOption (
 		const char *const option, const char *const parameter)
 {
-	processExcludeOptionCommon (&ExcludedException, option, parameter);
+	processExcludeOptionCommon (&ExcludedException, &ExcludedExceptionSet,
+								option, parameter);
 }
 
 extern bool isExcludedFile (const char* const name,
@@ -1221,20 +1304,20 @@ extern bool isExcludedFile (const char* const name,
 		&& stringListCount (ExcludedException) > 0)
 		return false;
 
-	if (Excluded != NULL)
+	if (ExcludedSet != NULL)
 	{
-		result = stringListFileMatched (Excluded, base);
+		result = globSetMatch (ExcludedSet, base);
 		if (! result  &&  name != base)
-			result = stringListFileMatched (Excluded, name);
+			result = globSetMatch (ExcludedSet, name);
 	}
 
-	if (result && ExcludedException != NULL)
+	if (result && ExcludedExceptionSet != NULL)
 	{
 		bool result_exception;
 
-		result_exception = stringListFileMatched (ExcludedException, base);
+		result_exception = globSetMatch (ExcludedExceptionSet, base);
 		if (! result_exception && name != base)
-			result_exception = stringListFileMatched (ExcludedException, name);
+			result_exception = globSetMatch (ExcludedExceptionSet, name);
 
 		if (result_exception)
 			result = false;
@@ -1242,6 +1325,23 @@ extern bool isExcludedFile (const char* const name,
 	return result;
 }
 
+extern bool isExcludedDirectory (const char* const dirName)
+{
+	if (ExcludedSet == NULL
+		|| (ExcludedException != NULL && stringListCount (ExcludedException) > 0))
+		return false;
+
+	/* The names of the files in DIRNAME, given to isExcludedFile (),
+	 * start with this prefix; see recurseIntoDirectory () in main.c. */
+	if (strcmp (dirName, ".") == 0)
+		return globSetMatchAllWithPrefix (ExcludedSet, "");
+
+	char *const prefix = combinePathAndFile (dirName, "");
+	const bool result = globSetMatchAllWithPrefix (ExcludedSet, prefix);
+	eFree (prefix);
+	return result;
+}
+
 static void processExcmdOption (
 		const char *const option, const char *const parameter)
 {
@@ -1434,6 +1534,41 @@ static void processFieldsOption (
 	}
 }
 
+static void processCacheDirOption (
+		const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	fileStatus *status = eStat (parameter);
+	if (!status->exists || !status->isDirectory)
+		error (FATAL, "--%s: \"%s\" is not a directory", option, parameter);
+
+	freeString (&Option.cacheDir);
+	Option.cacheDir = stringCopy (parameter);
+}
+
+static void processGitChangesOption (
+		const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	freeString (&Option.gitChanges);
+	Option.gitChanges = stringCopy (parameter);
+}
+
+static void processProfileOption (
+		const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	freeString (&Option.profileFile);
+	Option.profileFile = stringCopy (parameter);
+	openProfile (Option.profileFile);
+}
+
 static void processFilterTerminatorOption (
 		const char *const option CTAGS_ATTR_UNUSED, const char *const parameter)
 {
@@ -2507,6 +2642,61 @@ static void processSortOption (
 		error (FATAL, "Invalid value for \"%s\" option", option);
 }
 
+/* Parse a size with an optional suffix k, m, or g. */
+/* Return false on overflow as well as on a malformed STR. */
+static bool strToSize (const char *const str, unsigned long *size)
+{
+	char *end;
+	int shifts = 0;
+
+	/* strtoul () accepts a negative number and negates it. */
+	if (!isdigit ((unsigned char) *str))
+		return false;
+
+	errno = 0;
+	*size = strtoul (str, &end, 10);
+	if (errno == ERANGE)
+		return false;
+
+	switch (*end)
+	{
+		case 'g': case 'G':
+			shifts++;
+			/* Fall through */
+		case 'm': case 'M':
+			shifts++;
+			/* Fall through */
+		case 'k': case 'K':
+			shifts++;
+			end++;
+			break;
+	}
+	for (; shifts > 0; shifts--)
+	{
+		if (*size > ULONG_MAX / 1024)
+			return false;
+		*size *= 1024;
+	}
+	return (*end == '\0');
+}
+
+static void processSortMemoryOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long size;
+
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	if (!strToSize (parameter, &size) || size == 0)
+		error (FATAL, "-%s: Invalid memory size: %s", option, parameter);
+
+#ifdef EXTERNAL_SORT
+	error (WARNING, "-%s: ignored; the sort command is used for sorting", option);
+#endif
+	Option.sortMemory = size;
+}
+
 static void processTagRelative (
 		const char *const option, const char *const parameter)
 {
@@ -2784,6 +2974,36 @@ static void processOptlibDir (
 	}
 }
 
+static void processMaxFileSizeOption (const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	if (!strToSize (parameter, &Option.maxFileSize))
+		error (FATAL, "-%s: Invalid file size: %s", option, parameter);
+}
+
+static void processMaxParseTimeOption (const char *const option, const char *const parameter)
+{
+	char *end;
+
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	Option.maxParseTime = strtod (parameter, &end);
+	if (end == parameter || *end != '\0' || !(Option.maxParseTime >= 0.0))
+		error (FATAL, "-%s: Invalid number of seconds: %s", option, parameter);
+}
+
+static void processMaxTagsPerFileOption (const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	if (!strToUInt (parameter, 10, &Option.maxTagsPerFile))
+		error (FATAL, "-%s: Invalid number of tags: %s", option, parameter);
+}
+
 static void processMaxRecursionDepthOption (const char *const option, const char *const parameter)
 {
 	if (parameter == NULL || parameter[0] == '\0')
@@ -2795,6 +3015,20 @@ static void processMaxRecursionDepthOption (const char *const option, const char
 	Option.maxRecursionDepth = atol(parameter);
 }
 
+static void processJobsOption (const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	if (!strToUInt (parameter, 0, &Option.jobs) || Option.jobs < 1)
+		error (FATAL, "-%s: Invalid number of jobs", option);
+
+#ifndef HAVE_JOBS
+	if (Option.jobs > 1)
+		error (WARNING, "-%s: not supported on this platform; parsing files in a process", option);
+#endif
+}
+
 static void processPatternLengthLimit(const char *const option, const char *const parameter)
 {
 	if (parameter == NULL || parameter[0] == '\0')
@@ -2842,6 +3076,7 @@ static void processDumpOptionsOption (const char *const option, const char *cons
 static void processDumpPreludeOption (const char *const option, const char *const parameter);
 
 static parametricOption ParametricOptions [] = {
+	{ "cache-dir",              processCacheDirOption,          true,   STAGE_ANY },
 	{ "etags-include",          processEtagsInclude,            false,  STAGE_ANY },
 	{ "exclude",                processExcludeOption,           false,  STAGE_ANY },
 	{ "exclude-exception",      processExcludeExceptionOption,  false,  STAGE_ANY },
@@ -2851,6 +3086,7 @@ static parametricOption ParametricOptions [] = {
 	{ "fields",                 processFieldsOption,            false,  STAGE_ANY },
 	{ "filter-terminator",      processFilterTerminatorOption,  true,   STAGE_ANY },
 	{ "format",                 processFormatOption,            true,   STAGE_ANY },
+	{ "git-changes",            processGitChangesOption,        true,   STAGE_ANY },
 	{ "help",                   processHelpOption,              true,   STAGE_ANY },
 	{ "help-full",              processHelpFullOption,          true,   STAGE_ANY },
 	{ "if0",                    processIf0Option,               false,  STAGE_ANY },
@@ -2858,6 +3094,7 @@ static parametricOption ParametricOptions [] = {
 	{ "input-encoding",         processInputEncodingOption,     false,  STAGE_ANY },
 	{ "output-encoding",        processOutputEncodingOption,    false,  STAGE_ANY },
 #endif
+	{ "jobs",                   processJobsOption,              true,   STAGE_ANY },
 	{ "lang",                   processLanguageForceOption,     false,  STAGE_ANY },
 	{ "language",               processLanguageForceOption,     false,  STAGE_ANY },
 	{ "language-force",         processLanguageForceOption,     false,  STAGE_ANY },
@@ -2883,13 +3120,18 @@ static parametricOption ParametricOptions [] = {
 	{ "list-roles",             processListRolesOptions,        true,   STAGE_ANY },
 	{ "list-subparsers",        processListSubparsersOptions,   true,   STAGE_ANY },
 	{ "maxdepth",               processMaxRecursionDepthOption, true,   STAGE_ANY },
+	{ "max-file-size",          processMaxFileSizeOption,       true,   STAGE_ANY },
+	{ "max-parse-time",         processMaxParseTimeOption,      true,   STAGE_ANY },
+	{ "max-tags-per-file",      processMaxTagsPerFileOption,    true,   STAGE_ANY },
 	{ "optlib-dir",             processOptlibDir,               false,  STAGE_ANY },
 	{ "options",                processOptionFile,              false,  STAGE_ANY },
 	{ "options-maybe",          processOptionFileMaybe,         false,  STAGE_ANY },
 	{ "output-format",          processOutputFormat,            true,   STAGE_ANY },
 	{ "pattern-length-limit",   processPatternLengthLimit,      true,   STAGE_ANY },
+	{ "profile",                processProfileOption,           true,   STAGE_ANY },
 	{ "pseudo-tags",            processPseudoTags,              false,  STAGE_ANY },
 	{ "sort",                   processSortOption,              true,   STAGE_ANY },
+	{ "sort-memory",            processSortMemoryOption,        true,   STAGE_ANY },
 	{ "tag-relative",           processTagRelative,             true,   STAGE_ANY },
 	{ "totals",                 processTotals,                  true,   STAGE_ANY },
 	{ "version",                processVersionOption,           true,   STAGE_ANY },
@@ -2928,6 +3170,9 @@ static booleanOption BooleanOptions [] = {
 #ifdef RECURSE_SUPPORTED
 	{ "recurse",        &Option.recurse,                false, STAGE_ANY },
 #endif
+	{ "tag-index",      &Option.tagIndex,               true,  STAGE_ANY },
+	{ "update",         &Option.update,                 true,  STAGE_ANY },
+	{ "use-ignore-files", &Option.useIgnoreFiles,       false, STAGE_ANY },
 	{ "verbose",        &ctags_verbose,                 false, STAGE_ANY },
 #ifdef _WIN32
 	{ "use-slash-as-filename-separator", (bool *)&Option.useSlashAsFilenameSeparator, false, STAGE_ANY },
@@ -3494,12 +3739,16 @@ static void parseOption (cookedArgs* const args)
 	if (args->isOption)
 	{
 		if (args->longOption)
+		{
+			addOptionToCacheFingerprint (true, args->item, args->parameter);
 			processLongOption (args->item, args->parameter);
+		}
 		else
 		{
 			const char *parameter = args->parameter;
 			while (*parameter == ' ')
 				++parameter;
+			addOptionToCacheFingerprint (false, args->item, parameter);
 			processShortOption (args->item, parameter);
 		}
 		cArgForth (args);
@@ -3943,9 +4192,14 @@ extern void freeOptionResources (void)
 	freeString (&Option.tagFileName);
 	freeString (&Option.fileList);
 	freeString (&Option.filterTerminator);
+	freeString (&Option.cacheDir);
+	freeString (&Option.gitChanges);
+	freeString (&Option.profileFile);
 
 	freeList (&Excluded);
 	freeList (&ExcludedException);
+	freeGlobSet (&ExcludedSet);
+	freeGlobSet (&ExcludedExceptionSet);
 	freeList (&Option.headerExt);
 	freeList (&Option.etagsInclude);
 
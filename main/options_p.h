@@ -74,14 +74,18 @@ typedef enum eTagRelative {
  */
 typedef struct sOptionValues {
 	bool append;         /* -a  append to "tags" file */
+	bool update;         /* --update  replace the tags of the input files */
+	bool tagIndex;       /* --tag-index  write <tagfile>.idx */
 	bool backward;       /* -B  regexp patterns search backwards */
 	bool etags;          /* -e  output Emacs style tags file */
 	exCmd locate;           /* --excmd  EX command used to locate tag */
 	bool recurse;        /* -R  recurse into directories */
 	sortType sorted;        /* -u,--sort  sort tags */
+	unsigned long sortMemory; /* --sort-memory=SIZE  memory used for sorting */
 	bool xref;           /* -x  generate xref output instead */
 	fmtElement *customXfmt;	/* compiled code for --xformat=XFMT */
 	char *fileList;         /* -L  name of file containing names of files */
+	char *gitChanges;       /* --git-changes=MANIFEST  tag the files changed in the git working tree */
 	char *tagFileName;      /* -o  name of tags file */
 	stringList* headerExt;  /* -h  header extensions */
 	stringList* etagsInclude;/* --etags-include  list of TAGS files to include*/
@@ -104,6 +108,13 @@ typedef struct sOptionValues {
 	unsigned int patternLengthLimit; /* --pattern-length-limit=N */
 	bool putFieldPrefix;		 /* --put-field-prefix */
 	unsigned int maxRecursionDepth; /* --maxdepth=<max-recursion-depth> */
+	bool useIgnoreFiles;	/* --use-ignore-files  skip the files ignored by git in recursion */
+	unsigned long maxFileSize;	/* --max-file-size=SIZE  0 for no limit */
+	double maxParseTime;		/* --max-parse-time=SECONDS  0 for no limit */
+	unsigned int maxTagsPerFile; /* --max-tags-per-file=N  0 for no limit */
+	unsigned int jobs;	/* --jobs=N  number of worker processes */
+	char *cacheDir;		/* --cache-dir=DIR  directory storing the tags of input files */
+	char *profileFile;	/* --profile=FILE  file recording the time spent on each input file */
 	bool fieldsReset;				/* --fields=[^+-] */
 	enum interactiveMode { INTERACTIVE_NONE = 0,
 						   INTERACTIVE_DEFAULT,
@@ -148,6 +159,9 @@ extern const char* cArgItem (cookedArgs* const current);
 extern void cArgForth (cookedArgs* const current);
 extern bool isExcludedFile (const char* const name,
 							bool falseIfExceptionsAreDefeind);
+/* True if --exclude excludes every file in DIRNAME, so that --recurse
+ * doesn't have to read it. */
+extern bool isExcludedDirectory (const char* const dirName);
 extern bool isIncludeFile (const char *const fileName);
 extern void parseCmdlineOptions (cookedArgs* const cargs);
 extern void previewFirstOption (cookedArgs* const cargs);
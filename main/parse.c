@@ -19,18 +19,22 @@
 
 #include <string.h>
 
+#include "cache_p.h"
 #include "ctags.h"
 #include "debug.h"
 #include "entry_p.h"
 #include "field_p.h"
 #include "flags_p.h"
 #include "htable.h"
+#include "jobs_p.h"
 #include "keyword.h"
 #include "lxpath_p.h"
+#include "numarray.h"
 #include "param.h"
 #include "param_p.h"
 #include "parse_p.h"
 #include "parsers_p.h"
+#include "profile_p.h"
 #include "promise.h"
 #include "promise_p.h"
 #include "ptag_p.h"
@@ -109,6 +113,14 @@ typedef struct sParserObject {
 											is specified. */
 } parserObject;
 
+/* An entry of the indexes of the language maps. A list of entries for
+ * a key is sorted by language. */
+typedef struct sMapIndexEntry {
+	langType language;
+	vString *spec;
+	struct sMapIndexEntry *next;
+} mapIndexEntry;
+
 /*
  * FUNCTION PROTOTYPES
  */
@@ -160,6 +172,17 @@ static parserDefinitionFunc* BuiltInParsers[] = {
 static parserObject* LanguageTable = NULL;
 static unsigned int LanguageCount = 0;
 static hashTable* LanguageHTable = NULL;
+
+/* Indexes of currentExtensions and currentPatterns of all the languages,
+ * made when choosing a parser for an input file. Patterns having no
+ * wildcard are put to PatternIndex. The languages having a pattern with
+ * a wildcard are listed in GlobPatternLanguages, and their patterns are
+ * tried with fnmatch as before. */
+static bool MapIndexValid = false;
+static hashTable* ExtensionIndex = NULL;
+static hashTable* PatternIndex = NULL;
+static langType* GlobPatternLanguages = NULL;
+static unsigned int GlobPatternLanguageCount = 0;
 static kindDefinition defaultFileKind = {
 	.enabled     = false,
 	.letter      = KIND_FILE_DEFAULT_LETTER,
@@ -169,6 +192,28 @@ static kindDefinition defaultFileKind = {
 
 static langType ctagsSelfTestLang;
 
+/* The clock is read at every PARSE_BUDGET_CLOCK_INTERVAL lines and tags. */
+#define PARSE_BUDGET_CLOCK_INTERVAL 256
+
+bool ParseBudgetEnabled;
+
+static struct sParseBudget {
+	parseLimit exceeded;
+	unsigned long tags;
+	unsigned int untilClockCheck;
+	double deadline;
+	/* Parsers whose pseudo tags are written while parsing the file.
+	 * They are written again if the tags of the file are discarded. */
+	intArray *ptagLanguages;
+} ParseBudget;
+
+static const char *const ParseLimitNames [] = {
+	[PARSE_LIMIT_NONE]       = NULL,
+	[PARSE_LIMIT_FILE_SIZE]  = "max-file-size",
+	[PARSE_LIMIT_PARSE_TIME] = "max-parse-time",
+	[PARSE_LIMIT_TAGS]       = "max-tags-per-file",
+};
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -470,28 +515,160 @@ extern langType getLanguageForCommand (const char *const command, langType start
 											&tmp_specType);
 }
 
+static void deleteMapIndexEntries (void *data)
+{
+	mapIndexEntry *entry = data;
+
+	while (entry)
+	{
+		mapIndexEntry *next = entry->next;
+		eFree (entry);
+		entry = next;
+	}
+}
+
+static void invalidateMapIndex (void)
+{
+	MapIndexValid = false;
+}
+
+static void freeMapIndex (void)
+{
+	if (ExtensionIndex)
+	{
+		hashTableDelete (ExtensionIndex);
+		ExtensionIndex = NULL;
+	}
+	if (PatternIndex)
+	{
+		hashTableDelete (PatternIndex);
+		PatternIndex = NULL;
+	}
+	if (GlobPatternLanguages)
+	{
+		eFree (GlobPatternLanguages);
+		GlobPatternLanguages = NULL;
+	}
+	GlobPatternLanguageCount = 0;
+	MapIndexValid = false;
+}
+
+static void addMapIndexEntry (hashTable *index, langType language, vString *spec)
+{
+	mapIndexEntry *head = hashTableGetItem (index, vStringValue (spec));
+	mapIndexEntry *last = NULL;
+
+	for (mapIndexEntry *e = head; e; e = e->next)
+	{
+		/* Like stringListFinds, the first one in the list wins. */
+		if (e->language == language)
+			return;
+		last = e;
+	}
+
+	mapIndexEntry *entry = xMalloc (1, mapIndexEntry);
+	entry->language = language;
+	entry->spec = spec;
+	entry->next = NULL;
+
+	if (last)
+		last->next = entry;
+	else
+		hashTablePutItem (index, vStringValue (spec), entry);
+}
+
+static bool isGlobPattern (const char *const pattern)
+{
+	return strpbrk (pattern, "*?[\\") != NULL;
+}
+
+static void buildMapIndex (void)
+{
+	freeMapIndex ();
+
+#ifdef CASE_INSENSITIVE_FILENAMES
+	ExtensionIndex = hashTableNew (1021, hashCstrcasehash, hashCstrcaseeq,
+								   NULL, deleteMapIndexEntries);
+	PatternIndex = hashTableNew (127, hashCstrcasehash, hashCstrcaseeq,
+								 NULL, deleteMapIndexEntries);
+#else
+	ExtensionIndex = hashTableNew (1021, hashCstrhash, hashCstreq,
+								   NULL, deleteMapIndexEntries);
+	PatternIndex = hashTableNew (127, hashCstrhash, hashCstreq,
+								 NULL, deleteMapIndexEntries);
+#endif
+	GlobPatternLanguages = xMalloc (LanguageCount? LanguageCount: 1, langType);
+
+	for (unsigned int i = 0; i < LanguageCount; i++)
+	{
+		parserObject *parser = LanguageTable + i;
+		stringList *exts = parser->currentExtensions;
+		stringList *ptrns = parser->currentPatterns;
+		bool glob = false;
+
+		for (unsigned int j = 0; exts && j < stringListCount (exts); j++)
+			addMapIndexEntry (ExtensionIndex, i, stringListItem (exts, j));
+
+		for (unsigned int j = 0; ptrns && j < stringListCount (ptrns) && !glob; j++)
+			glob = isGlobPattern (vStringValue (stringListItem (ptrns, j)));
+
+		if (glob)
+			GlobPatternLanguages [GlobPatternLanguageCount++] = i;
+		else
+			for (unsigned int j = 0; ptrns && j < stringListCount (ptrns); j++)
+				addMapIndexEntry (PatternIndex, i, stringListItem (ptrns, j));
+	}
+
+	MapIndexValid = true;
+}
+
 static langType getPatternLanguageAndSpec (const char *const baseName, langType start_index,
 					   const char **const spec, enum specType *specType)
 {
 	langType result = LANG_IGNORE;
-	unsigned int i;
+	mapIndexEntry *literal;
+	unsigned int g = 0;
 
 	if (start_index == LANG_AUTO)
 	        start_index = 0;
 	else if (start_index == LANG_IGNORE || start_index >= (int) LanguageCount)
 		return result;
 
+	if (!MapIndexValid)
+		buildMapIndex ();
+
 	*spec = NULL;
-	for (i = start_index  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
-	{
-		if (! isLanguageEnabled (i))
-			continue;
 
-		parserObject *parser = LanguageTable + i;
-		stringList* const ptrns = parser->currentPatterns;
+	/* Visit the languages having a matching literal pattern and the
+	 * languages having wildcard patterns in the order of the table. */
+	literal = hashTableGetItem (PatternIndex, baseName);
+	while (literal && literal->language < start_index)
+		literal = literal->next;
+	while (g < GlobPatternLanguageCount && GlobPatternLanguages [g] < start_index)
+		g++;
+
+	while (literal || g < GlobPatternLanguageCount)
+	{
+		langType i;
 		vString* tmp;
 
-		if (ptrns != NULL && (tmp = stringListFileFinds (ptrns, baseName)))
+		if (literal && (g == GlobPatternLanguageCount
+						|| literal->language < GlobPatternLanguages [g]))
+		{
+			i = literal->language;
+			tmp = literal->spec;
+			literal = literal->next;
+		}
+		else
+		{
+			i = GlobPatternLanguages [g++];
+			tmp = NULL;
+			if (isLanguageEnabled (i))
+				tmp = stringListFileFinds (LanguageTable [i].currentPatterns,
+										   baseName);
+		}
+
+		if (tmp && isLanguageEnabled (i))
 		{
 			result = i;
 			*spec = vStringValue(tmp);
@@ -500,23 +677,16 @@ static langType getPatternLanguageAndSpec (const char *const baseName, langType
 		}
 	}
 
-	for (i = start_index  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
+	for (mapIndexEntry *e = hashTableGetItem (ExtensionIndex, fileExtension (baseName));
+		 e; e = e->next)
 	{
-		if (! isLanguageEnabled (i))
+		if (e->language < start_index || ! isLanguageEnabled (e->language))
 			continue;
 
-		parserObject *parser = LanguageTable + i;
-		stringList* const exts = parser->currentExtensions;
-		vString* tmp;
-
-		if (exts != NULL && (tmp = stringListExtensionFinds (exts,
-								     fileExtension (baseName))))
-		{
-			result = i;
-			*spec = vStringValue(tmp);
-			*specType = SPEC_EXTENSION;
-			goto found;
-		}
+		result = e->language;
+		*spec = vStringValue(e->spec);
+		*specType = SPEC_EXTENSION;
+		goto found;
 	}
 found:
 	return result;
@@ -1103,43 +1273,20 @@ static vString* extractPHPMark(MIO* input)
 struct getLangCtx {
     const char *fileName;
     MIO        *input;
+    inputFileHandle *handle;
     bool     err;
 };
 
-#define GLC_FOPEN_IF_NECESSARY0(_glc_, _label_) do {        \
-    if (!(_glc_)->input) {                                  \
-	    (_glc_)->input = getMio((_glc_)->fileName, "rb", false);	\
-        if (!(_glc_)->input) {                              \
-            (_glc_)->err = true;                            \
-            goto _label_;                                   \
-        }                                                   \
-    }                                                       \
-} while (0)                                                 \
-
 #define GLC_FOPEN_IF_NECESSARY(_glc_, _label_, _doesParserRequireMemoryStream_) \
 	do {								\
-		if (!(_glc_)->input)					\
-			GLC_FOPEN_IF_NECESSARY0 (_glc_, _label_);	\
-		if ((_doesParserRequireMemoryStream_) &&		\
-		    (mio_memory_get_data((_glc_)->input, NULL) == NULL)) \
-		{							\
-			MIO *tmp_ = (_glc_)->input;			\
-			(_glc_)->input = mio_new_mio (tmp_, 0, -1);	\
-			mio_unref (tmp_);				\
-			if (!(_glc_)->input) {				\
-				(_glc_)->err = true;			\
-				goto _label_;				\
-			}						\
+		(_glc_)->input = openInputFileHandle ((_glc_)->handle,	\
+						      (_doesParserRequireMemoryStream_)); \
+		if (!(_glc_)->input) {					\
+			(_glc_)->err = true;				\
+			goto _label_;					\
 		}							\
 	} while (0)
 
-#define GLC_FCLOSE(_glc_) do {                              \
-    if ((_glc_)->input) {                                   \
-        mio_unref((_glc_)->input);                             \
-        (_glc_)->input = NULL;                              \
-    }                                                       \
-} while (0)
-
 static const struct taster {
 	vString* (* taste) (MIO *);
 	const char     *msg;
@@ -1429,10 +1576,8 @@ tasteLanguage (struct getLangCtx *glc, const struct taster *const tasters, int n
 
 
 struct GetLanguageRequest {
-	enum { GLR_OPEN, GLR_DISCARD, GLR_REUSE, } type;
 	const char *const fileName;
-	MIO *mio;
-	time_t mtime;
+	inputFileHandle *handle;
 };
 
 static langType
@@ -1472,12 +1617,13 @@ getFileLanguageForRequestInternal (struct GetLanguageRequest *req)
     int i;
     struct getLangCtx glc = {
         .fileName = fileName,
-        .input    = (req->type == GLR_REUSE)? mio_ref (req->mio): NULL,
+        .input    = req->handle->mio,
+        .handle   = req->handle,
         .err      = false,
     };
     const char* const baseName = baseFilename (fileName);
     char *templateBaseName = NULL;
-    fileStatus *fstatus = NULL;
+    const fileStatus *fstatus = NULL;
 
     for (i = 0; i < N_HINTS; i++)
 	fallback [i] = LANG_IGNORE;
@@ -1506,7 +1652,7 @@ getFileLanguageForRequestInternal (struct GetLanguageRequest *req)
     }
 
 	/* If the input is already opened, we don't have to verify the existence. */
-    if (glc.input || ((fstatus = eStat (fileName)) && fstatus->exists))
+    if (glc.input || (fstatus = getInputFileHandleStatus (glc.handle))->exists)
     {
 	    if ((fstatus && fstatus->isExecutable) || Option.guessLanguageEagerly)
 	    {
@@ -1529,17 +1675,6 @@ getFileLanguageForRequestInternal (struct GetLanguageRequest *req)
 
 
   cleanup:
-	if (req->type == GLR_OPEN && glc.input)
-	{
-		req->mio = mio_ref (glc.input);
-		if (!fstatus)
-			fstatus = eStat (fileName);
-		if (fstatus)
-			req->mtime = fstatus->mtime;
-	}
-    GLC_FCLOSE(&glc);
-    if (fstatus)
-	    eStatFree (fstatus);
     if (templateBaseName)
         eFree (templateBaseName);
 
@@ -1582,13 +1717,17 @@ static langType getFileLanguageForRequest (struct GetLanguageRequest *req)
 
 extern langType getLanguageForFilenameAndContents (const char *const fileName)
 {
+	inputFileHandle handle;
 	struct GetLanguageRequest req = {
-		.type = GLR_DISCARD,
 		.fileName = fileName,
-		.mtime = (time_t)0,
+		.handle = &handle,
 	};
+	langType language;
 
-	return getFileLanguageForRequest (&req);
+	initInputFileHandle (&handle, fileName, NULL);
+	language = getFileLanguageForRequest (&req);
+	finiInputFileHandle (&handle);
+	return language;
 }
 
 typedef void (*languageCallback)  (langType language, void* user_data);
@@ -1651,6 +1790,7 @@ extern void installLanguageMapDefault (const langType language)
 		parser->currentExtensions =
 			stringListNewFromArgv (parser->def->extensions);
 	}
+	invalidateMapIndex ();
 	BEGIN_VERBOSE(vfp);
 	{
 	printLanguageMap (language, vfp);
@@ -1708,6 +1848,7 @@ extern void clearLanguageMap (const langType language)
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	stringListClear ((LanguageTable + language)->currentPatterns);
 	stringListClear ((LanguageTable + language)->currentExtensions);
+	invalidateMapIndex ();
 }
 
 extern void clearLanguageAliases (const langType language)
@@ -1727,6 +1868,7 @@ static bool removeLanguagePatternMap1(const langType language, const char *const
 	if (ptrn != NULL && stringListDeleteItemExtension (ptrn, pattern))
 	{
 		verbose (" (removed from %s)", getLanguageName (language));
+		invalidateMapIndex ();
 		result = true;
 	}
 	return result;
@@ -1757,6 +1899,7 @@ extern void addLanguagePatternMap (const langType language, const char* ptrn,
 	if (exclusiveInAllLanguages)
 		removeLanguagePatternMap (LANG_AUTO, ptrn);
 	stringListAdd (parser->currentPatterns, str);
+	invalidateMapIndex ();
 }
 
 static bool removeLanguageExtensionMap1 (const langType language, const char *const extension)
@@ -1767,6 +1910,7 @@ static bool removeLanguageExtensionMap1 (const langType language, const char *co
 	if (exts != NULL  &&  stringListDeleteItemExtension (exts, extension))
 	{
 		verbose (" (removed from %s)", getLanguageName (language));
+		invalidateMapIndex ();
 		result = true;
 	}
 	return result;
@@ -1796,6 +1940,7 @@ extern void addLanguageExtensionMap (
 	if (exclusiveInAllLanguages)
 		removeLanguageExtensionMap (LANG_AUTO, extension);
 	stringListAdd ((LanguageTable + language)->currentExtensions, str);
+	invalidateMapIndex ();
 }
 
 extern void addLanguageAlias (const langType language, const char* alias)
@@ -2087,6 +2232,8 @@ extern void initializeParsing (void)
 extern void freeParserResources (void)
 {
 	unsigned int i;
+
+	freeMapIndex ();
 	for (i = 0  ;  i < LanguageCount  ;  ++i)
 	{
 		parserObject* const parser = LanguageTable + i;
@@ -2115,6 +2262,7 @@ extern void freeParserResources (void)
 		eFree (parser->def);
 		parser->def = NULL;
 	}
+	invalidateMapIndex ();
 	if (LanguageTable != NULL)
 		eFree (LanguageTable);
 	LanguageTable = NULL;
@@ -2454,6 +2602,7 @@ extern void processLanguageDefineOption (
 
 	LanguageTable [def->id].currentPatterns = stringListNew ();
 	LanguageTable [def->id].currentExtensions = stringListNew ();
+	invalidateMapIndex ();
 	LanguageTable [def->id].pretendingAsLanguage = LANG_IGNORE;
 	LanguageTable [def->id].pretendedAsLanguage = LANG_IGNORE;
 
@@ -4178,6 +4327,7 @@ extern void printParserStatisticsIfUsed (langType language)
 			fputs("==============================================\n", stderr);
 			parser->def->printStats (language);
 		}
+		printLanguageRegexStatistics (language);
 		printLanguageMultitableStatistics (language);
 	}
 }
@@ -4291,31 +4441,174 @@ extern bool runParserInNarrowedInputStream (const langType language,
 
 }
 
+extern const char *getParseLimitName (parseLimit limit)
+{
+	return ParseLimitNames [limit];
+}
+
+extern parseLimit getExceededParseLimit (void)
+{
+	return ParseBudget.exceeded;
+}
+
+static void reportSkippedFile (const char *const fileName, parseLimit limit)
+{
+	switch (limit)
+	{
+		case PARSE_LIMIT_FILE_SIZE:
+			error (WARNING, "skipping %s: larger than %lu bytes (--%s)",
+				   fileName, Option.maxFileSize, getParseLimitName (limit));
+			break;
+		case PARSE_LIMIT_PARSE_TIME:
+			error (WARNING, "skipping %s: parsing takes more than %g seconds (--%s)",
+				   fileName, Option.maxParseTime, getParseLimitName (limit));
+			break;
+		case PARSE_LIMIT_TAGS:
+			error (WARNING, "skipping %s: more than %u tags (--%s)",
+				   fileName, Option.maxTagsPerFile, getParseLimitName (limit));
+			break;
+		default:
+			AssertNotReached ();
+	}
+}
+
+static bool isFileTooLarge (inputFileHandle *handle)
+{
+	if (Option.maxFileSize == 0)
+		return false;
+
+	const fileStatus *status = getInputFileHandleStatus (handle);
+	return (status->exists && status->size > Option.maxFileSize);
+}
+
+static void beginParseBudget (void)
+{
+	ParseBudgetEnabled = (Option.maxParseTime > 0 || Option.maxTagsPerFile > 0);
+	if (!ParseBudgetEnabled)
+		return;
+
+	ParseBudget.tags = 0;
+	ParseBudget.untilClockCheck = PARSE_BUDGET_CLOCK_INTERVAL;
+	if (Option.maxParseTime > 0)
+		ParseBudget.deadline = getMonotonicTime () + Option.maxParseTime;
+	if (ParseBudget.ptagLanguages == NULL)
+		ParseBudget.ptagLanguages = intArrayNew ();
+	intArrayClear (ParseBudget.ptagLanguages);
+}
+
+static bool chargeParseBudget (void)
+{
+	if (ParseBudget.exceeded != PARSE_LIMIT_NONE)
+		return false;
+
+	if (--ParseBudget.untilClockCheck == 0)
+	{
+		ParseBudget.untilClockCheck = PARSE_BUDGET_CLOCK_INTERVAL;
+		if (Option.maxParseTime > 0
+			&& getMonotonicTime () > ParseBudget.deadline)
+		{
+			ParseBudget.exceeded = PARSE_LIMIT_PARSE_TIME;
+			return false;
+		}
+	}
+	return true;
+}
+
+extern bool chargeParseBudgetForLine (void)
+{
+	return chargeParseBudget ();
+}
+
+extern bool chargeParseBudgetForTag (void)
+{
+	if (!chargeParseBudget ())
+		return false;
+
+	if (Option.maxTagsPerFile > 0
+		&& ++ParseBudget.tags > Option.maxTagsPerFile)
+	{
+		ParseBudget.exceeded = PARSE_LIMIT_TAGS;
+		return false;
+	}
+	return true;
+}
+
+/* Discard the tags written since TAGFPOS like a failed rescan. The
+ * parser specific pseudo tags are written again. */
+static void discardTagsOfSkippedFile (MIOPos *tagfpos, unsigned long numTags)
+{
+	setTagFilePosition (tagfpos, true);
+	setNumTagsAdded (numTags);
+	writerRescanFailed (numTags);
+
+	for (unsigned int i = 0; i < intArrayCount (ParseBudget.ptagLanguages); i++)
+	{
+		langType language = intArrayItem (ParseBudget.ptagLanguages, i);
+		LanguageTable [language].pseudoTagPrinted = 0;
+		addParserPseudoTags (language);
+	}
+}
+
 static bool createTagsWithFallback (
 	const char *const fileName, const langType language,
-	MIO *mio, time_t mtime, bool *failureInOpenning)
+	inputFileHandle *handle, bool *failureInOpenning)
 {
 	langType exclusive_subparser = LANG_IGNORE;
 	bool tagFileResized = false;
+	unsigned long numTags = 0;
+	MIOPos tagfpos;
+	int lastPromise = 0;
 
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 
-	if (!openInputFile (fileName, language, mio, mtime))
+	ParseBudget.exceeded = PARSE_LIMIT_NONE;
+	if (!openInputFile (fileName, language, handle))
 	{
 		*failureInOpenning = true;
 		return false;
 	}
 	*failureInOpenning = false;
 
+	beginParseBudget ();
+	if (ParseBudgetEnabled)
+	{
+		numTags = numTagsAdded ();
+		tagFilePosition (&tagfpos);
+		lastPromise = getLastPromise ();
+	}
+
+	profileEnter (PROFILE_PARSE);
 	tagFileResized = createTagsWithFallback1 (language,
 											  &exclusive_subparser);
+	profileLeave ();
+
+	/* The guest parsers are not run for a skipped file. */
+	if (ParseBudget.exceeded != PARSE_LIMIT_NONE)
+		breakPromisesAfter (lastPromise);
+
+	profileEnter (PROFILE_PROMISE);
 	tagFileResized = forcePromises()? true: tagFileResized;
+	profileLeave ();
 
-	pushLanguage ((exclusive_subparser == LANG_IGNORE)
-				  ? language
-				  : exclusive_subparser);
-	makeFileTag (fileName);
-	popLanguage ();
+	if (ParseBudgetEnabled)
+	{
+		ParseBudgetEnabled = false;
+		if (ParseBudget.exceeded != PARSE_LIMIT_NONE)
+		{
+			reportSkippedFile (fileName, ParseBudget.exceeded);
+			discardTagsOfSkippedFile (&tagfpos, numTags);
+			tagFileResized = true;
+		}
+	}
+
+	if (ParseBudget.exceeded == PARSE_LIMIT_NONE)
+	{
+		pushLanguage ((exclusive_subparser == LANG_IGNORE)
+					  ? language
+					  : exclusive_subparser);
+		makeFileTag (fileName);
+		popLanguage ();
+	}
 	closeInputFile ();
 
 	return tagFileResized;
@@ -4405,17 +4698,41 @@ extern const char *getLanguageEncoding (const langType language)
 static void addParserPseudoTags (langType language)
 {
 	parserObject *parser = LanguageTable + language;
+
+	/* A cache entry records the request whether the pseudo tags
+	 * are already printed or not. */
+	if (isCacheRecording ())
+	{
+		requestParserPseudoTagsForCache (language);
+		return;
+	}
+
 	if (!parser->pseudoTagPrinted)
 	{
-		for (int i = 0; i < PTAG_COUNT; i++)
+		/* With --jobs, only the parent process knows whether the pseudo
+		 * tags are already printed or not. */
+		if (isJobWorker ())
+			requestParserPseudoTagsForJob (language);
+		else
 		{
-			if (isPtagParserSpecific (i))
-				makePtagIfEnabled (i, language, parser);
+			for (int i = 0; i < PTAG_COUNT; i++)
+			{
+				if (isPtagParserSpecific (i))
+					makePtagIfEnabled (i, language, parser);
+			}
+			if (ParseBudgetEnabled)
+				intArrayAdd (ParseBudget.ptagLanguages, language);
 		}
 		parser->pseudoTagPrinted = 1;
 	}
 }
 
+extern void makeParserPseudoTags (const langType language)
+{
+	initializeParser (language);
+	addParserPseudoTags (language);
+}
+
 extern bool doesParserRequireMemoryStream (const langType language)
 {
 	Assert (0 <= language  &&  language < (int) LanguageCount);
@@ -4457,7 +4774,8 @@ extern bool parseFile (const char *const fileName)
 	return bRet;
 }
 
-static bool parseMio (const char *const fileName, langType language, MIO* mio, time_t mtime, bool useSourceFileTagPath,
+static bool parseMio (const char *const fileName, langType language,
+					  inputFileHandle *handle, bool useSourceFileTagPath,
 					  void *clientData)
 {
 	bool tagFileResized = false;
@@ -4469,7 +4787,7 @@ static bool parseMio (const char *const fileName, langType language, MIO* mio, t
 
 	initParserTrashBox ();
 
-	tagFileResized = createTagsWithFallback (fileName, language, mio, mtime, &failureInOpenning);
+	tagFileResized = createTagsWithFallback (fileName, language, handle, &failureInOpenning);
 
 	finiParserTrashBox ();
 
@@ -4486,19 +4804,35 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 {
 	bool tagFileResized = false;
 	langType language;
+	parseLimit skipped = PARSE_LIMIT_NONE;
+	inputFileHandle handle;
 	struct GetLanguageRequest req = {
-		.type = mio? GLR_REUSE: GLR_OPEN,
 		.fileName = fileName,
-		.mio = mio,
+		.handle = &handle,
 	};
-	memset (&req.mtime, 0, sizeof (req.mtime));
 
+	if (Profiling && !Option.printLanguage)
+		beginProfileFile ();
+
+	initInputFileHandle (&handle, fileName, mio);
+	if (!Option.printLanguage && isFileTooLarge (&handle))
+	{
+		reportSkippedFile (fileName, PARSE_LIMIT_FILE_SIZE);
+		finiInputFileHandle (&handle);
+		if (Profiling)
+			endProfileFile (fileName, LANG_IGNORE, PARSE_LIMIT_FILE_SIZE);
+		return false;
+	}
+
+	profileEnter (PROFILE_GUESS);
 	language = getFileLanguageForRequest (&req);
+	profileLeave ();
 	Assert (language != LANG_AUTO);
 
 	if (Option.printLanguage)
 	{
 		printGuessedParser (fileName, language);
+		finiInputFileHandle (&handle);
 		return tagFileResized;
 	}
 
@@ -4516,7 +4850,14 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 		/* TODO: checkUTF8BOM can be used to update the encodings. */
 		openConverter (getLanguageEncoding (language), Option.outputEncoding);
 #endif
-		tagFileResized = parseMio (fileName, language, req.mio, req.mtime, true, clientData);
+		if (!replayCachedTags (fileName, language, &handle, &tagFileResized))
+		{
+			bool recording = beginCacheRecording ();
+			tagFileResized = parseMio (fileName, language, &handle, true, clientData);
+			skipped = getExceededParseLimit ();
+			if (recording)
+				endCacheRecording (fileName, language, &handle, tagFileResized);
+		}
 		if (Option.filter && ! Option.interactive)
 			closeTagFile (tagFileResized);
 		addTotals (1, 0L, 0L);
@@ -4526,8 +4867,10 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 #endif
 	}
 
-	if (req.type == GLR_OPEN && req.mio)
-		mio_unref (req.mio);
+	finiInputFileHandle (&handle);
+
+	if (Profiling)
+		endProfileFile (fileName, language, skipped);
 
 	return tagFileResized;
 }
@@ -4536,13 +4879,16 @@ extern bool parseRawBuffer(const char *fileName, unsigned char *buffer,
 			 size_t bufferSize, const langType language, void *clientData)
 {
 	MIO *mio = NULL;
+	inputFileHandle handle;
 	bool r;
 
 	if (buffer)
 		mio = mio_new_memory (buffer, bufferSize, NULL, NULL);
+	initInputFileHandle (&handle, fileName, mio);
 
-	r = parseMio (fileName, language, mio, (time_t)0, false, clientData);
+	r = parseMio (fileName, language, &handle, false, clientData);
 
+	finiInputFileHandle (&handle);
 	if (buffer)
 		mio_unref (mio);
 
@@ -5362,6 +5708,12 @@ extern void printKinddefFlags (bool withListHeader, bool machinable, FILE *fp)
 	colprintTableDelete(table);
 }
 
+extern void printLanguageRegexStatistics (langType language)
+{
+	parserObject* const parser = LanguageTable + language;
+	printRegexStatistics (parser->lregexControlBlock);
+}
+
 extern void printLanguageMultitableStatistics (langType language)
 {
 	parserObject* const parser = LanguageTable + language;
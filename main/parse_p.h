@@ -37,6 +37,15 @@ typedef enum {
 	LMAP_TABLE_OUTPUT = 1 << 2,
 } langmapType;
 
+/* The limit exceeded while parsing a file (--max-file-size,
+ * --max-parse-time, and --max-tags-per-file) */
+typedef enum eParseLimit {
+	PARSE_LIMIT_NONE,
+	PARSE_LIMIT_FILE_SIZE,
+	PARSE_LIMIT_PARSE_TIME,
+	PARSE_LIMIT_TAGS,
+} parseLimit;
+
 enum parserCategory
 {
 	PARSER_CATEGORY_NONE,
@@ -45,6 +54,13 @@ enum parserCategory
 	PARSER_CATEGORY_PACKCC,
 };
 
+/*
+*   DATA DEFINITIONS
+*/
+
+/* True while parsing a file with --max-parse-time or --max-tags-per-file. */
+extern bool ParseBudgetEnabled;
+
 /*
 *   FUNCTION PROTOTYPES
 */
@@ -132,6 +148,7 @@ extern void printLangdefFlags (bool withListHeader, bool machinable, FILE *fp);
 extern void printKinddefFlags (bool withListHeader, bool machinable, FILE *fp);
 extern bool doesParserRequireMemoryStream (const langType language);
 extern bool parseFile (const char *const fileName);
+extern void makeParserPseudoTags (const langType language);
 extern bool parseFileWithMio (const char *const fileName, MIO *mio, void *clientData);
 extern bool parseRawBuffer(const char *fileName, unsigned char *buffer,
 			    size_t bufferSize, const langType language, void *clientData);
@@ -142,6 +159,17 @@ extern bool runParserInNarrowedInputStream (const langType language,
 					       unsigned long sourceLineOffset,
 					       int promise);
 
+/* Used in read.c and entry.c while ParseBudgetEnabled is true. They
+ * return false if a limit is exceeded; then the parser sees the end of
+ * the input, no more tags are made, and the tags of the file are
+ * discarded after parsing. */
+extern bool chargeParseBudgetForLine (void);
+extern bool chargeParseBudgetForTag (void);
+
+/* The limit exceeded while parsing the last file, or PARSE_LIMIT_NONE. */
+extern parseLimit getExceededParseLimit (void);
+extern const char *getParseLimitName (parseLimit limit);
+
 #ifdef HAVE_ICONV
 extern void freeEncodingResources (void);
 #endif
@@ -188,6 +216,7 @@ extern bool makeRoleDescriptionsPseudoTags (const langType language,
 extern bool makeParserVersionPseudoTags (const langType language,
 										 const ptagDesc *pdesc);
 
+extern void printLanguageRegexStatistics (langType language);
 extern void printLanguageMultitableStatistics (langType language);
 extern void printParserStatisticsIfUsed (langType lang);
 
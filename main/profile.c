@@ -0,0 +1,387 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for reporting where the time is spent
+*   for each input file (--profile=FILE).
+*
+*   The time of a file is split into phases. The phases are nested:
+*   parsing runs regex patterns, and guest parsers, and writes tags.
+*   A stack of the phases is kept, and the time between two transitions
+*   is charged to the phase at the top of the stack. So the time of a
+*   phase doesn't include the time of the phases nested in it, and the
+*   sum of the phases is the wall clock time of the file.
+*
+*   Regex matching and writing change the phase for each line and each
+*   tag, so the transitions must be cheap. Where the time stamp counter
+*   of the CPU is available, only the counter is read at a transition.
+*   The wall clock and the CPU time of the thread, which may need system
+*   calls, are read at the beginning and the end of a file, and the
+*   counts of each phase are scaled to the wall clock time of the file.
+*
+*   A record is written as a JSON line for each input file. When a file
+*   is parsed in a worker process of --jobs, the worker passes the record
+*   to the parent, and the parent writes it in the order of the input.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "debug.h"
+#include "entry_p.h"
+#include "jobs_p.h"
+#include "parse_p.h"
+#include "profile_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "stats_p.h"
+
+/*
+*   MACROS
+*/
+#define PROFILE_STACK_DEPTH 32
+#define PROFILE_TOP_FILES   20
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sProfileFile {
+	char *fileName;
+	profileRecord record;
+} profileFile;
+
+typedef struct sProfileParser {
+	unsigned long files;
+	profileRecord record;		/* sum of the records of the files */
+} profileParser;
+
+/*
+*   DATA DEFINITIONS
+*/
+bool Profiling;
+
+static const char *const PhaseNames [PROFILE_PHASE_COUNT] = {
+	[PROFILE_OTHER]   = "other",
+	[PROFILE_GUESS]   = "guess",
+	[PROFILE_PARSE]   = "parse",
+	[PROFILE_REGEX]   = "regex",
+	[PROFILE_PROMISE] = "promise",
+	[PROFILE_WRITE]   = "write",
+};
+
+static FILE *ProfileFP;
+
+static struct sProfileState {
+	bool active;
+	profilePhase stack [PROFILE_STACK_DEPTH];
+	unsigned int depth;
+	unsigned int overflow;		/* transitions not pushed to the stack */
+	uint64_t ticks [PROFILE_PHASE_COUNT];
+	uint64_t lastTick;
+	uint64_t startTick;
+	double start;
+	double cpuStart;
+	long lines;
+	long bytes;
+	unsigned long tags;
+	profileRecord record;
+} Current;
+
+static profileFile Slowest [PROFILE_TOP_FILES];
+static unsigned int SlowestCount;
+
+static profileParser *Parsers;
+static unsigned int ParserCount;
+static profileParser AllFiles;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static uint64_t readTicks (void)
+{
+#if (defined (__GNUC__) || defined (__clang__)) && (defined (__x86_64__) || defined (__i386__))
+	return __builtin_ia32_rdtsc ();
+#else
+	return (uint64_t) (getMonotonicTime () * 1e9);
+#endif
+}
+
+static double cpuClock (void)
+{
+	/* The CPU time of the process includes the time of the output
+	 * thread writing the tag file. */
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_THREAD_CPUTIME_ID)
+	struct timespec ts;
+
+	clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+#else
+	return (double) clock () / CLOCKS_PER_SEC;
+#endif
+}
+
+extern void openProfile (const char *const fileName)
+{
+	if (ProfileFP && fclose (ProfileFP) != 0)
+		error (WARNING | PERROR, "cannot close profile file");
+
+	ProfileFP = fopen (fileName, "w");
+	if (ProfileFP == NULL)
+		error (FATAL | PERROR, "cannot open profile file \"%s\"", fileName);
+	Profiling = true;
+}
+
+static void chargeTime (void)
+{
+	const uint64_t now = readTicks ();
+
+	Current.ticks [Current.stack [Current.depth - 1]] += now - Current.lastTick;
+	Current.lastTick = now;
+}
+
+extern void beginProfileFile (void)
+{
+	long files;
+
+	memset (&Current.record, 0, sizeof (Current.record));
+	memset (Current.ticks, 0, sizeof (Current.ticks));
+	Current.active = true;
+	Current.stack [0] = PROFILE_OTHER;
+	Current.depth = 1;
+	Current.overflow = 0;
+	Current.tags = numTagsAdded ();
+	getTotals (&files, &Current.lines, &Current.bytes);
+	Current.cpuStart = cpuClock ();
+	Current.start = getMonotonicTime ();
+	Current.startTick = Current.lastTick = readTicks ();
+}
+
+extern void enterProfilePhase (profilePhase phase)
+{
+	if (!Current.active)
+		return;
+
+	chargeTime ();
+	if (Current.depth < PROFILE_STACK_DEPTH)
+		Current.stack [Current.depth++] = phase;
+	else
+		Current.overflow++;
+}
+
+extern void leaveProfilePhase (void)
+{
+	if (!Current.active)
+		return;
+
+	chargeTime ();
+	if (Current.overflow > 0)
+		Current.overflow--;
+	else if (Current.depth > 1)
+		Current.depth--;
+}
+
+extern void endProfileFile (const char *const fileName, const langType language,
+							parseLimit skipped)
+{
+	long files, lines, bytes;
+	uint64_t ticks;
+
+	if (!Current.active)
+		return;
+
+	chargeTime ();
+	Current.active = false;
+
+	Current.record.language = language;
+	Current.record.skipped = skipped;
+	Current.record.wall = getMonotonicTime () - Current.start;
+	ticks = Current.lastTick - Current.startTick;
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+		Current.record.phase [i] = ticks
+			? Current.record.wall * ((double) Current.ticks [i] / ticks)
+			: 0.0;
+
+	getTotals (&files, &lines, &bytes);
+	Current.record.cpu = cpuClock () - Current.cpuStart;
+	Current.record.lines = (unsigned long) (lines - Current.lines);
+	Current.record.bytes = (unsigned long) (bytes - Current.bytes);
+
+	/* The count is rewound if the parser fails and rescans the file. */
+	if (numTagsAdded () > Current.tags)
+		Current.record.tags = numTagsAdded () - Current.tags;
+
+	if (!isJobWorker ())
+		writeProfileRecord (fileName, &Current.record);
+}
+
+extern const profileRecord *getLastProfileRecord (void)
+{
+	return &Current.record;
+}
+
+static void writeJSONString (FILE *fp, const char *s)
+{
+	putc ('"', fp);
+	for (; *s; s++)
+	{
+		const unsigned char c = (unsigned char) *s;
+
+		if (c == '"' || c == '\\')
+			fprintf (fp, "\\%c", c);
+		else if (c < 0x20)
+			fprintf (fp, "\\u%04x", c);
+		else
+			putc (c, fp);
+	}
+	putc ('"', fp);
+}
+
+static void addRecord (profileRecord *const sum, const profileRecord *const record)
+{
+	sum->wall += record->wall;
+	sum->cpu += record->cpu;
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+		sum->phase [i] += record->phase [i];
+	sum->tags += record->tags;
+	sum->lines += record->lines;
+	sum->bytes += record->bytes;
+}
+
+static void rememberSlowest (const char *const fileName, const profileRecord *const record)
+{
+	unsigned int i;
+
+	if (SlowestCount == PROFILE_TOP_FILES)
+	{
+		if (record->wall <= Slowest [SlowestCount - 1].record.wall)
+			return;
+		eFree (Slowest [--SlowestCount].fileName);
+	}
+
+	/* Keep Slowest sorted in the descending order of the wall clock time. */
+	for (i = SlowestCount; i > 0 && Slowest [i - 1].record.wall < record->wall; i--)
+		Slowest [i] = Slowest [i - 1];
+	Slowest [i].fileName = eStrdup (fileName);
+	Slowest [i].record = *record;
+	SlowestCount++;
+}
+
+extern void writeProfileRecord (const char *const fileName,
+								const profileRecord *const record)
+{
+	const langType language = record->language;
+
+	Assert (ProfileFP);
+
+	fputs ("{\"file\":", ProfileFP);
+	writeJSONString (ProfileFP, fileName);
+	fputs (",\"parser\":", ProfileFP);
+	if (language == LANG_IGNORE)
+		fputs ("null", ProfileFP);
+	else
+		writeJSONString (ProfileFP, getLanguageName (language));
+	fprintf (ProfileFP, ",\"wall\":%.6f,\"cpu\":%.6f", record->wall, record->cpu);
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+		fprintf (ProfileFP, ",\"%s\":%.6f", PhaseNames [i], record->phase [i]);
+	fprintf (ProfileFP, ",\"tags\":%lu,\"lines\":%lu,\"bytes\":%lu",
+			 record->tags, record->lines, record->bytes);
+	fputs (",\"skipped\":", ProfileFP);
+	if (record->skipped == PARSE_LIMIT_NONE)
+		fputs ("null", ProfileFP);
+	else
+		writeJSONString (ProfileFP, getParseLimitName (record->skipped));
+	fputs ("}\n", ProfileFP);
+
+	rememberSlowest (fileName, record);
+
+	AllFiles.files++;
+	addRecord (&AllFiles.record, record);
+	if (language != LANG_IGNORE)
+	{
+		if (Parsers == NULL)
+		{
+			ParserCount = countParsers ();
+			Parsers = xCalloc (ParserCount, profileParser);
+		}
+		Assert ((unsigned int) language < ParserCount);
+		Parsers [language].files++;
+		addRecord (&Parsers [language].record, record);
+	}
+}
+
+static void printPhases (const profileRecord *const record)
+{
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+		fprintf (stderr, " %9.6f", record->phase [i]);
+}
+
+static void printProfileSummary (void)
+{
+	fprintf (stderr, "profile: %lu file%s, %.6f seconds (cpu %.6f seconds)\n",
+			 AllFiles.files, (AllFiles.files == 1)? "": "s",
+			 AllFiles.record.wall, AllFiles.record.cpu);
+	if (AllFiles.files == 0)
+		return;
+
+	fprintf (stderr, "\nslowest files:\n");
+	fprintf (stderr, "%10s %10s %8s  %-16s %s\n", "wall", "cpu", "tags", "parser", "file");
+	for (unsigned int i = 0; i < SlowestCount; i++)
+	{
+		const profileRecord *const record = &Slowest [i].record;
+		fprintf (stderr, "%10.6f %10.6f %8lu  %-16s %s\n",
+				 record->wall, record->cpu, record->tags,
+				 (record->language == LANG_IGNORE)? "-": getLanguageName (record->language),
+				 Slowest [i].fileName);
+	}
+
+	fprintf (stderr, "\nparsers:\n");
+	fprintf (stderr, "%-16s %6s %10s", "parser", "files", "wall");
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+		fprintf (stderr, " %9s", PhaseNames [i]);
+	fputc ('\n', stderr);
+	for (unsigned int i = 0; i < ParserCount; i++)
+	{
+		if (Parsers [i].files == 0)
+			continue;
+		fprintf (stderr, "%-16s %6lu %10.6f", getLanguageName (i),
+				 Parsers [i].files, Parsers [i].record.wall);
+		printPhases (&Parsers [i].record);
+		fputc ('\n', stderr);
+	}
+	fprintf (stderr, "%-16s %6lu %10.6f", "(all)",
+			 AllFiles.files, AllFiles.record.wall);
+	printPhases (&AllFiles.record);
+	fputc ('\n', stderr);
+}
+
+extern void closeProfile (void)
+{
+	if (ProfileFP == NULL)
+		return;
+
+	if (fclose (ProfileFP) != 0)
+		error (WARNING | PERROR, "cannot close profile file");
+	ProfileFP = NULL;
+	Profiling = false;
+
+	printProfileSummary ();
+
+	for (unsigned int i = 0; i < SlowestCount; i++)
+		eFree (Slowest [i].fileName);
+	SlowestCount = 0;
+	if (Parsers)
+		eFree (Parsers);
+	Parsers = NULL;
+	ParserCount = 0;
+	memset (&AllFiles, 0, sizeof (AllFiles));
+}
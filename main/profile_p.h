@@ -0,0 +1,82 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Private interface to profile.c, the per-file profiling report
+*   (--profile=FILE).
+*/
+#ifndef CTAGS_MAIN_PROFILE_PRIVATE_H
+#define CTAGS_MAIN_PROFILE_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+#include "parse_p.h"
+#include "types.h"
+
+/*
+*   MACROS
+*/
+
+/* Charge the time spent until the matching profileLeave () to PHASE.
+ * The time spent in a nested phase is charged only to the nested one. */
+#define profileEnter(phase) do { if (Profiling) enterProfilePhase (phase); } while (0)
+#define profileLeave()      do { if (Profiling) leaveProfilePhase (); } while (0)
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef enum eProfilePhase {
+	PROFILE_OTHER,				/* opening the file, replaying the cache, ... */
+	PROFILE_GUESS,				/* choosing a parser */
+	PROFILE_PARSE,				/* running the parser */
+	PROFILE_REGEX,				/* matching regex patterns */
+	PROFILE_PROMISE,			/* running guest parsers */
+	PROFILE_WRITE,				/* writing tags */
+	PROFILE_PHASE_COUNT
+} profilePhase;
+
+typedef struct sProfileRecord {
+	langType language;
+	double wall;				/* in seconds */
+	double cpu;
+	double phase [PROFILE_PHASE_COUNT];	/* wall clock time of each phase */
+	unsigned long tags;
+	unsigned long lines;
+	unsigned long bytes;
+	parseLimit skipped;			/* the limit the file exceeded */
+} profileRecord;
+
+/*
+*   DATA DEFINITIONS
+*/
+extern bool Profiling;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Open FILENAME for writing a record for each input file as a JSON
+ * line. closeProfile () prints the slowest files and the totals of
+ * each parser to stderr. */
+extern void openProfile (const char *const fileName);
+extern void closeProfile (void);
+
+/* Used in parse.c around parsing an input file. */
+extern void beginProfileFile (void);
+extern void endProfileFile (const char *const fileName, const langType language,
+							parseLimit skipped);
+
+extern void enterProfilePhase (profilePhase phase);
+extern void leaveProfilePhase (void);
+
+/* Used in jobs.c. A worker process passes the record of the last file
+ * to the parent, and the parent writes it with writeProfileRecord (). */
+extern const profileRecord *getLastProfileRecord (void);
+extern void writeProfileRecord (const char *const fileName,
+								const profileRecord *const record);
+
+#endif	/* CTAGS_MAIN_PROFILE_PRIVATE_H */
@@ -16,6 +16,20 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <limits.h>
+
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>  /* to declare O_RDONLY */
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_IO_H
+# include <io.h>  /* to declare open() */
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
 
 #define FILE_WRITE
 #include "read.h"
@@ -26,6 +40,7 @@
 #include "routines_p.h"
 #include "options_p.h"
 #include "parse_p.h"
+#include "profile_p.h"
 #include "promise.h"
 #include "promise_p.h"
 #include "stats_p.h"
@@ -88,10 +103,9 @@ typedef struct sNestedInputStreamInfo {
 typedef struct sInputFile {
 	vString    *path;          /* path of input file (if any) */
 	vString    *line;          /* last line read from file */
-	const unsigned char* currentLine;  /* current line being worked on */
+	struct sInputCursor cursor;	/* current line being worked on */
 	MIO        *mio;           /* MIO stream used for reading the file */
 	compoundPos    filePosition;  /* file position of current line */
-	unsigned int ungetchIdx;
 	int         ungetchBuf[8]; /* characters that were ungotten */
 
 	bool bomFound;
@@ -115,6 +129,7 @@ typedef struct sInputFile {
 	vString *allLines;
 	int thinDepth;
 	time_t mtime;
+	long size;               /* size of the file opened, or -1 if unknown */
 } inputFile;
 
 static inputLangInfo inputLang;
@@ -136,6 +151,7 @@ static void     langStackClear(langStack *langStack);
 */
 static inputFile File;  /* static read through functions */
 static inputFile BackupFile;	/* File is copied here when a nested parser is pushed */
+struct sInputCursor *const InputCursor = &File.cursor;
 static compoundPos StartOfLine;  /* holds deferred position of start of line */
 
 /*
@@ -152,8 +168,8 @@ extern int getInputLineOffset (void)
 	unsigned char *base = (unsigned char *) vStringValue (File.line);
 	int ret;
 
-	if (File.currentLine)
-		ret = File.currentLine - base - File.ungetchIdx;
+	if (File.cursor.currentLine)
+		ret = File.cursor.currentLine - base - File.cursor.ungetchIdx;
 	else if (File.input.lineNumber)
 	{
 		/* When EOF is saw, currentLine is set to NULL.
@@ -422,6 +438,20 @@ static void setOwnerDirectoryOfInputFile (const char *const fileName)
 	}
 }
 
+extern vString *makeInputFileTagPath (const char *const fileName)
+{
+	if (Option.tagRelative == TREL_ALWAYS)
+		return vStringNewOwn (relativeFilename (fileName,
+							getTagFileDirectory ()));
+	else if ( Option.tagRelative == TREL_NEVER )
+		return vStringNewOwn (absoluteFilename (fileName));
+	else if ( Option.tagRelative == TREL_NO || isAbsolutePath (fileName) )
+		return vStringNewInit (fileName);
+	else
+		return vStringNewOwn (relativeFilename (fileName,
+							getTagFileDirectory ()));
+}
+
 static void setInputFileParametersCommon (inputFileInfo *finfo, vString *const fileName,
 					  const langType language,
 					  stringList *holder)
@@ -438,21 +468,7 @@ static void setInputFileParametersCommon (inputFileInfo *finfo, vString *const f
 			vStringDelete (finfo->tagPath);
 	}
 
-	if (0)
-		;
-	else if (  Option.tagRelative == TREL_ALWAYS )
-		finfo->tagPath =
-			vStringNewOwn (relativeFilename (vStringValue (fileName),
-							 getTagFileDirectory ()));
-	else if ( Option.tagRelative == TREL_NEVER )
-		finfo->tagPath =
-			vStringNewOwn (absoluteFilename (vStringValue (fileName)));
-	else if ( Option.tagRelative == TREL_NO || isAbsolutePath (vStringValue (fileName)) )
-		finfo->tagPath = vStringNewCopy (fileName);
-	else
-		finfo->tagPath =
-			vStringNewOwn (relativeFilename (vStringValue (fileName),
-							 getTagFileDirectory ()));
+	finfo->tagPath = makeInputFileTagPath (vStringValue (fileName));
 
 	finfo->isHeader = isIncludeFile (vStringValue (fileName));
 }
@@ -636,45 +652,137 @@ static bool parseLineDirective (char *s)
 #define MAX_IN_MEMORY_FILE_SIZE (1024*1024)
 #endif
 
-static MIO *getMioFull (const char *const fileName, const char *const openMode,
-		    bool memStreamRequired, time_t *mtime)
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+extern void initInputFileHandle (inputFileHandle *handle, const char *const fileName,
+								 MIO *mio)
+{
+	memset (handle, 0, sizeof (*handle));
+	handle->fileName = fileName;
+	if (mio)
+	{
+		handle->mio = mio_ref (mio);
+		handle->reused = true;
+	}
+}
+
+extern void finiInputFileHandle (inputFileHandle *handle)
 {
+	if (handle->mio)
+	{
+		mio_unref (handle->mio);
+		handle->mio = NULL;
+	}
+}
+
+extern const fileStatus *getInputFileHandleStatus (inputFileHandle *handle)
+{
+	struct stat st;
+
+	if (handle->statusValid)
+		return &handle->status;
+
+	if (stat (handle->fileName, &st) == 0)
+	{
+		handle->status.exists = true;
+		fillFileStatus (&handle->status, &st);
+	}
+	else
+		handle->status.exists = false;
+	handle->statusValid = true;
+	return &handle->status;
+}
+
+extern time_t getInputFileHandleMtime (inputFileHandle *handle)
+{
+	/* The contents of a stream given by the caller may not be the ones
+	 * of the file. */
+	if (handle->reused)
+		return (time_t)0;
+	return getInputFileHandleStatus (handle)->mtime;
+}
+
+static MIO *openMioForHandle (inputFileHandle *handle, bool memStreamRequired)
+{
+	struct stat st;
 	FILE *src;
-	fileStatus *st;
 	unsigned long size;
 	unsigned char *data;
+	int fd;
 
-	st = eStat (fileName);
-	size = st->size;
-	if (mtime)
-		*mtime = st->mtime;
-	eStatFree (st);
-	if ((!memStreamRequired)
-	    && (size > MAX_IN_MEMORY_FILE_SIZE || size == 0))
-		return mio_new_file (fileName, openMode);
+	fd = open (handle->fileName, O_RDONLY | O_BINARY);
+	if (fd < 0)
+		return NULL;
+
+	/* The status of the file opened is the one of the contents parsed,
+	 * even if the file is replaced after it is stat'ed. */
+	if (fstat (fd, &st) != 0)
+	{
+		close (fd);
+		return NULL;
+	}
+	handle->status.exists = true;
+	fillFileStatus (&handle->status, &st);
+	handle->statusValid = true;
+	size = handle->status.size;
+
+	/* Map a regular file of any size instead of copying it to the heap.
+	 * In DEBUG build, MAX_IN_MEMORY_FILE_SIZE is 0 for testing the code
+	 * working on file streams; a file is mapped only if a memory stream
+	 * is required. */
+	if (handle->status.isNormalFile && size > 0
+		&& (memStreamRequired || MAX_IN_MEMORY_FILE_SIZE > 0))
+	{
+		MIO *mio = mio_new_mmap_fd (fd, size);
+		if (mio)
+		{
+			close (fd);
+			return mio;
+		}
+	}
 
-	src = fopen (fileName, openMode);
+	src = fdopen (fd, "rb");
 	if (!src)
+	{
+		close (fd);
 		return NULL;
+	}
+
+	if ((!memStreamRequired)
+	    && (size > MAX_IN_MEMORY_FILE_SIZE || size == 0))
+		return mio_new_fp (src, fclose);
 
 	data = eMalloc (size);
 	if (fread (data, 1, size, src) != size)
 	{
 		eFree (data);
-		fclose (src);
 		if (memStreamRequired)
+		{
+			fclose (src);
 			return NULL;
-		else
-			return mio_new_file (fileName, openMode);
+		}
+		rewind (src);
+		return mio_new_fp (src, fclose);
 	}
 	fclose (src);
 	return mio_new_memory (data, size, eRealloc, eFreeNoNullCheck);
 }
 
-extern MIO *getMio (const char *const fileName, const char *const openMode,
-		    bool memStreamRequired)
+extern MIO *openInputFileHandle (inputFileHandle *handle, bool memStreamRequired)
 {
-	return getMioFull (fileName, openMode, memStreamRequired, NULL);
+	if (handle->mio == NULL)
+		handle->mio = openMioForHandle (handle, memStreamRequired);
+	else if (memStreamRequired && !mio_memory_get_data (handle->mio, NULL))
+	{
+		/* Copy the stream opened for a parser working on a file stream
+		 * instead of opening the file again. */
+		MIO *mio = mio_new_mio (handle->mio, 0, -1);
+		mio_unref (handle->mio);
+		handle->mio = mio;
+	}
+	return handle->mio;
 }
 
 /* Return true if utf8 BOM is found */
@@ -711,11 +819,11 @@ static void rewindInputFile (inputFile *f)
  *  fails, it will display an error message and leave the File.mio set to NULL.
  */
 extern bool openInputFile (const char *const fileName, const langType language,
-			      MIO *mio, time_t mtime)
+			      inputFileHandle *handle)
 {
-	const char *const openMode = "rb";
 	bool opened = false;
 	bool memStreamRequired;
+	bool reused;
 
 	/*	If another file was already open, then close it.
 	 */
@@ -739,16 +847,8 @@ extern bool openInputFile (const char *const fileName, const langType language,
 
 	memStreamRequired = doesParserRequireMemoryStream (language);
 
-	if (mio)
-	{
-		size_t tmp;
-		if (memStreamRequired && (!mio_memory_get_data (mio, &tmp)))
-			mio = NULL;
-		else
-			mio_rewind (mio);
-	}
-
-	File.mio = mio? mio_ref (mio): getMioFull (fileName, openMode, memStreamRequired, &File.mtime);
+	reused = (handle->mio != NULL);
+	File.mio = openInputFileHandle (handle, memStreamRequired);
 
 	if (File.mio == NULL)
 		error (WARNING | PERROR, "cannot open \"%s\"", fileName);
@@ -756,8 +856,10 @@ extern bool openInputFile (const char *const fileName, const langType language,
 	{
 		opened = true;
 
-		if (File.mio == mio)
-			File.mtime = mtime;
+		mio_ref (File.mio);
+		mio_rewind (File.mio);
+		File.mtime = getInputFileHandleMtime (handle);
+		File.size = handle->statusValid? (long) handle->status.size: -1;
 
 		File.bomFound = checkUTF8BOM (File.mio, true);
 
@@ -765,10 +867,10 @@ extern bool openInputFile (const char *const fileName, const langType language,
 		mio_getpos (File.mio, &StartOfLine.pos);
 		mio_getpos (File.mio, &File.filePosition.pos);
 		File.filePosition.offset = StartOfLine.offset = mio_tell (File.mio);
-		File.currentLine  = NULL;
+		File.cursor.currentLine  = NULL;
 
 		File.line = vStringNewOrClear (File.line);
-		File.ungetchIdx = 0;
+		File.cursor.ungetchIdx = 0;
 
 		setInputFileParameters  (vStringNewInit (fileName), language);
 		File.input.lineNumberOrigin = 0L;
@@ -784,7 +886,7 @@ extern bool openInputFile (const char *const fileName, const langType language,
 				 fileName,
 				 getLanguageName (language),
 				 File.input.isHeader ? "include " : "",
-				 mio? "reused": "new",
+				 reused? "reused": "new",
 				 memStreamRequired? ",required": "");
 	}
 	return opened;
@@ -803,11 +905,11 @@ extern void resetInputFile (const langType language, bool resetLineFposMap_)
 	mio_getpos (File.mio, &StartOfLine.pos);
 	mio_getpos (File.mio, &File.filePosition.pos);
 	File.filePosition.offset = StartOfLine.offset = mio_tell (File.mio);
-	File.currentLine  = NULL;
+	File.cursor.currentLine  = NULL;
 
 	Assert (File.line);
 	vStringClear (File.line);
-	File.ungetchIdx = 0;
+	File.cursor.ungetchIdx = 0;
 
 	if (hasLanguageMultilineRegexPatterns (language)
 		|| hasLanguagePostRunRegexPatterns (language))
@@ -831,10 +933,12 @@ extern void closeInputFile (void)
 		/*  The line count of the file is 1 too big, since it is one-based
 		 *  and is incremented upon each newline.
 		 */
-		if (Option.printTotals)
+		if (Option.printTotals || Profiling)
 		{
-			fileStatus *status = eStat (vStringValue (File.input.name));
-			addTotals (0, File.input.lineNumber - 1L, status->size);
+			long size = File.size;
+			if (size < 0)
+				size = eStat (vStringValue (File.input.name))->size;
+			addTotals (0, File.input.lineNumber - 1L, size);
 		}
 		mio_unref (File.mio);
 		File.mio = NULL;
@@ -867,10 +971,10 @@ extern void ungetcToInputFile (int c)
 {
 	const size_t len = ARRAY_SIZE (File.ungetchBuf);
 
-	Assert (File.ungetchIdx < len);
+	Assert (File.cursor.ungetchIdx < len);
 	/* we cannot rely on the assertion that might be disabled in non-debug mode */
-	if (File.ungetchIdx < len)
-		File.ungetchBuf[File.ungetchIdx++] = c;
+	if (File.cursor.ungetchIdx < len)
+		File.ungetchBuf[File.cursor.ungetchIdx++] = c;
 }
 
 typedef enum eEolType {
@@ -934,6 +1038,11 @@ static vString *iFileGetLine (bool chop_newline)
 	langType lang = getInputLanguage();
 
 	Assert (File.line);
+
+	/* The parser sees the end of the input if the file exceeds a limit. */
+	if (ParseBudgetEnabled && !chargeParseBudgetForLine ())
+		return NULL;
+
 	eol = readLine (File.line, File.mio);
 
 	if (vStringLength (File.line) > 0)
@@ -1006,8 +1115,10 @@ static vString *iFileGetLine (bool chop_newline)
 }
 
 /*  Do not mix use of readLineFromInputFile () and getcFromInputFile () for the same file.
+ *  getcFromInputFile () calls this function only if the character cannot be
+ *  taken from the current line.
  */
-extern int getcFromInputFile (void)
+extern int getcFromInputFileSlow (void)
 {
 	int c;
 
@@ -1015,25 +1126,25 @@ extern int getcFromInputFile (void)
 	 *  other processing on it, though, because we already did that the
 	 *  first time it was read through getcFromInputFile ().
 	 */
-	if (File.ungetchIdx > 0)
+	if (File.cursor.ungetchIdx > 0)
 	{
-		c = File.ungetchBuf[--File.ungetchIdx];
+		c = File.ungetchBuf[--File.cursor.ungetchIdx];
 		return c;  /* return here to avoid re-calling debugPutc () */
 	}
 	do
 	{
-		if (File.currentLine != NULL)
+		if (File.cursor.currentLine != NULL)
 		{
-			c = *File.currentLine++;
+			c = *File.cursor.currentLine++;
 			if (c == '\0')
-				File.currentLine = NULL;
+				File.cursor.currentLine = NULL;
 		}
 		else
 		{
 			vString* const line = iFileGetLine (false);
 			if (line != NULL)
-				File.currentLine = (unsigned char*) vStringValue (line);
-			if (File.currentLine == NULL)
+				File.cursor.currentLine = (unsigned char*) vStringValue (line);
+			if (File.cursor.currentLine == NULL)
 				c = EOF;
 			else
 				c = '\0';
@@ -1048,10 +1159,10 @@ extern int getcFromInputFile (void)
 extern int getNthPrevCFromInputFile (unsigned int nth, int def)
 {
 	const unsigned char *base = (unsigned char *) vStringValue (File.line);
-	const unsigned int offset = File.ungetchIdx + 1 + nth;
+	const unsigned int offset = File.cursor.ungetchIdx + 1 + nth;
 
-	if (File.currentLine != NULL && File.currentLine >= base + offset)
-		return (int) *(File.currentLine - offset);
+	if (File.cursor.currentLine != NULL && File.cursor.currentLine >= base + offset)
+		return (int) *(File.cursor.currentLine - offset);
 	else
 		return def;
 }
@@ -1059,6 +1170,29 @@ extern int getNthPrevCFromInputFile (unsigned int nth, int def)
 extern int skipToCharacterInInputFile (int c)
 {
 	int d;
+
+#ifndef DEBUG
+	/* Search the current line for C at once. */
+	if (c > 0 && c <= UCHAR_MAX)
+	{
+		while (File.cursor.ungetchIdx == 0 && File.cursor.currentLine != NULL)
+		{
+			const char *p = strchr ((const char *) File.cursor.currentLine, c);
+			if (p)
+			{
+				File.cursor.currentLine = (const unsigned char *) p + 1;
+				return c;
+			}
+			/* Same as reading the NUL at the end of the line */
+			File.cursor.currentLine = NULL;
+
+			d = getcFromInputFileSlow ();
+			if (d == EOF || d == c)
+				return d;
+		}
+	}
+#endif
+
 	do
 	{
 		d = getcFromInputFile ();
@@ -1144,6 +1278,43 @@ extern char *readLineFromBypass (
 	return result;
 }
 
+/*  Returns the line referenced by "location" in the memory buffer of the
+ *  input stream without copying it. The length of the line, including the
+ *  line feed if any, is stored to "length". Unlike readLineFromBypass (),
+ *  CR-LF is not turned into LF and the line is not terminated with NUL.
+ *  NULL is returned if the input stream is not in memory, if the input is
+ *  converted with iconv, or if "location" is at the end of the stream.
+ */
+extern const char *sliceLineFromBypass (MIOPos location, size_t *const length)
+{
+	MIOPos orignalPosition;
+	unsigned char *data;
+	size_t size;
+	long offset;
+
+	data = mio_memory_get_data (File.mio, &size);
+	if (data == NULL)
+		return NULL;
+#ifdef HAVE_ICONV
+	if (isConverting ())
+		return NULL;
+#endif
+
+	/* Both are cheap for a memory stream. */
+	mio_getpos (File.mio, &orignalPosition);
+	mio_setpos (File.mio, &location);
+	offset = mio_tell (File.mio);
+	mio_setpos (File.mio, &orignalPosition);
+
+	if (offset < 0 || (size_t) offset >= size)
+		return NULL;
+
+	const char *line = (const char *) data + offset;
+	const char *nl = memchr (line, '\n', size - offset);
+	*length = nl? (size_t) (nl - line) + 1: size - offset;
+	return line;
+}
+
 extern void   pushNarrowedInputStream (
 				       bool useMemoryStreamInput,
 				       unsigned long startLine, long startCharOffset,
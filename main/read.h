@@ -48,7 +48,31 @@ extern bool isInputLanguageRoleEnabled (int kindIndex, int roleIndex);
 
 extern const unsigned char *getInputFileData (size_t *size);
 
-extern int getcFromInputFile (void);
+/* The state of getcFromInputFile (). Parsers must not refer the members. */
+struct sInputCursor {
+	const unsigned char *currentLine;
+	unsigned int ungetchIdx;
+};
+extern struct sInputCursor *const InputCursor;
+
+extern int getcFromInputFileSlow (void);
+
+/* Most characters are taken from the current line here without calling
+ * a function. At the end of the line, getcFromInputFileSlow () reads
+ * the next line. */
+CTAGS_INLINE int getcFromInputFile (void)
+{
+#ifndef DEBUG
+	const unsigned char *p = InputCursor->currentLine;
+
+	if (InputCursor->ungetchIdx == 0 && p != NULL && *p != '\0')
+	{
+		InputCursor->currentLine = p + 1;
+		return *p;
+	}
+#endif
+	return getcFromInputFileSlow ();
+}
 extern int getNthPrevCFromInputFile (unsigned int nth, int def);
 extern int skipToCharacterInInputFile (int c);
 extern int skipToCharacterInInputFile2 (int c0, int c1);
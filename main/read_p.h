@@ -15,6 +15,7 @@
 #include "general.h"  /* must always come first */
 
 #include "mio.h"
+#include "routines_p.h"
 #include "types.h"
 #include "vstring.h"
 
@@ -27,12 +28,26 @@ enum nestedInputBoundaryFlag {
 	INPUT_BOUNDARY_END   = 1UL << 1,
 };
 
+/* An input file from choosing its parser to parsing it. The file is
+ * opened once, and its status comes from the file opened; the stream
+ * and the status are shared by the parser guessing, the cache, and the
+ * parser. */
+typedef struct sInputFileHandle {
+	const char *fileName;
+	MIO *mio;                   /* NULL until opened */
+	bool reused;                /* mio is given by the caller */
+	bool statusValid;
+	fileStatus status;
+} inputFileHandle;
+
 /*
 *   FUNCTION PROTOTYPES
 */
 
 extern const char *getInputLanguageName (void);
 extern const char *getInputFileTagPath (void);
+/* The name of the file as written in the input field of tags */
+extern vString *makeInputFileTagPath (const char *const fileName);
 
 extern long getInputFileOffsetForLine (unsigned int line);
 
@@ -48,13 +63,22 @@ extern langType getLanguageForBaseParser (void);
 extern bool isParserMarkedNoEmission (void);
 extern void freeInputFileResources (void);
 
-/* Stream opened by getMio can be passed to openInputFile as the 3rd
-   argument. If the 3rd argument is NULL, openInputFile calls getMio
-   internally. The 3rd argument is introduced for reusing mio object
-   created in parser guessing stage. */
-extern bool openInputFile (const char *const fileName, const langType language, MIO *mio, time_t mtime);
-extern MIO *getMio (const char *const fileName, const char *const openMode,
-				    bool memStreamRequired);
+/* If MIO is not NULL, the handle reads MIO instead of opening FILENAME. */
+extern void initInputFileHandle (inputFileHandle *handle, const char *const fileName,
+								 MIO *mio);
+extern void finiInputFileHandle (inputFileHandle *handle);
+/* Open the file of HANDLE if it is not opened yet. The stream returned
+ * is owned by HANDLE. */
+extern MIO *openInputFileHandle (inputFileHandle *handle, bool memStreamRequired);
+/* The status of the file opened, or the one stat () returns if the file
+ * is not opened yet. */
+extern const fileStatus *getInputFileHandleStatus (inputFileHandle *handle);
+extern time_t getInputFileHandleMtime (inputFileHandle *handle);
+
+/* The stream of HANDLE, opened in parser guessing stage if any, is
+   reused. */
+extern bool openInputFile (const char *const fileName, const langType language,
+						   inputFileHandle *handle);
 extern void resetInputFile (const langType language, bool resetLineFposMap_);
 extern void closeInputFile (void);
 extern void *getInputFileUserData(void);
@@ -68,6 +92,7 @@ extern time_t getInputFileMtime (void);
 
 /* Bypass: reading from fp in inputFile WITHOUT updating fields in input fields */
 extern char *readLineFromBypass (vString *const vLine, MIOPos location, long *const pSeekValue);
+extern const char *sliceLineFromBypass (MIOPos location, size_t *const length);
 extern void   pushNarrowedInputStream (
 				       bool useMemoryStreamInput,
 				       unsigned long startLine, long startCharOffset,
@@ -25,6 +25,7 @@
 #endif
 
 #include <limits.h>  /* to declare MB_LEN_MAX */
+#include <time.h>
 #ifndef MB_LEN_MAX
 # define MB_LEN_MAX 6
 #endif
@@ -66,6 +67,14 @@
 # define TMPDIR "/tmp"
 #endif
 
+/* eMalloc () is also called from the threads reading directories
+ * (dirwalk.c). */
+#if defined (__GNUC__) || defined (__clang__)
+# define countAllocation() __atomic_fetch_add (&AllocationCount, 1, __ATOMIC_RELAXED)
+#else
+# define countAllocation() (AllocationCount++)
+#endif
+
 /*  File type tests.
  */
 #ifndef S_ISREG
@@ -154,6 +163,10 @@ char *CurrentDirectory;
 static const char *ExecutableProgram;
 static const char *ExecutableName;
 
+/* The number of calls of eMalloc, eCalloc, and eRealloc; for --totals=extra */
+static unsigned long AllocationCount;
+
+
 /*
 *   FUNCTION PROTOTYPES
 */
@@ -219,6 +232,8 @@ extern void *eMalloc (const size_t size)
 {
 	void *buffer = malloc (size);
 
+	countAllocation ();
+
 	if (buffer == NULL && size != 0)
 		error (FATAL, "out of memory");
 
@@ -229,6 +244,8 @@ extern void *eCalloc (const size_t count, const size_t size)
 {
 	void *buffer = calloc (count, size);
 
+	countAllocation ();
+
 	if (buffer == NULL && count != 0 && size != 0)
 		error (FATAL, "out of memory");
 
@@ -242,6 +259,7 @@ extern void *eRealloc (void *const ptr, const size_t size)
 		buffer = eMalloc (size);
 	else
 	{
+		countAllocation ();
 		buffer = realloc (ptr, size);
 		if (buffer == NULL && size != 0)
 			error (FATAL, "out of memory");
@@ -249,6 +267,23 @@ extern void *eRealloc (void *const ptr, const size_t size)
 	return buffer;
 }
 
+extern unsigned long getAllocationCount (void)
+{
+	return AllocationCount;
+}
+
+extern double getMonotonicTime (void)
+{
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+#else
+	return (double) clock () / CLOCKS_PER_SEC;
+#endif
+}
+
 extern void eFree (void *const ptr)
 {
 	Assert (ptr != NULL);
@@ -439,6 +474,18 @@ extern void setCurrentDirectory (void) /* TODO */
 }
 
 /* For caching of stat() calls */
+extern void fillFileStatus (fileStatus *status, const struct stat *st)
+{
+	status->isDirectory = (bool) S_ISDIR (st->st_mode);
+	status->isNormalFile = (bool) (S_ISREG (st->st_mode));
+	status->isExecutable = (bool) ((st->st_mode &
+		(S_IXUSR | S_IXGRP | S_IXOTH)) != 0);
+	status->isSetuid = (bool) ((st->st_mode & S_ISUID) != 0);
+	status->isSetgid = (bool) ((st->st_mode & S_ISGID) != 0);
+	status->size = st->st_size;
+	status->mtime = st->st_mtime;
+}
+
 extern fileStatus *eStat (const char *const fileName)
 {
 	struct stat status;
@@ -457,14 +504,7 @@ extern fileStatus *eStat (const char *const fileName)
 			else
 			{
 				file.exists = true;
-				file.isDirectory = (bool) S_ISDIR (status.st_mode);
-				file.isNormalFile = (bool) (S_ISREG (status.st_mode));
-				file.isExecutable = (bool) ((status.st_mode &
-					(S_IXUSR | S_IXGRP | S_IXOTH)) != 0);
-				file.isSetuid = (bool) ((status.st_mode & S_ISUID) != 0);
-				file.isSetgid = (bool) ((status.st_mode & S_ISGID) != 0);
-				file.size = status.st_size;
-				file.mtime = status.st_mtime;
+				fillFileStatus (&file, &status);
 			}
 		}
 	}
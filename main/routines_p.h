@@ -41,6 +41,8 @@ extern char *CurrentDirectory;
 extern const char *const PathDelimiters;
 #endif
 
+struct stat;
+
 typedef struct {
 		/* Name of file for which status is valid */
 	char* name;
@@ -78,6 +80,11 @@ typedef struct {
 */
 extern void freeRoutineResources (void);
 extern void setExecutableName (const char *const path);
+extern unsigned long getAllocationCount (void);
+
+/* Seconds elapsed since an arbitrary point. Unlike time (), the value
+ * never goes back. */
+extern double getMonotonicTime (void);
 
 /* File system functions */
 extern const char *getExecutableName (void);
@@ -85,6 +92,9 @@ extern const char *getExecutablePath (void);
 extern void setCurrentDirectory (void);
 extern fileStatus *eStat (const char *const fileName);
 extern void eStatFree (fileStatus *status);
+/* Fill the members of STATUS other than the name, exists, and
+ * isSymbolicLink from ST, a result of stat () or fstat (). */
+extern void fillFileStatus (fileStatus *status, const struct stat *st);
 extern bool doesFileExist (const char *const fileName);
 extern bool doesExecutableExist (const char *const fileName);
 extern bool isRecursiveLink (const char* const dirName);
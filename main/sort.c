@@ -12,23 +12,33 @@
 */
 #include "general.h"  /* must always come first */
 
+#include <ctype.h>
 #include <errno.h>
 #if defined (HAVE_IO_H)
 # include <io.h>
 #endif
+#include <stdint.h>
 #include <stdlib.h>  /* to declare malloc () */
 #if defined (HAVE_UNISTD_H)
 # include <unistd.h>
 #endif
 #include <string.h>
 #include <stdio.h>
+#if !defined (EXTERNAL_SORT) && defined (USE_POSIX_THREADS)
+# include <pthread.h>
+#endif
 
 #include "debug.h"
 #include "entry_p.h"
+#include "htable.h"
 #include "options_p.h"
+#include "ptag_p.h"
+#include "ptrarray.h"
 #include "read.h"
 #include "routines.h"
+#include "routines_p.h"
 #include "sort_p.h"
+#include "vstring.h"
 
 /*
 *   FUNCTION DEFINITIONS
@@ -38,14 +48,174 @@ extern void catFile (MIO *mio)
 {
 	if (mio != NULL)
 	{
-		int c;
+		char buf [64 * 1024];
+		size_t n;
+
 		mio_seek (mio, 0, SEEK_SET);
-		while ((c = mio_getc (mio)) != EOF)
-			putchar (c);
+		while ((n = mio_read (mio, buf, 1, sizeof (buf))) > 0)
+			fwrite (buf, 1, n, stdout);
 		fflush (stdout);
 	}
 }
 
+static bool isPseudoTagLine (const char *const line)
+{
+	return (strncmp (line, PSEUDO_TAG_PREFIX, strlen (PSEUDO_TAG_PREFIX)) == 0);
+}
+
+/* Return the length of the field at FIELD (0 for the tag name),
+ * and store its start to *START. */
+static size_t findTagLineField (const char *const line, int field, const char **start)
+{
+	const char *p = line;
+
+	for (int i = 0; i < field && p != NULL; i++)
+	{
+		p = strchr (p, '\t');
+		if (p)
+			p++;
+	}
+	if (p == NULL)
+		return 0;
+
+	*start = p;
+	const char *const tab = strchr (p, '\t');
+	return tab? (size_t) (tab - p): strlen (p);
+}
+
+static bool isTagLineInTable (char *const line, int field, hashTable *table)
+{
+	const char *start;
+	size_t len = findTagLineField (line, field, &start);
+	char *end;
+	char c;
+	bool r;
+
+	if (len == 0)
+		return false;
+
+	/* Terminate the field temporarily instead of copying it. */
+	end = line + (start - line) + len;
+	c = *end;
+	*end = '\0';
+	r = hashTableHasItem (table, start);
+	*end = c;
+	return r;
+}
+
+static void writeTagLine (MIO *mio, const char *const line)
+{
+	if (mio_puts (mio, line) == EOF || mio_putc (mio, '\n') == EOF)
+		error (FATAL | PERROR, "cannot write tag file");
+}
+
+/* Read the next line of OLDTAGS that is not replaced by NEWTAGS. */
+static const char *readKeptTagLine (vString *vLine, MIO *oldTags,
+									hashTable *updatedInputs,
+									hashTable *newPseudoTags)
+{
+	while (readLineRaw (vLine, oldTags) != NULL)
+	{
+		vStringStripNewline (vLine);
+		char *line = vStringValue (vLine);
+		if (*line == '\0')
+			continue;
+
+		if (isPseudoTagLine (line))
+		{
+			if (!isTagLineInTable (line, 0, newPseudoTags))
+				return line;
+		}
+		else if (!isTagLineInTable (line, 1, updatedInputs))
+			return line;
+	}
+	return NULL;
+}
+
+extern unsigned long mergeUpdatedTags (MIO *oldTags, MIO *newTags, MIO *out,
+									   hashTable *updatedInputs)
+{
+	ptrArray *newLines = ptrArrayNew (eFree);
+	hashTable *newPseudoTags = hashTableNew (17, hashCstrhash, hashCstreq,
+											 eFree, NULL);
+	vString *vLine = vStringNew ();
+	unsigned long kept = 0;
+	unsigned int i = 0;
+	unsigned int count;
+	const char *line;
+
+	/* The new tags are only for the updated input files; they fit in
+	 * memory. */
+	while ((line = readLineRaw (vLine, newTags)) != NULL)
+	{
+		vStringStripNewline (vLine);
+		if (vStringIsEmpty (vLine))
+			continue;
+
+		char *newLine = vStringStrdup (vLine);
+		ptrArrayAdd (newLines, newLine);
+
+		const char *start;
+		size_t len;
+		if (isPseudoTagLine (newLine)
+			&& (len = findTagLineField (newLine, 0, &start)) > 0)
+		{
+			char *name = eStrndup (start, len);
+			if (hashTableHasItem (newPseudoTags, name))
+				eFree (name);
+			else
+				hashTablePutItem (newPseudoTags, name, name);
+		}
+	}
+	count = ptrArrayCount (newLines);
+
+	if (Option.sorted == SO_UNSORTED)
+	{
+		/* Pseudo tags go first, as ctags writes them first. */
+		for (; i < count && isPseudoTagLine (ptrArrayItem (newLines, i)); i++)
+			writeTagLine (out, ptrArrayItem (newLines, i));
+		while ((line = readKeptTagLine (vLine, oldTags, updatedInputs, newPseudoTags)))
+		{
+			writeTagLine (out, line);
+			kept++;
+		}
+		for (; i < count; i++)
+			writeTagLine (out, ptrArrayItem (newLines, i));
+	}
+	else
+	{
+		int (* cmp) (const char *, const char *) =
+			(Option.sorted == SO_FOLDSORTED)? struppercmp: strcmp;
+
+		line = readKeptTagLine (vLine, oldTags, updatedInputs, newPseudoTags);
+		while (line != NULL || i < count)
+		{
+			const char *newLine = (i < count)? ptrArrayItem (newLines, i): NULL;
+			int r = (line == NULL)? 1: (newLine == NULL)? -1: cmp (line, newLine);
+
+			if (r < 0 || (r == 0 && strcmp (line, newLine) != 0))
+			{
+				writeTagLine (out, line);
+				kept++;
+				line = readKeptTagLine (vLine, oldTags, updatedInputs, newPseudoTags);
+			}
+			else
+			{
+				/* Like sort -u, an old line equal to a new one is dropped. */
+				if (r == 0)
+					line = readKeptTagLine (vLine, oldTags, updatedInputs, newPseudoTags);
+				writeTagLine (out, newLine);
+				i++;
+			}
+		}
+	}
+
+	vStringDelete (vLine);
+	hashTableDelete (newPseudoTags);
+	ptrArrayDelete (newLines);
+	return kept;
+}
+
 #ifdef EXTERNAL_SORT
 
 #ifdef NON_CONST_PUTENV_PROTOTYPE
@@ -172,11 +342,51 @@ extern void externalSortTags (const bool toStdout, MIO *tagFile)
 #else
 
 /*
- *  These functions provide a basic internal sort. No great memory
- *  optimization is performed (e.g. recursive subdivided sorts),
- *  so have lots of memory if you have large tag files.
+ *  These functions provide an internal sort which works in bounded memory
+ *  (--sort-memory). The lines of the tag file are read into a slab. When
+ *  the slab is full, its lines are sorted, split among threads, and the
+ *  sorted run is spilled to a temporary file. At the end, the runs are
+ *  merged. Like "sort -u" with LC_ALL=C, only the first line of lines
+ *  comparing equal is written; with --sort=foldcase, that is the one
+ *  appearing first in the tag file, as "sort -u -f" does.
  */
 
+#define SORT_MIN_MEMORY				(64 * 1024)
+#define SORT_MAX_THREADS			8
+#define SORT_MIN_LINES_PER_THREAD	16384
+#define SORT_MAX_MERGE_WAYS			16
+
+typedef struct sSortLine {
+	uint64_t key;		/* the first 8 bytes of the line, big endian */
+	const char *line;
+} sortLine;
+
+typedef struct sSortRun {
+	MIO *mio;
+	char *name;
+} sortRun;
+
+typedef struct sMergeSource {
+	sortLine current;	/* current.line is NULL at the end */
+	const sortLine *next;
+	const sortLine *end;
+	MIO *mio;			/* NULL if reading from NEXT */
+	vString *buffer;
+} mergeSource;
+
+typedef struct sSorter {
+	bool fold;
+	size_t memory;
+	char *slab;
+	size_t slabSize;
+	sortLine *lines;
+	size_t lineCount;
+	size_t lineAllocated;
+	sortRun *runs;
+	unsigned int runCount;
+	unsigned int runAllocated;
+} sorter;
+
 extern void failedSort (MIO *const mio, const char* msg)
 {
 	const char* const cannotSort = "cannot sort tag file";
@@ -188,116 +398,455 @@ extern void failedSort (MIO *const mio, const char* msg)
 		error (FATAL, "%s: %s", msg, cannotSort);
 }
 
-static int compareTagsFolded(const void *const one, const void *const two)
+static uint64_t makeSortKey (const char *const line, bool fold)
+{
+	uint64_t key = 0;
+	int i;
+
+	for (i = 0; i < 8 && line [i] != '\0'; i++)
+	{
+		unsigned char c = (unsigned char) line [i];
+		key = (key << 8) | (unsigned char) (fold? toupper (c): c);
+	}
+	for (; i < 8; i++)
+		key <<= 8;
+	return key;
+}
+
+/* Compare like strcmp () or struppercmp (), looking at the keys first. */
+static int compareSortLines (const sortLine *const a, const sortLine *const b,
+							 bool fold)
 {
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
+	if (a->key != b->key)
+		return (a->key < b->key)? -1: 1;
+
+	/* The lines end in the first 8 bytes. */
+	if ((a->key & 0xff) == 0)
+		return 0;
+
+	return fold
+		? struppercmp (a->line + 8, b->line + 8)
+		: strcmp (a->line + 8, b->line + 8);
+}
 
-	return struppercmp (line1, line2);
+/* The lines in a slab are in the order of the tag file. Comparing their
+ * addresses makes qsort () stable. */
+static int compareSortLinesStable (const sortLine *const a, const sortLine *const b,
+								   bool fold)
+{
+	int r = compareSortLines (a, b, fold);
+	if (r == 0 && a->line != b->line)
+		r = (a->line < b->line)? -1: 1;
+	return r;
 }
 
 static int compareTags (const void *const one, const void *const two)
 {
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
+	return compareSortLinesStable (one, two, false);
+}
+
+static int compareTagsFolded (const void *const one, const void *const two)
+{
+	return compareSortLinesStable (one, two, true);
+}
+
+typedef struct sSortTask {
+	sortLine *lines;
+	size_t count;
+	bool fold;
+} sortTask;
+
+static void *runSortTask (void *data)
+{
+	sortTask *task = data;
 
-	return strcmp (line1, line2);
+	qsort (task->lines, task->count, sizeof (*task->lines),
+		   task->fold? compareTagsFolded: compareTags);
+	return NULL;
 }
 
-static void writeSortedTags (
-		char **const table, const size_t numTags, const bool toStdout, bool newlineReplaced)
+static unsigned int countSortThreads (size_t lineCount)
 {
-	MIO *mio;
-	size_t i;
+#ifdef USE_POSIX_THREADS
+	long cpus = 1;
+# ifdef _SC_NPROCESSORS_ONLN
+	cpus = sysconf (_SC_NPROCESSORS_ONLN);
+# endif
+	size_t n = lineCount / SORT_MIN_LINES_PER_THREAD;
+
+	if (cpus < 1)
+		cpus = 1;
+	if (n > (size_t) cpus)
+		n = (size_t) cpus;
+	if (n > SORT_MAX_THREADS)
+		n = SORT_MAX_THREADS;
+	return n? (unsigned int) n: 1;
+#else
+	return 1;
+#endif
+}
 
-	/*  Write the sorted lines back into the tag file.
-	 */
-	if (toStdout)
-		mio = mio_new_fp (stdout, NULL);
-	else
+/* Sort the lines in the slab. They are split into *SEGMENTCOUNT
+ * segments sorted separately, and the segments are merged later.
+ * SEGMENTS [i] is the start of the i-th segment. */
+static void sortSlabLines (sorter *s, size_t *segments, unsigned int *segmentCount)
+{
+	unsigned int n = countSortThreads (s->lineCount);
+	sortTask tasks [SORT_MAX_THREADS];
+
+	for (unsigned int i = 0; i < n; i++)
 	{
-		mio = mio_new_file (tagFileName (), "w");
-		if (mio == NULL)
-			failedSort (mio, NULL);
+		segments [i] = s->lineCount / n * i;
+		tasks [i].lines = s->lines + segments [i];
+		tasks [i].count = ((i + 1 == n)? s->lineCount: s->lineCount / n * (i + 1))
+			- segments [i];
+		tasks [i].fold = s->fold;
 	}
-	for (i = 0 ; i < numTags ; ++i)
+	*segmentCount = n;
+
+#ifdef USE_POSIX_THREADS
+	pthread_t threads [SORT_MAX_THREADS];
+	bool started [SORT_MAX_THREADS];
+
+	for (unsigned int i = 1; i < n; i++)
+		started [i] = (pthread_create (threads + i, NULL, runSortTask, tasks + i) == 0);
+	runSortTask (tasks);
+	for (unsigned int i = 1; i < n; i++)
 	{
-		/*  Here we filter out identical tag *lines* (including search
-		 *  pattern) if this is not an xref file.
-		 */
-		if (i == 0  ||  Option.xref  ||  strcmp (table [i], table [i-1]) != 0)
+		if (started [i])
+			pthread_join (threads [i], NULL);
+		else
+			runSortTask (tasks + i);
+	}
+#else
+	for (unsigned int i = 0; i < n; i++)
+		runSortTask (tasks + i);
+#endif
+}
+
+static void advanceMergeSource (mergeSource *src, bool fold)
+{
+	if (src->mio == NULL)
+	{
+		if (src->next < src->end)
+			src->current = *src->next++;
+		else
+			src->current.line = NULL;
+		return;
+	}
+
+	src->current.line = NULL;
+	while (readLineRaw (src->buffer, src->mio) != NULL)
+	{
+		vStringStripNewline (src->buffer);
+		if (vStringIsEmpty (src->buffer))
+			continue;
+		src->current.line = vStringValue (src->buffer);
+		src->current.key = makeSortKey (src->current.line, fold);
+		break;
+	}
+}
+
+/* The heap of the merge sources. Sources comparing equal are ordered by
+ * their indexes; a source with a smaller index has the earlier lines of
+ * the tag file. */
+static bool isMergeSourceLess (mergeSource *srcs, unsigned int a, unsigned int b,
+							   bool fold)
+{
+	int r = compareSortLines (&srcs [a].current, &srcs [b].current, fold);
+	return r < 0 || (r == 0 && a < b);
+}
+
+static void siftDownMergeHeap (mergeSource *srcs, unsigned int *heap,
+							   unsigned int count, unsigned int i, bool fold)
+{
+	while (true)
+	{
+		unsigned int l = 2 * i + 1, r = l + 1, m = i;
+		if (l < count && isMergeSourceLess (srcs, heap [l], heap [m], fold))
+			m = l;
+		if (r < count && isMergeSourceLess (srcs, heap [r], heap [m], fold))
+			m = r;
+		if (m == i)
+			break;
+		unsigned int t = heap [i];
+		heap [i] = heap [m];
+		heap [m] = t;
+		i = m;
+	}
+}
+
+static void writeSortedLine (MIO *out, const char *const line)
+{
+	if (mio_puts (out, line) == EOF || mio_putc (out, '\n') == EOF)
+		failedSort (NULL, NULL);
+}
+
+/* Merge the sorted sources to OUT, dropping the lines comparing equal
+ * to the last written one. */
+static void mergeSources (mergeSource *srcs, unsigned int count, bool fold, MIO *out)
+{
+	unsigned int *heap = xMalloc (count, unsigned int);
+	unsigned int heapCount = 0;
+	vString *last = vStringNew ();
+	sortLine lastLine = { .line = NULL };
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		advanceMergeSource (srcs + i, fold);
+		if (srcs [i].current.line)
+			heap [heapCount++] = i;
+	}
+	for (unsigned int i = heapCount; i > 0; i--)
+		siftDownMergeHeap (srcs, heap, heapCount, i - 1, fold);
+
+	while (heapCount > 0)
+	{
+		mergeSource *src = srcs + heap [0];
+
+		if (lastLine.line == NULL
+			|| compareSortLines (&lastLine, &src->current, fold) != 0)
 		{
-			if (mio_puts (mio, table [i]) == EOF)
-				failedSort (mio, NULL);
-			else if (newlineReplaced)
-				mio_putc (mio, '\n');
+			writeSortedLine (out, src->current.line);
+			vStringCopyS (last, src->current.line);
+			lastLine.line = vStringValue (last);
+			lastLine.key = src->current.key;
 		}
+
+		advanceMergeSource (src, fold);
+		if (src->current.line == NULL)
+			heap [0] = heap [--heapCount];
+		siftDownMergeHeap (srcs, heap, heapCount, 0, fold);
 	}
-	if (toStdout)
-		mio_flush (mio);
-	mio_unref (mio);
+
+	vStringDelete (last);
+	eFree (heap);
 }
 
-extern void internalSortTags (const bool toStdout, MIO* mio, size_t numTags)
+static void writeSlab (sorter *s, MIO *out)
 {
-	vString *vLine = vStringNew ();
-	const char *line;
-	size_t i;
-	int (*cmpFunc)(const void *, const void *);
-	bool newlineReplaced = false;
+	size_t segments [SORT_MAX_THREADS];
+	unsigned int segmentCount;
+	mergeSource srcs [SORT_MAX_THREADS];
 
-	/*  Allocate a table of line pointers to be sorted.
-	 */
-	const size_t tableSize = numTags * sizeof (char *);
-	char **table = (char **) malloc (tableSize);  /* line pointers */
-	DebugStatement ( size_t mallocSize = tableSize; )  /* cumulative total */
+	sortSlabLines (s, segments, &segmentCount);
+	for (unsigned int i = 0; i < segmentCount; i++)
+	{
+		srcs [i].mio = NULL;
+		srcs [i].next = s->lines + segments [i];
+		srcs [i].end = s->lines + ((i + 1 < segmentCount)? segments [i + 1]: s->lineCount);
+	}
+	mergeSources (srcs, segmentCount, s->fold, out);
+	s->lineCount = 0;
+}
+
+static void addSortRun (sorter *s, MIO *mio, char *name)
+{
+	if (s->runCount == s->runAllocated)
+	{
+		s->runAllocated = s->runAllocated? s->runAllocated * 2: 8;
+		s->runs = xRealloc (s->runs, s->runAllocated, sortRun);
+	}
+	s->runs [s->runCount].mio = mio;
+	s->runs [s->runCount].name = name;
+	s->runCount++;
+}
 
+static void spillSlab (sorter *s)
+{
+	char *name = NULL;
+	MIO *mio = tempFile ("w+", &name);
 
-	cmpFunc = Option.sorted == SO_FOLDSORTED ? compareTagsFolded : compareTags;
-	if (table == NULL)
-		failedSort (mio, "out of memory");
+	writeSlab (s, mio);
+	addSortRun (s, mio, name);
+	verbose ("sort: spilled run %u to %s\n", s->runCount, name);
+}
 
-	for (i = 0  ;  i < numTags  &&  ! mio_eof (mio)  ;  )
+/* Merge the runs from FIRST to FIRST + COUNT - 1 to OUT. */
+static void mergeRuns (sorter *s, unsigned int first, unsigned int count, MIO *out)
+{
+	mergeSource *srcs = xMalloc (count, mergeSource);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		sortRun *run = s->runs + first + i;
+		if (mio_flush (run->mio) != 0 || mio_seek (run->mio, 0L, SEEK_SET) != 0)
+			failedSort (NULL, NULL);
+		srcs [i].mio = run->mio;
+		srcs [i].buffer = vStringNew ();
+	}
+	mergeSources (srcs, count, s->fold, out);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		sortRun *run = s->runs + first + i;
+		vStringDelete (srcs [i].buffer);
+		mio_unref (run->mio);
+		remove (run->name);
+		eFree (run->name);
+	}
+	eFree (srcs);
+}
+
+static void addSortLine (sorter *s, const char *const line)
+{
+	if (s->lineCount == s->lineAllocated)
+	{
+		s->lineAllocated = s->lineAllocated? s->lineAllocated * 2: 1024;
+		s->lines = xRealloc (s->lines, s->lineAllocated, sortLine);
+	}
+	s->lines [s->lineCount].key = makeSortKey (line, s->fold);
+	s->lines [s->lineCount].line = line;
+	s->lineCount++;
+}
+
+/* Read the lines of MIO into the slab, spilling sorted runs when the
+ * memory is used up. Returns true if all the lines fit in the slab. */
+static bool readSortLines (sorter *s, MIO *mio)
+{
+	size_t filled = 0, parsed = 0;
+	bool eof = false;
+
+	while (true)
 	{
-		line = readLineRaw (vLine, mio);
-		if (line == NULL)
+		char *nl = (parsed < filled)
+			? memchr (s->slab + parsed, '\n', filled - parsed)
+			: NULL;
+
+		if (nl == NULL && eof)
 		{
-			if (! mio_eof (mio))
-				failedSort (mio, NULL);
-			break;
+			if (parsed == filled)
+				break;
+			/* The last line has no newline. */
+			nl = s->slab + filled++;
 		}
-		else if (*line == '\0'  ||  strcmp (line, "\n") == 0)
-			;  /* ignore blank lines */
-		else
+
+		if (nl)
 		{
-			const size_t stringSize = strlen (line) + 1;
-
-			table [i] = (char *) malloc (stringSize);
-			if (table [i] == NULL)
-				failedSort (mio, "out of memory");
-			DebugStatement ( mallocSize += stringSize; )
-			strcpy (table [i], line);
-			if (table[i][stringSize - 2] == '\n')
+			*nl = '\0';
+			if (nl > s->slab + parsed)
+				addSortLine (s, s->slab + parsed);
+			parsed = (size_t) (nl - s->slab) + 1;
+			if (parsed + s->lineCount * sizeof (sortLine) < s->memory)
+				continue;
+		}
+		else if (filled < s->slabSize)
+		{
+			size_t n = mio_read (mio, s->slab + filled, 1, s->slabSize - filled);
+			if (n == 0)
 			{
-				table[i][stringSize - 2] = '\0';
-				newlineReplaced = true;
+				if (mio_error (mio))
+					failedSort (NULL, NULL);
+				eof = true;
+				/* Room for the terminator of the last line */
+				if (filled == s->slabSize)
+					s->slab = xRealloc (s->slab, ++s->slabSize, char);
 			}
-			++i;
+			filled += n;
+			continue;
+		}
+		else if (s->lineCount == 0)
+		{
+			/* A line longer than the slab */
+			s->slabSize *= 2;
+			s->slab = xRealloc (s->slab, s->slabSize, char);
+			continue;
 		}
+
+		/* The memory is used up. */
+		if (eof && parsed == filled)
+			break;
+		if (s->lineCount > 0)
+			spillSlab (s);
+		memmove (s->slab, s->slab + parsed, filled - parsed);
+		filled -= parsed;
+		parsed = 0;
 	}
-	numTags = i;
-	vStringDelete (vLine);
 
-	/*  Sort the lines.
+	return (s->runCount == 0);
+}
+
+extern void internalSortTags (const bool toStdout, MIO* mio, size_t numTags)
+{
+	sorter s = {
+		.fold = (Option.sorted == SO_FOLDSORTED),
+		.memory = Option.sortMemory,
+	};
+	long size;
+	MIO *out;
+
+	if (s.memory < SORT_MIN_MEMORY)
+		s.memory = SORT_MIN_MEMORY;
+
+	/*  Don't allocate more than the size of the tag file.
 	 */
-	qsort (table, numTags, sizeof (*table), cmpFunc);
+	if (mio_seek (mio, 0L, SEEK_END) != 0)
+		failedSort (NULL, NULL);
+	size = mio_tell (mio);
+	if (size < 0 || mio_seek (mio, 0L, SEEK_SET) != 0)
+		failedSort (NULL, NULL);
+	s.slabSize = ((size_t) size < s.memory)? (size_t) size + 1: s.memory;
+	s.slab = xMalloc (s.slabSize, char);
+	if (numTags > 0 && numTags * sizeof (sortLine) < s.memory)
+	{
+		s.lineAllocated = numTags;
+		s.lines = xMalloc (s.lineAllocated, sortLine);
+	}
 
-	writeSortedTags (table, numTags, toStdout, newlineReplaced);
+	bool inMemory = readSortLines (&s, mio);
+	if (!inMemory)
+	{
+		if (s.lineCount > 0)
+			spillSlab (&s);
+		eFree (s.slab);
+		s.slab = NULL;
+		if (s.lines)
+			eFree (s.lines);
+		s.lines = NULL;
+
+		/* Limit the number of files opened at once. */
+		while (s.runCount > SORT_MAX_MERGE_WAYS)
+		{
+			char *name = NULL;
+			MIO *merged = tempFile ("w+", &name);
+
+			mergeRuns (&s, 0, SORT_MAX_MERGE_WAYS, merged);
+			s.runs [0].mio = merged;
+			s.runs [0].name = name;
+			memmove (s.runs + 1, s.runs + SORT_MAX_MERGE_WAYS,
+					 (s.runCount - SORT_MAX_MERGE_WAYS) * sizeof (sortRun));
+			s.runCount -= SORT_MAX_MERGE_WAYS - 1;
+		}
+	}
 
-	PrintStatus (("sort memory: %ld bytes\n", (long) mallocSize));
-	for (i = 0 ; i < numTags ; ++i)
-		free (table [i]);
-	free (table);
+	/*  Write the sorted lines back into the tag file.
+	 */
+	if (toStdout)
+		out = mio_new_fp (stdout, NULL);
+	else
+	{
+		out = mio_new_file (tagFileName (), "w");
+		if (out == NULL)
+			failedSort (out, NULL);
+	}
+
+	if (inMemory)
+		writeSlab (&s, out);
+	else
+		mergeRuns (&s, 0, s.runCount, out);
+
+	if (toStdout)
+		mio_flush (out);
+	mio_unref (out);
+
+	PrintStatus (("sort memory: %lu bytes, %u run(s)\n",
+				  (unsigned long) (s.slabSize + s.lineAllocated * sizeof (sortLine)),
+				  s.runCount));
+	if (s.slab)
+		eFree (s.slab);
+	if (s.lines)
+		eFree (s.lines);
+	if (s.runs)
+		eFree (s.runs);
 }
 
 #endif
@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 
+#include "htable.h"
 #include "mio.h"
 
 /*
@@ -31,6 +32,15 @@ extern void internalSortTags (const bool toStdout,
 			      size_t numTags);
 #endif
 
+/* Used for --update.
+ * Write the tags in OLDTAGS and NEWTAGS, both sorted in the same way,
+ * to OUT, keeping the order. Tags in OLDTAGS whose input fields are in
+ * UPDATEDINPUTS are dropped. Pseudo tags in OLDTAGS are dropped if
+ * NEWTAGS has pseudo tags with the same names. Returns the number of
+ * tags taken from OLDTAGS. */
+extern unsigned long mergeUpdatedTags (MIO *oldTags, MIO *newTags, MIO *out,
+									   hashTable *updatedInputs);
+
 /* mio is closed in this function. */
 extern void failedSort (MIO *const mio, const char* msg);
 
@@ -1,10 +1,13 @@
 sources.cmake
+arena_p.h
 args_p.h
+cache_p.h
 colprint_p.h
 ctags.h
 debug.h
 dependency.h
 dependency_p.h
+dirwalk_p.h
 e_msoft.h
 entry.h
 entry_p.h
@@ -13,6 +16,9 @@ field.h
 field_p.h
 flags_p.h
 fmt_p.h
+gitindex_p.h
+globset_p.h
+ignore_p.h
 fname.h
 gcc-attr.h
 general.h
@@ -21,6 +27,7 @@ htable.h
 inline.h
 interactive_p.h
 interval_tree_generic.h
+jobs_p.h
 keyword.h
 keyword_p.h
 kind.h
@@ -44,6 +51,7 @@ parse.h
 parse_p.h
 parsers_p.h
 portable-dirent_p.h
+profile_p.h
 promise.h
 promise_p.h
 ptag_p.h
@@ -61,6 +69,7 @@ stats_p.h
 strlist.h
 subparser.h
 subparser_p.h
+tagindex_p.h
 tokeninfo.h
 trace.h
 trashbox.h
@@ -73,19 +82,26 @@ writer_p.h
 xtag.h
 xtag_p.h
 CommonPrelude.c
+arena.c
 args.c
+cache.c
 cmd.c
 colprint.c
 debug.c
 dependency.c
+dirwalk.c
 entry.c
 entry_private.c
 error.c
 field.c
 flags.c
 fmt.c
+gitindex.c
+globset.c
 fname.c
 htable.c
+ignore.c
+jobs.c
 keyword.c
 kind.c
 lregex-default.c
@@ -103,6 +119,7 @@ options.c
 param.c
 parse.c
 portable-scandir.c
+profile.c
 promise.c
 ptag.c
 ptrarray.c
@@ -116,6 +133,7 @@ selectors.c
 sort.c
 stats.c
 strlist.c
+tagindex.c
 tokeninfo.c
 trace.c
 trashbox.c
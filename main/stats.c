@@ -19,6 +19,7 @@
 
 #include "entry_p.h"
 #include "options_p.h"
+#include "routines_p.h"
 #include "stats_p.h"
 
 /*
@@ -35,6 +36,26 @@ static struct { long files, lines, bytes; } Totals = { 0, 0, 0 };
 /*
 *   FUNCTION DEFINITIONS
 */
+
+/* Return the peak resident set size of this process in kB, or 0 if
+ * unknown. ru_maxrss of getrusage () is not used; it includes the
+ * memory used by the process before exec (). */
+static unsigned long getPeakResidentSetSize (void)
+{
+	unsigned long kb = 0;
+#ifdef __linux__
+	char line [128];
+	FILE *fp = fopen ("/proc/self/status", "r");
+
+	if (fp == NULL)
+		return 0;
+	while (fgets (line, sizeof (line), fp) != NULL)
+		if (sscanf (line, "VmHWM: %lu kB", &kb) == 1)
+			break;
+	fclose (fp);
+#endif
+	return kb;
+}
 extern void addTotals (
 		const unsigned int files, const long unsigned int lines,
 		const long unsigned int bytes)
@@ -44,6 +65,13 @@ extern void addTotals (
 	Totals.bytes += bytes;
 }
 
+extern void getTotals (long *files, long *lines, long *bytes)
+{
+	*files = Totals.files;
+	*lines = Totals.lines;
+	*bytes = Totals.bytes;
+}
+
 extern void printTotals (const clock_t *const timeStamps, bool append, sortType sorted)
 {
 	const unsigned long totalTags = numTagsTotal();
@@ -78,6 +106,20 @@ extern void printTotals (const clock_t *const timeStamps, bool append, sortType
 		fputc ('\n', stderr);
 	}
 
+	if (Option.printTotals > 1)
+	{
+		const unsigned long allocations = getAllocationCount ();
+
+		fprintf (stderr, "%lu allocation%s", allocations, plural (allocations));
+		if (addedTags > 0)
+			fprintf (stderr, " (%.02f per tag)", (double) allocations / addedTags);
+		fputc ('\n', stderr);
+
+		const unsigned long rss = getPeakResidentSetSize ();
+		if (rss > 0)
+			fprintf (stderr, "peak RSS: %lu kB\n", rss);
+	}
+
 #ifdef DEBUG
 	fprintf (stderr, "longest tag line = %lu\n",
 		 (unsigned long) maxTagsLine ());
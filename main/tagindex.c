@@ -0,0 +1,494 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for writing the index of a tag file
+*   (--tag-index). The index is stored next to the tag file as
+*   "<tagfile>.idx". libreadtags uses it for looking up tags by name
+*   without searching the tag file. The format is described in
+*   libreadtags/readtags.c; the two must be kept in sync.
+*
+*   The index is made from the tag file after it is written, sorted, or
+*   updated, so it reflects the final contents of the tag file whatever
+*   options made it.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "debug.h"
+#include "options.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "tagindex_p.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define TAG_INDEX_MAGIC "ctagsidx"
+#define TAG_INDEX_VERSION 2
+#define TAG_INDEX_HEADER_SIZE 80
+#define TAG_INDEX_ENTRY_SIZE 16
+#define TAG_INDEX_SLOT_SIZE 4
+
+#define FNV32_OFFSET_BASIS ((uint32_t) 0x811c9dc5U)
+#define FNV32_PRIME ((uint32_t) 0x01000193U)
+
+#define READ_CHUNK_SIZE (64 * 1024)
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct {
+	uint64_t offset;			/* where the tag line starts */
+	uint32_t name;				/* offset in the name pool */
+	uint32_t length;
+} indexEntry;
+
+typedef struct {
+	indexEntry *entries;
+	size_t count;
+	size_t allocated;
+	char *names;
+	size_t namesSize;
+	size_t namesAllocated;
+} indexBuilder;
+
+/*
+*   DATA DEFINITIONS
+*/
+
+/* For compareIndexEntries () given to qsort () */
+static const char *SortedNames;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/* The same as fileStatMtimeNsec () and fileStatInode () of
+ * libreadtags/readtags.c */
+static uint64_t fileStatMtimeNsec (const struct stat *status)
+{
+#if defined (_WIN32)
+	return 0;
+#elif defined (__APPLE__)
+	return (uint64_t) status->st_mtimespec.tv_nsec;
+#else
+	return (uint64_t) status->st_mtim.tv_nsec;
+#endif
+}
+
+/* MinGW has st_ino, but it doesn't work. */
+static uint64_t fileStatInode (const struct stat *status)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return (uint64_t) status->st_ino;
+#endif
+}
+
+static bool isSameFileStat (const struct stat *a, const struct stat *b)
+{
+	return (a->st_size == b->st_size
+			&& a->st_mtime == b->st_mtime
+			&& fileStatMtimeNsec (a) == fileStatMtimeNsec (b)
+			&& fileStatInode (a) == fileStatInode (b)
+			&& a->st_dev == b->st_dev);
+}
+
+static int foldChar (unsigned char c)
+{
+	return (c >= 'a' && c <= 'z')? c - 'a' + 'A': c;
+}
+
+static uint32_t hashFoldedName (const char *name, size_t length)
+{
+	uint32_t h = FNV32_OFFSET_BASIS;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		h ^= (uint32_t) foldChar ((unsigned char) name[i]);
+		h *= FNV32_PRIME;
+	}
+	return h;
+}
+
+static int compareFoldedNames (const char *a, size_t alen, const char *b, size_t blen)
+{
+	size_t n = (alen < blen)? alen: blen;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		int d = foldChar ((unsigned char) a[i]) - foldChar ((unsigned char) b[i]);
+		if (d != 0)
+			return d;
+	}
+	return (alen < blen)? -1: (alen > blen)? 1: 0;
+}
+
+static int compareIndexEntries (const void *a, const void *b)
+{
+	const indexEntry *ea = a;
+	const indexEntry *eb = b;
+	const char *na = SortedNames + ea->name;
+	const char *nb = SortedNames + eb->name;
+	int d;
+
+	d = compareFoldedNames (na, ea->length, nb, eb->length);
+	if (d != 0)
+		return d;
+
+	d = memcmp (na, nb, ea->length);
+	if (d != 0)
+		return d;
+
+	return (ea->offset < eb->offset)? -1: (ea->offset > eb->offset)? 1: 0;
+}
+
+static int hexValue (unsigned char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	else if (c >= 'a' && c <= 'f')
+		return 10 + c - 'a';
+	else if (c >= 'A' && c <= 'F')
+		return 10 + c - 'A';
+	return -1;
+}
+
+/* Unescape a name field the same way readtags compares names. The
+ * result is cut at a NUL, which ends a name in the comparison. */
+static size_t unescapeTagName (const char *s, size_t length, char *out)
+{
+	const char *end = s + length;
+	size_t n = 0;
+
+	while (s < end)
+	{
+		int c = (unsigned char) *s++;
+
+		if (c == '\\' && s < end)
+		{
+			switch (*s)
+			{
+				case 't': c = '\t'; s++; break;
+				case 'r': c = '\r'; s++; break;
+				case 'n': c = '\n'; s++; break;
+				case '\\': c = '\\'; s++; break;
+				case 'a': c = '\a'; s++; break;
+				case 'b': c = '\b'; s++; break;
+				case 'v': c = '\v'; s++; break;
+				case 'f': c = '\f'; s++; break;
+				case 'x':
+					if (end - s >= 3
+						&& hexValue ((unsigned char) s[1]) >= 0
+						&& hexValue ((unsigned char) s[2]) >= 0)
+					{
+						int val = (hexValue ((unsigned char) s[1]) << 4)
+							| hexValue ((unsigned char) s[2]);
+						if (val < 0x80)
+						{
+							s += 3;
+							c = val;
+						}
+					}
+					break;
+			}
+		}
+
+		if (c == '\0')
+			break;
+		out[n++] = (char) c;
+	}
+	return n;
+}
+
+static bool addIndexEntry (indexBuilder *builder, uint64_t offset,
+						   const char *line, size_t lineLength)
+{
+	const char *end = memchr (line, '\t', lineLength);
+
+	/* readtags ends the name of a line without fields at a CR. */
+	if (end == NULL)
+		end = memchr (line, '\r', lineLength);
+	size_t length = end? (size_t) (end - line): lineLength;
+
+	/* readtags skips lines with an empty name. */
+	if (length == 0)
+		return true;
+
+	if (builder->count == builder->allocated)
+	{
+		builder->allocated = builder->allocated? builder->allocated * 2: 4096;
+		builder->entries = eRealloc (builder->entries,
+									 builder->allocated * sizeof (indexEntry));
+	}
+	while (builder->namesSize + length > builder->namesAllocated)
+	{
+		builder->namesAllocated = builder->namesAllocated? builder->namesAllocated * 2: 65536;
+		builder->names = eRealloc (builder->names, builder->namesAllocated);
+	}
+
+	length = unescapeTagName (line, length, builder->names + builder->namesSize);
+	if (length == 0)
+		return true;
+
+	if (builder->namesSize + length > UINT32_MAX)
+		return false;
+
+	indexEntry *e = builder->entries + builder->count++;
+	e->offset = offset;
+	e->name = (uint32_t) builder->namesSize;
+	e->length = (uint32_t) length;
+	builder->namesSize += length;
+	return true;
+}
+
+/* Collect the names and the offsets of the lines in the tag file. Return
+ * the size of the tag file, or -1 on error. */
+static int64_t collectIndexEntries (FILE *fp, indexBuilder *builder)
+{
+	char *chunk = eMalloc (READ_CHUNK_SIZE);
+	vString *partial = vStringNew ();
+	uint64_t offset = 0;		/* of the line being read */
+	uint64_t size = 0;
+	size_t n;
+	bool ok = true;
+
+	while (ok && (n = fread (chunk, 1, READ_CHUNK_SIZE, fp)) > 0)
+	{
+		const char *p = chunk;
+		const char *end = chunk + n;
+
+		size += n;
+		while (ok && p < end)
+		{
+			const char *nl = memchr (p, '\n', end - p);
+			if (nl == NULL)
+			{
+				vStringNCatSUnsafe (partial, p, end - p);
+				break;
+			}
+
+			if (vStringLength (partial) > 0)
+			{
+				vStringNCatSUnsafe (partial, p, nl - p);
+				ok = addIndexEntry (builder, offset,
+									vStringValue (partial), vStringLength (partial));
+				offset += vStringLength (partial) + 1;
+				vStringClear (partial);
+			}
+			else
+			{
+				ok = addIndexEntry (builder, offset, p, nl - p);
+				offset += (nl - p) + 1;
+			}
+			p = nl + 1;
+		}
+	}
+	if (ok && ferror (fp))
+		ok = false;
+	if (ok && vStringLength (partial) > 0)
+		ok = addIndexEntry (builder, offset,
+							vStringValue (partial), vStringLength (partial));
+
+	vStringDelete (partial);
+	eFree (chunk);
+	return ok? (int64_t) size: -1;
+}
+
+static void putIndexValue (unsigned char *p, uint64_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		p[i] = (unsigned char) (value >> (8 * i));
+}
+
+static uint32_t *makeIndexSlots (const indexBuilder *builder, uint64_t *slotCount)
+{
+	size_t groups = 0;
+
+	for (size_t i = 0; i < builder->count; i++)
+	{
+		const indexEntry *e = builder->entries + i;
+		if (i == 0
+			|| compareFoldedNames (builder->names + e[-1].name, e[-1].length,
+								   builder->names + e->name, e->length) != 0)
+			groups++;
+	}
+
+	uint64_t count = 2;
+	while (count < groups * 2)
+		count *= 2;
+
+	uint32_t *slots = xCalloc (count, uint32_t);
+	for (size_t i = 0; i < builder->count; i++)
+	{
+		const indexEntry *e = builder->entries + i;
+		if (i > 0
+			&& compareFoldedNames (builder->names + e[-1].name, e[-1].length,
+								   builder->names + e->name, e->length) == 0)
+			continue;
+
+		uint64_t s = hashFoldedName (builder->names + e->name, e->length) & (count - 1);
+		while (slots[s] != 0)
+			s = (s + 1) & (count - 1);
+		slots[s] = (uint32_t) (i + 1);
+	}
+
+	*slotCount = count;
+	return slots;
+}
+
+static bool writeIndexFile (FILE *fp, const indexBuilder *builder,
+							const struct stat *tagFileStatus)
+{
+	unsigned char header[TAG_INDEX_HEADER_SIZE];
+	unsigned char buffer[TAG_INDEX_ENTRY_SIZE * 1024];
+	uint64_t slotCount;
+	uint32_t *slots = makeIndexSlots (builder, &slotCount);
+	size_t used;
+
+	memcpy (header, TAG_INDEX_MAGIC, 8);
+	putIndexValue (header + 8, TAG_INDEX_VERSION, 4);
+	putIndexValue (header + 12, 0, 4);
+	putIndexValue (header + 16, (uint64_t) tagFileStatus->st_size, 8);
+	putIndexValue (header + 24, (uint64_t) (int64_t) tagFileStatus->st_mtime, 8);
+	putIndexValue (header + 32, builder->count, 8);
+	putIndexValue (header + 40, slotCount, 8);
+	putIndexValue (header + 48, builder->namesSize, 8);
+	putIndexValue (header + 56, fileStatMtimeNsec (tagFileStatus), 8);
+	putIndexValue (header + 64, fileStatInode (tagFileStatus), 8);
+	putIndexValue (header + 72, (uint64_t) tagFileStatus->st_dev, 8);
+	fwrite (header, 1, sizeof (header), fp);
+
+	used = 0;
+	for (size_t i = 0; i < builder->count; i++)
+	{
+		const indexEntry *e = builder->entries + i;
+		putIndexValue (buffer + used, e->offset, 8);
+		putIndexValue (buffer + used + 8, e->name, 4);
+		putIndexValue (buffer + used + 12, e->length, 4);
+		used += TAG_INDEX_ENTRY_SIZE;
+		if (used == sizeof (buffer) || i + 1 == builder->count)
+		{
+			fwrite (buffer, 1, used, fp);
+			used = 0;
+		}
+	}
+
+	for (uint64_t i = 0; i < slotCount; i++)
+	{
+		putIndexValue (buffer + used, slots[i], 4);
+		used += TAG_INDEX_SLOT_SIZE;
+		if (used == sizeof (buffer) || i + 1 == slotCount)
+		{
+			fwrite (buffer, 1, used, fp);
+			used = 0;
+		}
+	}
+	eFree (slots);
+
+	fwrite (builder->names, 1, builder->namesSize, fp);
+	return (ferror (fp) == 0);
+}
+
+extern void writeTagIndex (const char *const tagFileName)
+{
+	indexBuilder builder = { 0 };
+	vString *indexName = vStringNewInit (tagFileName);
+	vString *tmpName;
+	struct stat status, after;
+	FILE *fp;
+	int64_t size;
+
+	vStringCatS (indexName, TAG_INDEX_SUFFIX);
+	tmpName = vStringNewCopy (indexName);
+	vStringCatS (tmpName, ".tmp");
+	verbose ("writing the index of %s to %s\n", tagFileName, vStringValue (indexName));
+
+	fp = fopen (tagFileName, "rb");
+	if (fp == NULL || stat (tagFileName, &status) != 0)
+	{
+		error (WARNING | PERROR, "cannot open tag file \"%s\" for indexing", tagFileName);
+		if (fp)
+			fclose (fp);
+		goto out;
+	}
+	size = collectIndexEntries (fp, &builder);
+	fclose (fp);
+	if (size < 0)
+	{
+		error (WARNING, "cannot index tag file \"%s\"", tagFileName);
+		goto out;
+	}
+
+	/* The recorded status must be the one of the contents indexed. */
+	if (stat (tagFileName, &after) != 0 || !isSameFileStat (&status, &after)
+		|| (int64_t) status.st_size != size)
+	{
+		error (WARNING, "tag file \"%s\" changed while indexing", tagFileName);
+		goto out;
+	}
+
+	SortedNames = builder.names;
+	if (builder.count > 0)
+		qsort (builder.entries, builder.count, sizeof (indexEntry), compareIndexEntries);
+	SortedNames = NULL;
+
+	fp = fopen (vStringValue (tmpName), "wb");
+	if (fp == NULL)
+	{
+		error (WARNING | PERROR, "cannot open \"%s\"", vStringValue (tmpName));
+		goto out;
+	}
+	bool written = writeIndexFile (fp, &builder, &status);
+	if (fclose (fp) != 0 || !written)
+	{
+		error (WARNING | PERROR, "cannot write \"%s\"", vStringValue (tmpName));
+		remove (vStringValue (tmpName));
+		goto out;
+	}
+
+	/* rename () of Windows doesn't replace an existing file. */
+	if (rename (vStringValue (tmpName), vStringValue (indexName)) != 0
+		&& (remove (vStringValue (indexName)) != 0
+			|| rename (vStringValue (tmpName), vStringValue (indexName)) != 0))
+	{
+		error (WARNING | PERROR, "cannot replace \"%s\"", vStringValue (indexName));
+		remove (vStringValue (tmpName));
+	}
+
+ out:
+	if (builder.entries)
+		eFree (builder.entries);
+	if (builder.names)
+		eFree (builder.names);
+	vStringDelete (tmpName);
+	vStringDelete (indexName);
+}
+
+extern void removeTagIndex (const char *const tagFileName)
+{
+	vString *indexName = vStringNewInit (tagFileName);
+
+	vStringCatS (indexName, TAG_INDEX_SUFFIX);
+	if (doesFileExist (vStringValue (indexName)))
+	{
+		verbose ("removing the stale index %s\n", vStringValue (indexName));
+		if (remove (vStringValue (indexName)) != 0)
+			error (WARNING | PERROR, "cannot remove \"%s\"", vStringValue (indexName));
+	}
+	vStringDelete (indexName);
+}
@@ -0,0 +1,35 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Private interface to tagindex.c, writing the index of a tag file
+*   (--tag-index).
+*/
+#ifndef CTAGS_MAIN_TAGINDEX_PRIVATE_H
+#define CTAGS_MAIN_TAGINDEX_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   MACROS
+*/
+#define TAG_INDEX_SUFFIX ".idx"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Write TAGFILENAME.idx for the tag file TAGFILENAME. The tag file must
+ * be closed already. Failures are reported as warnings. */
+extern void writeTagIndex (const char *const tagFileName);
+
+/* Remove TAGFILENAME.idx if it exists. Call this when the tag file is
+ * rewritten without an index; the old index doesn't describe it. */
+extern void removeTagIndex (const char *const tagFileName);
+
+#endif	/* CTAGS_MAIN_TAGINDEX_PRIVATE_H */
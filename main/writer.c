@@ -117,6 +117,11 @@ extern bool writerCanPrintPtag (void)
 	return (writer->writePtagEntry)? true: false;
 }
 
+extern bool writerIsCtagsFormat (void)
+{
+	return (writer->type == WRITER_U_CTAGS || writer->type == WRITER_E_CTAGS);
+}
+
 extern bool writerDoesTreatFieldAsFixed (int fieldType)
 {
 	if (writer->treatFieldAsFixed)
@@ -1,14 +1,15 @@
 # -*- makefile -*-
-.PHONY: check units fuzz noise tmain tinst tlib man-test clean-units clean-tlib clean-tmain clean-gcov clean-man-test run-gcov codecheck cppcheck dicts validate-input check-genfile tutil
+.PHONY: check units fuzz noise tmain tinst tlib man-test bench clean-units clean-tlib clean-tmain clean-gcov clean-man-test clean-bench run-gcov codecheck cppcheck dicts validate-input check-genfile tutil
 
-EXTRA_DIST += misc/units misc/units.py misc/man-test.py
+EXTRA_DIST += misc/units misc/units.py misc/man-test.py misc/bench.py
 EXTRA_DIST += misc/tlib misc/mini-geany.expected
 MAN_TEST_TMPDIR = ManTest
+BENCH_TMPDIR = Bench
 
 check: tmain units tlib man-test check-genfile tutil
 
 # We may use CLEANFILES, DISTCLEANFILES, or etc.
-clean-local: clean-units clean-tmain clean-man-test clean-tlib clean-gcov
+clean-local: clean-units clean-tmain clean-man-test clean-tlib clean-gcov clean-bench
 
 CTAGS_TEST = ./ctags$(EXEEXT)
 READTAGS_TEST = ./readtags$(EXEEXT)
@@ -304,6 +305,40 @@ man-test: $(CTAGS_DEP)
 clean-man-test:
 	rm -rf $(MAN_TEST_TMPDIR)
 
+#
+# BENCH Target
+#
+# The corpus file of each language is at least BENCH_SIZE MiB.
+# The results are written to BENCH_OUTPUT as JSON lines. Give the
+# results of an earlier run as BENCH_BASELINE for comparing.
+#
+#    $ make bench LANGUAGES=C,Python BENCH_OUTPUT=before.json
+#    (change the code)
+#    $ make bench LANGUAGES=C,Python BENCH_BASELINE=before.json
+#
+BENCH_SIZE = 4
+BENCH_REPEAT = 3
+BENCH_OUTPUT = $(BENCH_TMPDIR)/results.json
+BENCH_BASELINE =
+bench: $(CTAGS_DEP) $(UTILTEST_DEP)
+	$(V_RUN) \
+	if test x$(PYTHON) = x; then \
+		echo "python is needed for running bench" 1>&2; \
+		exit 1; \
+	fi; \
+	$(PYTHON) $(srcdir)/misc/bench.py \
+		--ctags=$(CTAGS_TEST) \
+		--languages=$(LANGUAGES) \
+		--size=$(BENCH_SIZE) \
+		--repeat=$(BENCH_REPEAT) \
+		--output=$(BENCH_OUTPUT) \
+		--compare=$(BENCH_BASELINE) \
+		$(srcdir)/Units $(BENCH_TMPDIR) && \
+	UTILTEST_BENCH=1 $(UTILTEST_TEST) htable/bench
+
+clean-bench:
+	rm -rf $(BENCH_TMPDIR)
+
 # check if generated files are committed.
 #   Note: "make -B" cannot be used here, since it reruns automake
 chkgen_verbose = $(chkgen_verbose_@AM_V@)
@@ -0,0 +1,457 @@
+#!/usr/bin/env python3
+
+#
+# bench.py - Benchmark harness for the parsers of ctags
+#
+# Copyright (C) 2026 Universal Ctags Team
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+#
+# Python 3.5 or later is required. os.wait4(), used for measuring
+# the CPU time of ctags, is not available on Windows.
+#
+# For each language, the input files of Units (Units/*.d/input.* and
+# Units/*.r/*.d/input.*) are collected, and a corpus file of at least
+# --size MiB is made in the work directory by concatenating the inputs
+# repeatedly. ctags parses the corpus with only the parser for the
+# language.
+#
+# Units has broken inputs, like ones with an unterminated comment or an
+# unbalanced brace, and inputs of languages allowing only one document
+# in a file. Such an input would hide the inputs after it, or change
+# their scopes. So an input is put in the corpus only if ctags makes
+# the same tags from it, apart from the line numbers, when it is written
+# twice and when all the inputs chosen are written twice, as from the
+# input alone. If no input of a language passes, the corpus is the list
+# of the inputs repeated up to --size MiB ("concatenated" is false in
+# the results).
+#
+# The inputs put in the corpus are also parsed as separate files,
+# once each, for measuring the cost of each input file apart from the
+# cost of parsing.
+#
+# The results are written as JSON lines:
+#
+#   {"type": "environment", "ctags": ..., "size": ..., "repeat": ...}
+#   {"type": "parser", "language": ..., "concatenated": ...,
+#    "inputs": ..., "files": ..., "bytes": ..., "tags": ...,
+#    "seconds": ..., "cpu_seconds": ..., "mb_per_sec": ...,
+#    "tags_per_sec": ..., "peak_rss_kb": ..., "allocations": ...,
+#    "allocations_per_tag": ..., "per_file_us": ...}
+#
+# "inputs" is the number of the Units inputs in the corpus, and "files"
+# is the number of the files given to ctags. "seconds" and
+# "cpu_seconds" are the best of --repeat runs. "allocations" and
+# "peak_rss_kb" are the numbers reported by --totals=extra if
+# available. "per_file_us" is the time for parsing the inputs as
+# separate files, less the time for the same bytes at "mb_per_sec",
+# divided by the number of the inputs.
+#
+
+import argparse
+import bisect
+import glob
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+CTAGS = './ctags'
+
+def error_exit(status, msg):
+    print(msg, file=sys.stderr)
+    sys.exit(status)
+
+def forced_language(unit_dir):
+    args = os.path.join(unit_dir, 'args.ctags')
+    if not os.path.isfile(args):
+        return None
+    with open(args, 'r', errors='replace') as f:
+        for l in f.read().splitlines():
+            m = re.match(r'^--language-force=(.+)$', l.strip())
+            if m:
+                return m.group(1)
+    return None
+
+def collect_inputs(units_dir):
+    inputs = []
+    dirs = glob.glob(os.path.join(units_dir, '*.d'))
+    dirs += glob.glob(os.path.join(units_dir, '*.r', '*.d'))
+    for d in sorted(dirs):
+        lang = forced_language(d)
+        for f in sorted(glob.glob(os.path.join(d, 'input.*'))):
+            if os.path.isfile(f):
+                inputs.append((f, lang))
+    return inputs
+
+def guess_languages(inputs):
+    guessed = {}
+    unknown = [f for (f, lang) in inputs if lang is None]
+    for i in range(0, len(unknown), 256):
+        ret = subprocess.run([CTAGS, '--quiet', '--options=NONE', '--print-language']
+                             + unknown[i:i + 256],
+                             stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+        for l in ret.stdout.decode('utf-8', errors='replace').splitlines():
+            m = re.match(r'^(.+): (\S+)$', l)
+            if m and m.group(2) != 'NONE':
+                guessed[m.group(1)] = m.group(2)
+
+    corpora = {}
+    for (f, lang) in inputs:
+        if lang is None:
+            lang = guessed.get(f)
+        if lang is not None:
+            corpora.setdefault(lang, []).append(f)
+    return corpora
+
+def read_input(f):
+    with open(f, 'rb') as fp:
+        data = fp.read()
+    if not data.endswith(b'\n'):
+        data += b'\n'
+    return data
+
+# Collect the tags of FILES as lists of (line number, the tag without the
+# file name, the line number, and the "file:" field, which depends on the
+# file name) for each file.
+def collect_tags(lang, files):
+    tags = dict([(f, []) for f in files])
+    for i in range(0, len(files), 256):
+        ret = subprocess.run([CTAGS, '--quiet', '--options=NONE', '--sort=no',
+                              '--fields=+n', '--language-force=' + lang, '-o', '-']
+                             + files[i:i + 256],
+                             stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+        for l in ret.stdout.decode('utf-8', errors='replace').splitlines():
+            fields = l.split('\t')
+            if len(fields) < 2 or fields[1] not in tags:
+                continue
+            line = None
+            rest = [fields[0]]
+            for field in fields[2:]:
+                if field.startswith('line:'):
+                    line = int(field[5:])
+                elif field != 'file:':
+                    rest.append(field)
+            if line is not None:
+                tags[fields[1]].append((line, '\t'.join(rest)))
+    return tags
+
+# Split TAGS of a file made by concatenating SEGMENTS, a list of
+# (input, number of lines), to the sorted tags of each segment.
+def split_tags(tags, segments):
+    ends = []
+    total = 0
+    for (f, lines) in segments:
+        total += lines
+        ends.append(total)
+    split = [[] for s in segments]
+    for (line, tag) in tags:
+        k = bisect.bisect_left(ends, line)
+        if k < len(split):
+            split[k].append(tag)
+    return [sorted(t) for t in split]
+
+def line_count(data):
+    return data.count(b'\n')
+
+def write_check_file(check_file, inputs):
+    segments = []
+    with open(check_file, 'wb') as fp:
+        for f in inputs:
+            data = read_input(f)
+            fp.write(data)
+            segments.append((f, line_count(data)))
+    return segments
+
+# Choose the inputs that can be concatenated with others. Units has broken
+# inputs, like ones with an unterminated comment or an unbalanced brace,
+# which hide the inputs after them or change their scopes. An input is used
+# only if the tags made from each input in a concatenation are the same as
+# the ones made from the input alone.
+def concatenable_inputs(lang, files, check_dir):
+    os.makedirs(check_dir, exist_ok=True)
+    once = collect_tags(lang, files)
+    once = dict([(f, sorted([t for (l, t) in once[f]])) for f in files])
+
+    # Each input written twice
+    doubled = {}
+    for (i, f) in enumerate(files):
+        d = os.path.join(check_dir, '%d%s' % (i, os.path.splitext(f)[1]))
+        doubled[d] = (f, write_check_file(d, [f, f]))
+    twice = collect_tags(lang, list(doubled.keys()))
+    inputs = []
+    for d in doubled:
+        (f, segments) = doubled[d]
+        if len(once[f]) > 0 and split_tags(twice[d], segments) == [once[f], once[f]]:
+            inputs.append(f)
+    inputs.sort(key=files.index)
+
+    # All the inputs written twice, for checking the boundary between the
+    # repeated blocks too. The first input disagreeing and the one before
+    # it are dropped until all agree.
+    check_file = os.path.join(check_dir, 'all' + os.path.splitext(files[0])[1])
+    while len(inputs) > 0:
+        segments = write_check_file(check_file, inputs + inputs)
+        split = split_tags(collect_tags(lang, [check_file])[check_file], segments)
+        bad = [k for (k, (f, lines)) in enumerate(segments) if split[k] != once[f]]
+        if len(bad) == 0:
+            break
+        k = bad[0] % len(inputs)
+        drop = set([inputs[k], inputs[k - 1]])
+        inputs = [f for f in inputs if f not in drop]
+    return inputs
+
+def write_list(list_file, files):
+    with open(list_file, 'w') as f:
+        for l in files:
+            print(l, file=f)
+
+def make_corpus(lang, files, size, work_dir):
+    files = [f for f in files if os.path.getsize(f) > 0]
+    if len(files) == 0:
+        return None
+
+    base = os.path.join(work_dir, re.sub(r'[^A-Za-z0-9_.+-]', '_', lang))
+    inputs = concatenable_inputs(lang, files, base + '.check')
+    corpus = {'list': base + '.list'}
+    if len(inputs) > 0:
+        blob = b''.join([read_input(f) for f in inputs])
+        repeated = (size + len(blob) - 1) // len(blob)
+        corpus_file = base + '.corpus' + os.path.splitext(inputs[0])[1]
+        with open(corpus_file, 'wb') as f:
+            for i in range(repeated):
+                f.write(blob)
+        write_list(corpus['list'], [corpus_file])
+        write_list(base + '.inputs', inputs)
+        corpus.update({'concatenated': True,
+                       'inputs': len(inputs),
+                       'files': 1,
+                       'bytes': len(blob) * repeated,
+                       'inputs_list': base + '.inputs',
+                       'inputs_bytes': len(blob)})
+    else:
+        total = 0
+        listed = []
+        while total < size:
+            for f in files:
+                listed.append(f)
+                total += os.path.getsize(f)
+        write_list(corpus['list'], listed)
+        corpus.update({'concatenated': False,
+                       'inputs': len(files),
+                       'files': len(listed),
+                       'bytes': total,
+                       'inputs_list': None})
+    return corpus
+
+def run_ctags(lang, list_file):
+    cmdline = [CTAGS, '--quiet', '--options=NONE', '--sort=no', '--totals=extra',
+               '--language-force=' + lang, '-o', '-', '-L', list_file]
+    start = time.perf_counter()
+    p = subprocess.Popen(cmdline, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    err = p.stderr.read().decode('utf-8', errors='replace')
+    p.stderr.close()
+    (_, status, usage) = os.wait4(p.pid, 0)
+    seconds = time.perf_counter() - start
+    p.returncode = 0
+
+    if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+        return None
+
+    tags = allocations = rss = None
+    for l in err.splitlines():
+        m = re.match(r'^(\d+) tags? added', l)
+        if m:
+            tags = int(m.group(1))
+        m = re.match(r'^(\d+) allocations?', l)
+        if m:
+            allocations = int(m.group(1))
+        m = re.match(r'^peak RSS: (\d+) kB', l)
+        if m:
+            rss = int(m.group(1))
+
+    if rss is None:
+        # ru_maxrss includes the memory of this script before exec.
+        rss = usage.ru_maxrss
+        if sys.platform == 'darwin':
+            rss = rss // 1024   # in bytes on macOS
+    return {'seconds': seconds,
+            'cpu_seconds': usage.ru_utime + usage.ru_stime,
+            'peak_rss_kb': rss,
+            'tags': tags,
+            'allocations': allocations}
+
+def best_run(lang, list_file, repeat):
+    best = None
+    for i in range(repeat):
+        r = run_ctags(lang, list_file)
+        if r is None:
+            return None
+        if best is None:
+            best = r
+        else:
+            best['seconds'] = min(best['seconds'], r['seconds'])
+            best['cpu_seconds'] = min(best['cpu_seconds'], r['cpu_seconds'])
+            best['peak_rss_kb'] = max(best['peak_rss_kb'], r['peak_rss_kb'])
+    return best
+
+def bench(lang, corpus, repeat):
+    total = corpus['bytes']
+    best = best_run(lang, corpus['list'], repeat)
+    if best is None:
+        return None
+
+    tags = best['tags'] or 0
+    seconds = max(best['seconds'], 1e-9)
+    result = {'type': 'parser',
+              'language': lang,
+              'concatenated': corpus['concatenated'],
+              'inputs': corpus['inputs'],
+              'files': corpus['files'],
+              'bytes': total,
+              'tags': tags,
+              'seconds': round(best['seconds'], 6),
+              'cpu_seconds': round(best['cpu_seconds'], 6),
+              'mb_per_sec': round(total / (1024 * 1024) / seconds, 3),
+              'tags_per_sec': round(tags / seconds, 1),
+              'peak_rss_kb': best['peak_rss_kb'],
+              'allocations': best['allocations'],
+              'allocations_per_tag': None,
+              'per_file_us': None}
+    if best['allocations'] is not None and tags > 0:
+        result['allocations_per_tag'] = round(best['allocations'] / tags, 3)
+
+    if corpus['inputs_list'] is not None:
+        separate = best_run(lang, corpus['inputs_list'], repeat)
+        if separate is not None:
+            parsing = corpus['inputs_bytes'] * seconds / total
+            per_file = (separate['seconds'] - parsing) / corpus['inputs']
+            result['per_file_us'] = round(max(per_file, 0) * 1e6, 1)
+    return result
+
+def load_results(path):
+    results = {}
+    with open(path, 'r') as f:
+        for l in f.read().splitlines():
+            if l.strip() == '':
+                continue
+            r = json.loads(l)
+            if r.get('type') == 'parser':
+                results[r['language']] = r
+    return results
+
+def print_comparison(results, baseline, threshold):
+    print('%-20s %12s %12s %12s' % ('language', 'MB/s', 'alloc/tag', 'peak RSS'),
+          file=sys.stderr)
+    for r in results:
+        b = baseline.get(r['language'])
+        if b is None:
+            continue
+        def ratio(key):
+            if r.get(key) is None or not b.get(key):
+                return None
+            return r[key] / b[key]
+        speed = ratio('mb_per_sec')
+        allocs = ratio('allocations_per_tag')
+        rss = ratio('peak_rss_kb')
+        mark = ''
+        if speed is not None and speed < 1.0 - threshold:
+            mark = ' <= slower'
+        print('%-20s %12s %12s %12s%s'
+              % (r['language'],
+                 '-' if speed is None else '%.3fx' % speed,
+                 '-' if allocs is None else '%.3fx' % allocs,
+                 '-' if rss is None else '%.3fx' % rss,
+                 mark),
+              file=sys.stderr)
+
+def main():
+    global CTAGS
+
+    parser = argparse.ArgumentParser(
+        description='Measure the throughput of the parsers with corpora made from Units.')
+    parser.add_argument('--ctags', default=CTAGS,
+                        help='ctags executable file for testing')
+    parser.add_argument('--languages', metavar='PARSER1[,PARSER2,...]', default='',
+                        help='run only the benchmarks for the specified languages')
+    parser.add_argument('--size', type=float, default=4,
+                        help='minimum size of the corpus of a language in MiB (default: 4)')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='number of runs for each language; the best is reported (default: 3)')
+    parser.add_argument('--output', default='',
+                        help='file to write the results to (default: stdout)')
+    parser.add_argument('--compare', metavar='RESULTS', default='',
+                        help='results of an earlier run to compare with')
+    parser.add_argument('--threshold', type=float, default=0.05,
+                        help='report a slowdown greater than this ratio in comparing (default: 0.05)')
+    parser.add_argument('units_dir',
+                        help='Units directory')
+    parser.add_argument('work_dir', nargs='?', default='Bench',
+                        help='directory for the corpora (default: Bench)')
+    args = parser.parse_args()
+
+    if not hasattr(os, 'wait4'):
+        error_exit(1, 'os.wait4 is not available on this platform')
+
+    CTAGS = args.ctags
+    languages = [l for l in args.languages.split(',') if l != '']
+
+    os.makedirs(args.work_dir, exist_ok=True)
+    corpora = guess_languages(collect_inputs(args.units_dir))
+
+    out = sys.stdout
+    if args.output != '':
+        out = open(args.output, 'w')
+
+    version = subprocess.run([CTAGS, '--quiet', '--options=NONE', '--version'],
+                             stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    print(json.dumps({'type': 'environment',
+                      'ctags': version.stdout.decode('utf-8', errors='replace').splitlines()[0],
+                      'size': args.size,
+                      'repeat': args.repeat}),
+          file=out)
+
+    results = []
+    for lang in sorted(corpora.keys(), key=str.lower):
+        if len(languages) > 0 and lang not in languages:
+            continue
+        corpus = make_corpus(lang, corpora[lang], int(args.size * 1024 * 1024), args.work_dir)
+        if corpus is None:
+            continue
+        r = bench(lang, corpus, args.repeat)
+        if r is None:
+            print('%s: ctags failed' % lang, file=sys.stderr)
+            continue
+        print(json.dumps(r), file=out)
+        out.flush()
+        print('%-20s %10.2f MB/s %12.0f tags/s %8d kB %10s alloc/tag %10s us/file'
+              % (lang, r['mb_per_sec'], r['tags_per_sec'], r['peak_rss_kb'],
+                 '-' if r['allocations_per_tag'] is None else '%.2f' % r['allocations_per_tag'],
+                 '-' if r['per_file_us'] is None else '%.1f' % r['per_file_us']),
+              file=sys.stderr)
+        results.append(r)
+
+    if out is not sys.stdout:
+        out.close()
+
+    if args.compare != '':
+        print_comparison(results, load_results(args.compare), args.threshold)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -21,6 +21,7 @@
 
 #include "debug.h"
 #include "entry.h"
+#include "htable.h"
 #include "keyword.h"
 #include "parse.h"
 #include "read.h"
@@ -219,6 +220,10 @@ typedef struct sTokenInfoSQL {
 
 static langType Lang_sql;
 
+/* The names of the PL/SQL ccflags defined so far.
+ * The tags for them are released from the cork queue early. */
+static hashTable *CCFlags;
+
 typedef enum {
 	SQLTAG_PLSQL_CCFLAGS,
 	SQLTAG_DOMAIN,
@@ -723,7 +728,7 @@ static void parseIdentifier (vString *const string, const int firstChar)
 
 static bool isCCFlag(const char *str)
 {
-	return (anyKindEntryInScope(CORK_NIL, str, SQLTAG_PLSQL_CCFLAGS, false) != 0);
+	return hashTableHasItem (CCFlags, str);
 }
 
 /* Parse a PostgreSQL: dollar-quoted string
@@ -3018,7 +3023,8 @@ static void parseCCFLAGS (tokenInfo *const token)
 				!= KEYWORD_inquiry_directive)
 			{
 				int index = makeSimpleTag(ccflag, SQLTAG_PLSQL_CCFLAGS);
-				registerEntry(index);
+				if (index != CORK_NIL)
+					hashTablePutItem (CCFlags, vStringStrdup (ccflag), HT_INT_TO_PTR(1));
 				vStringClear(ccflag);
 				in_var = false;
 			}
@@ -3162,6 +3168,9 @@ static tokenType parseSqlFile (tokenInfo *const token)
 			parseLabel (token);
 		else
 			parseKeywords (token, k);
+
+		/* The tags are not updated after making them. */
+		closeTopLevelCorkScopes ();
 	} while (! isKeyword (token, KEYWORD_end) &&
 			 ! isType (token, TOKEN_EOF));
 
@@ -3179,7 +3188,10 @@ static void findSqlTags (void)
 {
 	tokenInfo *const token = newToken ();
 
+	CCFlags = hashTableNew (7, hashCstrhash, hashCstreq, eFree, NULL);
 	while (parseSqlFile (token) != TOKEN_EOF);
+	hashTableDelete (CCFlags);
+	CCFlags = NULL;
 
 	deleteToken (token);
 }
@@ -3197,6 +3209,6 @@ extern parserDefinition* SqlParser (void)
 	def->initialize = initialize;
 	def->keywordTable = SqlKeywordTable;
 	def->keywordCount = ARRAY_SIZE (SqlKeywordTable);
-	def->useCork = CORK_QUEUE | CORK_SYMTAB;
+	def->useCork = CORK_QUEUE;
 	return def;
 }
@@ -98,15 +98,22 @@ MAIN_PUBLIC_HEADS =		\
 LIB_PRIVATE_HEADS =		\
 	$(UTIL_PRIVATE_HEADS)	\
 	\
+	main/arena_p.h		\
 	main/args_p.h		\
+	main/cache_p.h		\
 	main/colprint_p.h	\
 	main/dependency_p.h	\
+	main/dirwalk_p.h	\
 	main/entry_p.h		\
 	main/error_p.h		\
 	main/field_p.h		\
 	main/flags_p.h		\
 	main/fmt_p.h		\
+	main/gitindex_p.h	\
+	main/globset_p.h	\
+	main/ignore_p.h		\
 	main/interactive_p.h	\
+	main/jobs_p.h		\
 	main/keyword_p.h	\
 	main/kind_p.h		\
 	main/lregex_p.h		\
@@ -118,6 +125,7 @@ LIB_PRIVATE_HEADS =		\
 	main/parse_p.h		\
 	main/parsers_p.h	\
 	main/portable-dirent_p.h\
+	main/profile_p.h	\
 	main/promise_p.h	\
 	main/ptag_p.h		\
 	main/read_p.h		\
@@ -125,6 +133,7 @@ LIB_PRIVATE_HEADS =		\
 	main/sort_p.h		\
 	main/stats_p.h		\
 	main/subparser_p.h	\
+	main/tagindex_p.h	\
 	main/trashbox_p.h	\
 	main/utf8_str.h		\
 	main/writer_p.h		\
@@ -143,15 +152,22 @@ LIB_HEADS =			\
 LIB_SRCS =			\
 	$(UTIL_SRCS)			\
 	\
+	main/arena.c			\
 	main/args.c			\
+	main/cache.c			\
 	main/colprint.c			\
 	main/dependency.c		\
+	main/dirwalk.c			\
 	main/entry.c			\
 	main/entry_private.c		\
 	main/error.c			\
 	main/field.c			\
 	main/flags.c			\
 	main/fmt.c			\
+	main/gitindex.c		\
+	main/globset.c		\
+	main/ignore.c		\
+	main/jobs.c			\
 	main/keyword.c			\
 	main/kind.c			\
 	main/lregex.c			\
@@ -165,6 +181,7 @@ LIB_SRCS =			\
 	main/param.c			\
 	main/parse.c			\
 	main/portable-scandir.c		\
+	main/profile.c			\
 	main/promise.c			\
 	main/ptag.c			\
 	main/rbtree.c			\
@@ -175,6 +192,7 @@ LIB_SRCS =			\
 	main/sort.c			\
 	main/stats.c			\
 	main/strlist.c			\
+	main/tagindex.c			\
 	main/trace.c			\
 	main/tokeninfo.c		\
 	main/unwindi.c			\